@@ -0,0 +1,367 @@
+#include "AsyncIO.h"
+#include <algorithm>
+#include <cerrno>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+#ifdef __linux__
+#include <cstring>
+#include <linux/io_uring.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+#ifndef ECANCELED
+#define ECANCELED 125
+#endif
+
+IORequest::IORequest(AsyncIO& io, bool write, FileHandle file, uint64_t offset, void* buffer, uint32_t size)
+	:mIO(io), mWrite(write), mFile(file), mOffset(offset), mBuffer(buffer), mSize(size)
+{
+}
+
+void IORequest::await_suspend(std::coroutine_handle<> awaiter)
+{
+	mAwaiter = awaiter;
+	mIO.submit(this);
+}
+
+AsyncIO::AsyncIO(JobSystem* jobs, IOBACKEND backend)
+	:mJobs(jobs), mBackend(backend)
+{
+#ifdef __linux__
+	if (mBackend == IO_URING && startUring())
+		return;
+#endif
+	mBackend = IO_THREADS;
+	for (uint32_t i = 0; i < ASYNCIO_THREADS; i++)
+		mThreads.emplace_back(&AsyncIO::threadLoop, this);
+}
+
+AsyncIO::~AsyncIO()
+{
+	stop();
+#ifdef __linux__
+	if (mBackend == IO_URING)
+		stopUring();
+#endif
+}
+
+IORequest AsyncIO::read(FileHandle file, uint64_t offset, void* buffer, uint32_t size)
+{
+	return IORequest(*this, false, file, offset, buffer, size);
+}
+
+IORequest AsyncIO::write(FileHandle file, uint64_t offset, const void* buffer, uint32_t size)
+{
+	return IORequest(*this, true, file, offset, const_cast<void*>(buffer), size);
+}
+
+void AsyncIO::stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		if (mStopping) return;
+		mStopping = true;
+	}
+	mWake.notify_all();
+#ifdef __linux__
+	if (mBackend == IO_URING)
+	{
+		const uint64_t wake = 1;
+		::write(mWakeFd, &wake, sizeof(wake));
+	}
+#endif
+	for (std::thread& thread : mThreads)
+		thread.join();
+	mThreads.clear();
+}
+
+IOBACKEND AsyncIO::getBackend() const
+{
+	return mBackend;
+}
+
+AsyncIOStats AsyncIO::getStats() const
+{
+	AsyncIOStats stats;
+	stats.requests = mRequests.load(std::memory_order_relaxed);
+	stats.bytes = mBytes.load(std::memory_order_relaxed);
+	stats.submissions = mSubmissions.load(std::memory_order_relaxed);
+	return stats;
+}
+
+void AsyncIO::submit(IORequest* request)
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		if (!mStopping)
+		{
+			mQueued.push_back(request);
+			request = nullptr;
+		}
+	}
+	if (request)
+	{
+		complete(request, -ECANCELED);
+		return;
+	}
+
+#ifdef __linux__
+	if (mBackend == IO_URING)
+	{
+		// wakes the I/O thread if it is waiting in the kernel, requests queued
+		// until it gets to them go in the same submission
+		const uint64_t wake = 1;
+		::write(mWakeFd, &wake, sizeof(wake));
+		return;
+	}
+#endif
+	mWake.notify_one();
+}
+
+void AsyncIO::complete(IORequest* request, int64_t result)
+{
+	request->mResult = result;
+	mRequests.fetch_add(1, std::memory_order_relaxed);
+	if (result > 0)
+		mBytes.fetch_add(static_cast<uint64_t>(result), std::memory_order_relaxed);
+
+	const std::coroutine_handle<> awaiter = request->mAwaiter;
+	if (mJobs && result != -ECANCELED)
+		mJobs->submit([awaiter] { awaiter.resume(); });
+	else
+		awaiter.resume();
+}
+
+int64_t AsyncIO::perform(IORequest* request)
+{
+	char* buffer = static_cast<char*>(request->mBuffer);
+	uint64_t offset = request->mOffset;
+	uint32_t remaining = request->mSize;
+	while (remaining > 0)
+	{
+#ifdef _WIN32
+		OVERLAPPED overlapped{};
+		overlapped.Offset = static_cast<DWORD>(offset);
+		overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+		DWORD done = 0;
+		const BOOL succeeded = request->mWrite ? WriteFile(request->mFile, buffer, remaining, &done, &overlapped) : ReadFile(request->mFile, buffer, remaining, &done, &overlapped);
+		if (!succeeded) return -static_cast<int64_t>(GetLastError());
+#else
+		const ssize_t done = request->mWrite ? pwrite(request->mFile, buffer, remaining, static_cast<off_t>(offset)) : pread(request->mFile, buffer, remaining, static_cast<off_t>(offset));
+		if (done < 0 && errno == EINTR) continue;
+		if (done < 0) return -errno;
+#endif
+		// end of file
+		if (done == 0) break;
+		buffer += done;
+		offset += done;
+		remaining -= static_cast<uint32_t>(done);
+	}
+	return request->mSize - remaining;
+}
+
+void AsyncIO::threadLoop()
+{
+	while (true)
+	{
+		IORequest* request;
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			mWake.wait(lock, [this] { return mStopping || !mQueued.empty(); });
+			if (mQueued.empty()) return;
+			request = mQueued.front();
+			mQueued.pop_front();
+		}
+		mSubmissions.fetch_add(1, std::memory_order_relaxed);
+		complete(request, perform(request));
+	}
+}
+
+#ifdef __linux__
+// the I/O thread's read of mWakeFd, told apart from requests by its user data
+constexpr uint64_t WAKEUSERDATA = 0;
+
+static int uringSetup(uint32_t entries, io_uring_params* params)
+{
+	return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+static int uringEnter(int ring, uint32_t toSubmit, uint32_t minComplete, uint32_t flags)
+{
+	return static_cast<int>(syscall(__NR_io_uring_enter, ring, toSubmit, minComplete, flags, nullptr, 0));
+}
+
+static int uringRegister(int ring, uint32_t opcode, void* argument, uint32_t count)
+{
+	return static_cast<int>(syscall(__NR_io_uring_register, ring, opcode, argument, count));
+}
+
+// ring indices are shared with the kernel
+static uint32_t loadAcquire(uint32_t* word)
+{
+	return std::atomic_ref<uint32_t>(*word).load(std::memory_order_acquire);
+}
+
+static void storeRelease(uint32_t* word, uint32_t value)
+{
+	std::atomic_ref<uint32_t>(*word).store(value, std::memory_order_release);
+}
+
+bool AsyncIO::startUring()
+{
+	io_uring_params params;
+	memset(&params, 0, sizeof(params));
+	// seccomp filters and sandboxes commonly refuse io_uring altogether
+	mRing = uringSetup(ASYNCIO_QUEUE_DEPTH, &params);
+	if (mRing < 0) return false;
+
+	// plain READ and WRITE arrived in Linux 5.6, together with probing for them
+	std::vector<char> probeMemory(sizeof(io_uring_probe) + 256 * sizeof(io_uring_probe_op), 0);
+	io_uring_probe* probe = reinterpret_cast<io_uring_probe*>(probeMemory.data());
+	const bool supported = uringRegister(mRing, IORING_REGISTER_PROBE, probe, 256) >= 0
+		&& probe->last_op >= IORING_OP_WRITE
+		&& (probe->ops[IORING_OP_READ].flags & IO_URING_OP_SUPPORTED)
+		&& (probe->ops[IORING_OP_WRITE].flags & IO_URING_OP_SUPPORTED);
+
+	mRingEntries = params.sq_entries;
+	mSubmitRingSize = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+	mCompleteRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+	mEntriesSize = params.sq_entries * sizeof(io_uring_sqe);
+	if (params.features & IORING_FEAT_SINGLE_MMAP)
+		mSubmitRingSize = mCompleteRingSize = std::max(mSubmitRingSize, mCompleteRingSize);
+
+	mSubmitRing = mmap(nullptr, mSubmitRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, mRing, IORING_OFF_SQ_RING);
+	mCompleteRing = params.features & IORING_FEAT_SINGLE_MMAP ? mSubmitRing
+		: mmap(nullptr, mCompleteRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, mRing, IORING_OFF_CQ_RING);
+	mEntries = mmap(nullptr, mEntriesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, mRing, IORING_OFF_SQES);
+	mWakeFd = eventfd(0, EFD_CLOEXEC);
+
+	if (!supported || mSubmitRing == MAP_FAILED || mCompleteRing == MAP_FAILED || mEntries == MAP_FAILED || mWakeFd < 0)
+	{
+		stopUring();
+		return false;
+	}
+
+	char* submitRing = static_cast<char*>(mSubmitRing);
+	char* completeRing = static_cast<char*>(mCompleteRing);
+	mSubmitHead = reinterpret_cast<uint32_t*>(submitRing + params.sq_off.head);
+	mSubmitTail = reinterpret_cast<uint32_t*>(submitRing + params.sq_off.tail);
+	mSubmitMask = *reinterpret_cast<uint32_t*>(submitRing + params.sq_off.ring_mask);
+	mCompleteHead = reinterpret_cast<uint32_t*>(completeRing + params.cq_off.head);
+	mCompleteTail = reinterpret_cast<uint32_t*>(completeRing + params.cq_off.tail);
+	mCompleteMask = *reinterpret_cast<uint32_t*>(completeRing + params.cq_off.ring_mask);
+	mCompletions = completeRing + params.cq_off.cqes;
+
+	// the submission ring's array always maps slot i to entry i
+	uint32_t* slots = reinterpret_cast<uint32_t*>(submitRing + params.sq_off.array);
+	for (uint32_t i = 0; i < mRingEntries; i++)
+		slots[i] = i;
+
+	mThreads.emplace_back(&AsyncIO::uringLoop, this);
+	return true;
+}
+
+void AsyncIO::uringLoop()
+{
+	io_uring_sqe* entries = static_cast<io_uring_sqe*>(mEntries);
+	const io_uring_cqe* completions = static_cast<const io_uring_cqe*>(mCompletions);
+	bool wakeArmed = false;
+	std::vector<std::pair<uint64_t, int32_t>> reaped;
+
+	while (true)
+	{
+		uint32_t tail = *mSubmitTail;
+		auto push = [&](uint8_t opcode, int file, uint64_t offset, void* buffer, uint32_t size, uint64_t userData)
+		{
+			io_uring_sqe& entry = entries[tail & mSubmitMask];
+			memset(&entry, 0, sizeof(entry));
+			entry.opcode = opcode;
+			entry.fd = file;
+			entry.off = offset;
+			entry.addr = reinterpret_cast<uint64_t>(buffer);
+			entry.len = size;
+			entry.user_data = userData;
+			tail++;
+		};
+
+		if (!wakeArmed)
+		{
+			push(IORING_OP_READ, mWakeFd, 0, &mWakeValue, sizeof(mWakeValue), WAKEUSERDATA);
+			wakeArmed = true;
+		}
+		{
+			// one entry stays free for the wake read
+			std::lock_guard<std::mutex> lock(mMutex);
+			while (!mQueued.empty() && mInFlight + 1 < mRingEntries)
+			{
+				IORequest* request = mQueued.front();
+				mQueued.pop_front();
+				push(request->mWrite ? IORING_OP_WRITE : IORING_OP_READ, request->mFile, request->mOffset + request->mDone,
+					static_cast<char*>(request->mBuffer) + request->mDone, request->mSize - request->mDone, reinterpret_cast<uint64_t>(request));
+				mInFlight++;
+			}
+			if (mStopping && mQueued.empty() && mInFlight == 0) break;
+		}
+		storeRelease(mSubmitTail, tail);
+
+		// everything the kernel has not taken yet, including what a failed call left behind
+		const uint32_t toSubmit = tail - loadAcquire(mSubmitHead);
+		if (uringEnter(mRing, toSubmit, 1, IORING_ENTER_GETEVENTS) >= 0 && toSubmit > 0)
+			mSubmissions.fetch_add(1, std::memory_order_relaxed);
+
+		// completions are copied out and the ring released before resuming anyone,
+		// resumed coroutines may queue more requests straight away
+		reaped.clear();
+		uint32_t head = *mCompleteHead;
+		const uint32_t completeTail = loadAcquire(mCompleteTail);
+		for (; head != completeTail; head++)
+		{
+			const io_uring_cqe& completion = completions[head & mCompleteMask];
+			reaped.emplace_back(completion.user_data, completion.res);
+		}
+		storeRelease(mCompleteHead, head);
+
+		for (const auto& [userData, result] : reaped)
+		{
+			if (userData == WAKEUSERDATA)
+			{
+				wakeArmed = false;
+				continue;
+			}
+			IORequest* request = reinterpret_cast<IORequest*>(userData);
+			// a short transfer goes again for the rest, as perform does, up to the end of the file
+			const bool partial = result > 0 && request->mDone + static_cast<uint32_t>(result) < request->mSize;
+			if (result > 0)
+				request->mDone += static_cast<uint32_t>(result);
+			{
+				std::lock_guard<std::mutex> lock(mMutex);
+				mInFlight--;
+				if (partial || result == -EINTR)
+				{
+					mQueued.push_front(request);
+					continue;
+				}
+			}
+			complete(request, result < 0 ? result : request->mDone);
+		}
+	}
+}
+
+void AsyncIO::stopUring()
+{
+	if (mEntries && mEntries != MAP_FAILED) munmap(mEntries, mEntriesSize);
+	if (mCompleteRing && mCompleteRing != MAP_FAILED && mCompleteRing != mSubmitRing) munmap(mCompleteRing, mCompleteRingSize);
+	if (mSubmitRing && mSubmitRing != MAP_FAILED) munmap(mSubmitRing, mSubmitRingSize);
+	if (mWakeFd >= 0) close(mWakeFd);
+	if (mRing >= 0) close(mRing);
+	mEntries = mCompleteRing = mSubmitRing = nullptr;
+	mWakeFd = mRing = -1;
+}
+#endif
\ No newline at end of file
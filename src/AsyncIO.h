@@ -0,0 +1,142 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <coroutine>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "JobSystem.h"
+
+#ifdef _WIN32
+using FileHandle = void*;
+#else
+using FileHandle = int;
+#endif
+
+// requests handed to the kernel at once, more wait in the AsyncIO's queue
+constexpr uint32_t ASYNCIO_QUEUE_DEPTH = 64;
+// threads doing blocking reads and writes where io_uring is not available
+constexpr uint32_t ASYNCIO_THREADS = 4;
+
+enum IOBACKEND {
+	IO_URING,  // Linux: one thread submits batches of requests to the kernel and reaps them
+	IO_THREADS // blocking positioned reads and writes on a few threads of their own
+};
+
+struct AsyncIOStats
+{
+	uint64_t requests = 0;
+	uint64_t bytes = 0;
+	// system calls that handed requests over, fewer than requests when they were batched
+	uint64_t submissions = 0;
+};
+
+class AsyncIO;
+
+// co_await on it suspends until the request completes, and yields the bytes
+// transferred or a negative errno
+class IORequest
+{
+public:
+	bool await_ready() const noexcept
+	{
+		return false;
+	}
+
+	void await_suspend(std::coroutine_handle<> awaiter);
+
+	int64_t await_resume() const noexcept
+	{
+		return mResult;
+	}
+private:
+	friend class AsyncIO;
+
+	IORequest(AsyncIO& io, bool write, FileHandle file, uint64_t offset, void* buffer, uint32_t size);
+private:
+	AsyncIO& mIO;
+	bool mWrite;
+	FileHandle mFile;
+	uint64_t mOffset;
+	void* mBuffer;
+	uint32_t mSize;
+	// transferred so far, io_uring may complete a request in several parts
+	uint32_t mDone = 0;
+	int64_t mResult = 0;
+	std::coroutine_handle<> mAwaiter;
+};
+
+// Positioned file reads and writes for coroutines, so neither the render thread nor
+// the workers block on the disk. Many requests are in flight at once: on io_uring
+// everything queued since the last system call is submitted in one. Awaiters resume
+// on a job system worker when given one, otherwise on the I/O thread that completed
+// them. The buffer has to stay valid until then. Thread-safe.
+class AsyncIO
+{
+public:
+	// falls back to IO_THREADS when io_uring is asked for and not available
+	AsyncIO(JobSystem* jobs = nullptr, IOBACKEND backend = IO_URING);
+	~AsyncIO();
+
+	AsyncIO(const AsyncIO&) = delete;
+	AsyncIO& operator=(const AsyncIO&) = delete;
+
+	IORequest read(FileHandle file, uint64_t offset, void* buffer, uint32_t size);
+	IORequest write(FileHandle file, uint64_t offset, const void* buffer, uint32_t size);
+	// waits for the queued requests, those made afterwards fail with -ECANCELED
+	void stop();
+
+	IOBACKEND getBackend() const;
+	AsyncIOStats getStats() const;
+private:
+	friend class IORequest;
+
+	void submit(IORequest* request);
+	void complete(IORequest* request, int64_t result);
+	static int64_t perform(IORequest* request);
+	void threadLoop();
+#ifdef __linux__
+	bool startUring();
+	void uringLoop();
+	void stopUring();
+#endif
+private:
+	JobSystem* mJobs;
+	IOBACKEND mBackend;
+
+	std::mutex mMutex;
+	std::condition_variable mWake;
+	std::deque<IORequest*> mQueued;
+	uint32_t mInFlight = 0;
+	bool mStopping = false;
+	std::vector<std::thread> mThreads;
+
+	std::atomic<uint64_t> mRequests{ 0 };
+	std::atomic<uint64_t> mBytes{ 0 };
+	std::atomic<uint64_t> mSubmissions{ 0 };
+
+#ifdef __linux__
+	// the io_uring and its rings mapped from the kernel, the thread wakes on mWakeFd
+	int mRing = -1;
+	int mWakeFd = -1;
+	uint64_t mWakeValue = 0;
+	void* mSubmitRing = nullptr;
+	size_t mSubmitRingSize = 0;
+	void* mCompleteRing = nullptr;
+	size_t mCompleteRingSize = 0;
+	void* mEntries = nullptr;
+	size_t mEntriesSize = 0;
+	uint32_t mRingEntries = 0;
+	// inside the rings: the submission head the kernel advances and the tail we do, the
+	// completion head we advance and the tail the kernel does
+	uint32_t* mSubmitHead = nullptr;
+	uint32_t* mSubmitTail = nullptr;
+	uint32_t mSubmitMask = 0;
+	uint32_t* mCompleteHead = nullptr;
+	uint32_t* mCompleteTail = nullptr;
+	uint32_t mCompleteMask = 0;
+	void* mCompletions = nullptr;
+#endif
+};
\ No newline at end of file
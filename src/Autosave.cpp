@@ -0,0 +1,216 @@
+#include "Autosave.h"
+#include "ChunkCodec.h"
+#include <exception>
+#include <iomanip>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+static uint64_t packPosition(glm::ivec2 position)
+{
+	return static_cast<uint64_t>(static_cast<uint32_t>(position.x)) << 32 | static_cast<uint32_t>(position.y);
+}
+
+Autosave::Autosave(RegionStorage& storage, JobSystem& jobs)
+	:mStorage(storage), mJobs(jobs), mLastSave(std::chrono::steady_clock::now())
+{
+	mThread = std::thread(&Autosave::threadLoop, this);
+}
+
+Autosave::~Autosave()
+{
+	stop();
+}
+
+bool Autosave::isDue()
+{
+	const auto now = std::chrono::steady_clock::now();
+	if (std::chrono::duration<float>(now - mLastSave).count() < AUTOSAVE_INTERVAL) return false;
+	mLastSave = now;
+	return true;
+}
+
+void Autosave::save(glm::ivec2 position, const ChunkData& data)
+{
+	std::shared_ptr<ChunkData> snapshot = std::make_shared<ChunkData>();
+	snapshot->share(data);
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mPending[packPosition(position)] = snapshot;
+		mQueued.push_back({ position, std::move(snapshot), nullptr });
+		mOutstanding++;
+		mSnapshots++;
+	}
+	mWake.notify_one();
+}
+
+bool Autosave::restore(glm::ivec2 position, ChunkData& data) const
+{
+	std::shared_ptr<ChunkData> snapshot;
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		auto it = mPending.find(packPosition(position));
+		if (it == mPending.end()) return false;
+		snapshot = it->second;
+	}
+	data.share(*snapshot);
+	return true;
+}
+
+void Autosave::checkpoint(std::function<void()> saved)
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mQueued.push_back({ glm::ivec2(0), nullptr, std::move(saved) });
+		mOutstanding++;
+	}
+	mWake.notify_one();
+}
+
+bool Autosave::isSaving() const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mOutstanding > 0;
+}
+
+void Autosave::stop()
+{
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+		mIdle.wait(lock, [this] { return mOutstanding == 0; });
+		mStopping = true;
+	}
+	mWake.notify_one();
+	if (mThread.joinable())
+		mThread.join();
+}
+
+AutosaveStats Autosave::getStats() const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	AutosaveStats stats;
+	stats.snapshots = mSnapshots;
+	stats.chunksWritten = mChunksWritten;
+	stats.encodeMs = mEncodeNs / 1e6;
+	stats.copiesOnWrite = ChunkSection::getCopyOnWriteCount();
+	return stats;
+}
+
+void Autosave::reportStats(std::ostream& out) const
+{
+	const AutosaveStats stats = getStats();
+	out << "Autosave: " << stats.snapshots << " snapshots, " << stats.chunksWritten << " chunks written, " << std::fixed << std::setprecision(3)
+		<< (stats.chunksWritten ? stats.encodeMs / stats.chunksWritten : 0.0) << " ms encoding per chunk off the render thread, "
+		<< stats.copiesOnWrite << " sections copied on write" << std::endl;
+}
+
+void Autosave::threadLoop()
+{
+	// waking up to a snapshot must not preempt the render thread, on Linux batch
+	// threads still get their share of a busy core but never preempt on wakeup
+#ifdef _WIN32
+	SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_BELOW_NORMAL);
+#elif defined(__linux__)
+	sched_param param{};
+	pthread_setschedparam(pthread_self(), SCHED_BATCH, &param);
+#endif
+
+	while (true)
+	{
+		Snapshot snapshot;
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			mWake.wait(lock, [this] { return mStopping || !mQueued.empty(); });
+			if (mQueued.empty()) return;
+			snapshot = std::move(mQueued.front());
+			mQueued.pop_front();
+			if (snapshot.data) mWriting++;
+		}
+
+		if (!snapshot.data)
+		{
+			finishCheckpoint(snapshot.saved);
+			continue;
+		}
+
+		const auto start = std::chrono::steady_clock::now();
+		std::vector<uint8_t> bytes;
+		encodeChunk(*snapshot.data, bytes);
+		const uint64_t encodeNs = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mEncodeNs += encodeNs;
+		}
+
+		write(snapshot.position, std::move(snapshot.data), std::move(bytes));
+	}
+}
+
+DetachedTask Autosave::write(glm::ivec2 position, std::shared_ptr<ChunkData> data, std::vector<uint8_t> bytes)
+{
+	std::exception_ptr error;
+	try
+	{
+		co_await mStorage.writeEncoded<WorldDimensions>(position, std::move(bytes));
+	}
+	catch (...)
+	{
+		error = std::current_exception();
+	}
+	if (error)
+		mJobs.complete([error] { std::rethrow_exception(error); });
+
+	// only the newest snapshot of the chunk is left for restore, and only until it is on
+	// disk. data still holds it, so its sections are released outside the lock
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		auto it = mPending.find(packPosition(position));
+		if (it != mPending.end() && it->second == data)
+			mPending.erase(it);
+		if (!error) mChunksWritten++;
+		mWriteFailed |= error != nullptr;
+		mWriting--;
+		mOutstanding--;
+		// notified under the lock, stop may destroy us as soon as it sees zero
+		mIdle.notify_all();
+	}
+}
+
+void Autosave::finishCheckpoint(const std::function<void()>& saved)
+{
+	// the snapshots queued before it are all encoded, wait for their writes
+	bool failed;
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+		mIdle.wait(lock, [this] { return mWriting == 0; });
+		failed = mWriteFailed;
+		mWriteFailed = false;
+	}
+
+	// the failed write's error is on its way already, and what saved would let go of
+	// may be the only copy of that chunk's changes
+	if (!failed)
+	{
+		std::exception_ptr error;
+		try
+		{
+			mStorage.sync();
+			saved();
+		}
+		catch (...)
+		{
+			error = std::current_exception();
+		}
+		if (error)
+			mJobs.complete([error] { std::rethrow_exception(error); });
+	}
+
+	std::lock_guard<std::mutex> lock(mMutex);
+	mOutstanding--;
+	mIdle.notify_all();
+}
\ No newline at end of file
@@ -0,0 +1,99 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <glm/glm.hpp>
+#include "World.h"
+#include "RegionFile.h"
+#include "JobSystem.h"
+#include "Task.h"
+
+// seconds between autosaves of the chunks changed since the last one
+constexpr float AUTOSAVE_INTERVAL = 30.0f;
+
+struct AutosaveStats
+{
+	uint64_t snapshots = 0;
+	uint64_t chunksWritten = 0;
+	// time the autosave thread spent encoding, in milliseconds
+	double encodeMs = 0.0;
+	// shared section storage the render thread had to copy to change it
+	uint64_t copiesOnWrite = 0;
+};
+
+// Saves chunks in the background. save only takes a copy-on-write snapshot of the
+// chunk, its sections stay shared until the chunk is changed, so the caller pays
+// for a copy only when it edits a section that is still being saved. A thread of
+// its own encodes the snapshots and writes them through the storage's AsyncIO.
+// Render thread only, except where noted.
+class Autosave
+{
+public:
+	Autosave(RegionStorage& storage, JobSystem& jobs);
+	~Autosave();
+
+	Autosave(const Autosave&) = delete;
+	Autosave& operator=(const Autosave&) = delete;
+
+	// whether AUTOSAVE_INTERVAL has passed since the last time it returned true
+	bool isDue();
+	// snapshots data to be written in the background, errors come through the job
+	// system's completions
+	void save(glm::ivec2 position, const ChunkData& data);
+	// shares the newest snapshot of position into data while it has not been written
+	// yet, so a chunk loaded again meanwhile does not read an older copy from disk
+	bool restore(glm::ivec2 position, ChunkData& data) const;
+	// calls saved on the autosave thread once every snapshot taken before is written
+	// and synced to the disk, unless one of them failed to save
+	void checkpoint(std::function<void()> saved);
+	// snapshots waiting or being written
+	bool isSaving() const;
+	// waits until every snapshot is written and ends the thread, call before the
+	// storage's AsyncIO stops
+	void stop();
+
+	AutosaveStats getStats() const;
+	void reportStats(std::ostream& out) const;
+private:
+	// a checkpoint when data is nullptr
+	struct Snapshot
+	{
+		glm::ivec2 position;
+		std::shared_ptr<ChunkData> data;
+		std::function<void()> saved;
+	};
+
+	void threadLoop();
+	void finishCheckpoint(const std::function<void()>& saved);
+	DetachedTask write(glm::ivec2 position, std::shared_ptr<ChunkData> data, std::vector<uint8_t> bytes);
+private:
+	RegionStorage& mStorage;
+	JobSystem& mJobs;
+	std::chrono::steady_clock::time_point mLastSave;
+
+	mutable std::mutex mMutex;
+	std::condition_variable mWake; // the thread waits for snapshots
+	std::condition_variable mIdle; // stop waits for the writes
+	std::deque<Snapshot> mQueued;
+	// newest snapshot of each chunk until it is written, keyed by packed position
+	std::unordered_map<uint64_t, std::shared_ptr<ChunkData>> mPending;
+	// snapshots and checkpoints queued, encoding or writing
+	uint32_t mOutstanding = 0;
+	// writes in flight, and whether one failed since the last checkpoint
+	uint32_t mWriting = 0;
+	bool mWriteFailed = false;
+	bool mStopping = false;
+	std::thread mThread;
+
+	uint64_t mSnapshots = 0;
+	uint64_t mChunksWritten = 0;
+	uint64_t mEncodeNs = 0;
+};
\ No newline at end of file
@@ -0,0 +1,1323 @@
+#include "Benchmarks.h"
+#include "World.h"
+#include "Mesher.h"
+#include "Noise.h"
+#include "WorldGenerator.h"
+#include "ChunkCodec.h"
+#include "RegionFile.h"
+#include "AsyncIO.h"
+#include "Autosave.h"
+#include "EditLog.h"
+#include "ChunkCache.h"
+#include "JobSystem.h"
+#include "Task.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bitset>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// enough sections that the packed set spills out of L2 like a loaded world does
+constexpr int BENCHMARK_SECTIONS = 1024;
+constexpr int BENCHMARK_REPEATS = 5;
+constexpr int BENCHMARK_RANDOM_READS = 1 << 20;
+// chunks generated and meshed per shape, in a square along x and z
+constexpr int BENCHMARK_CHUNK_GRID = 8;
+constexpr int BENCHMARK_CHUNKS = BENCHMARK_CHUNK_GRID * BENCHMARK_CHUNK_GRID;
+// with the GENERATION_MARGIN ring the benchmarked chunks need to complete generation
+constexpr int BENCHMARK_GENERATED_GRID = BENCHMARK_CHUNK_GRID + 2 * GENERATION_MARGIN;
+constexpr uint32_t BENCHMARK_SEED = 1;
+// 2D grids are heightmaps, 3D ones density fields
+constexpr int BENCHMARK_NOISE_GRIDS = 64;
+// simulated frames per autosave benchmark, every chunk is saved every BENCHMARK_SAVE_FRAMES
+constexpr int BENCHMARK_FRAMES = 600;
+constexpr int BENCHMARK_SAVE_FRAMES = 100;
+// block edits per simulated frame, in random chunks
+constexpr int BENCHMARK_FRAME_EDITS = 32;
+// after each frame's work, standing in for the wait on the GPU where other threads get to run
+constexpr int BENCHMARK_FRAME_IDLE_US = 2000;
+// edits appended back to back per edit log run, fewer when every edit is synced on its own
+constexpr int BENCHMARK_LOG_EDITS = 1 << 20;
+constexpr int BENCHMARK_LOG_SYNCED_EDITS = 1 << 11;
+// edits the log holds when the simulated crash hits, one recovery run each
+constexpr std::array<int, 3> BENCHMARK_RECOVERY_EDITS = { 1 << 14, 1 << 17, 1 << 20 };
+// random block edits per chunk between two remeshes, one run each
+constexpr std::array<int, 4> BENCHMARK_REMESH_EDITS = { 1, 4, 16, 64 };
+// threads meshing published chunk versions while the frame thread edits, one run each
+constexpr std::array<int, 6> BENCHMARK_VERSION_READERS = { 0, 1, 2, 4, 8, 16 };
+// render distances whose square of chunks is generated and deduplicated, one run each
+constexpr std::array<int, 3> BENCHMARK_DEDUP_DISTANCES = { 8, 16, 32 };
+// the cache benchmark's loaded square reaches this far from the camera, which moves
+// this many chunks along x and back again BENCHMARK_CACHE_SWEEPS times
+constexpr int BENCHMARK_CACHE_DISTANCE = 8;
+constexpr int BENCHMARK_CACHE_TRAVEL = 16;
+constexpr int BENCHMARK_CACHE_SWEEPS = 4;
+// cache budgets in KiB, one run each
+constexpr std::array<int, 5> BENCHMARK_CACHE_BUDGETS = { 0, 64, 128, 256, 512 };
+
+// stone with a rolling dirt and grass surface, caves and ore, so sections hold a mix of palette sizes
+static uint8_t getBenchmarkBlock(int section, int x, int y, int z)
+{
+	const uint32_t hash = (section * 73856093u) ^ (x * 19349663u) ^ (y * 83492791u) ^ (z * 2654435761u);
+	const int surface = 8 + (section * 5 + x / 3 + z / 4) % 8;
+	if (y > surface) return AIR;
+	if (y == surface) return GRASS;
+	if (y > surface - 3) return DIRT;
+	if (hash % 23 == 0) return AIR;
+	return hash % 61 == 0 ? DIRT : STONE;
+}
+
+// best of BENCHMARK_REPEATS, in nanoseconds per voxel visited
+static double timeRun(uint64_t voxels, const std::function<uint64_t()>& run, uint64_t& checksum)
+{
+	double best = 1e30;
+	for (int repeat = 0; repeat < BENCHMARK_REPEATS; repeat++)
+	{
+		const auto start = std::chrono::steady_clock::now();
+		checksum += run();
+		const double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+		best = std::min(best, ns / voxels);
+	}
+	return best;
+}
+
+template<typename Layout>
+static void benchmarkLayout(std::ostream& out, const char* name, uint64_t& checksum)
+{
+	using Section = BasicChunkSection<Layout>;
+	constexpr uint64_t VOXELS = static_cast<uint64_t>(BENCHMARK_SECTIONS) * SECTIONVOLUME;
+
+	std::vector<uint8_t> raw(VOXELS);
+	std::unique_ptr<Section[]> sections = std::make_unique<Section[]>(BENCHMARK_SECTIONS);
+
+	// terrain generation: every voxel written in layout order, then packed
+	const double fill = timeRun(VOXELS, [&]
+	{
+		for (int s = 0; s < BENCHMARK_SECTIONS; s++)
+		{
+			uint8_t* voxels = &raw[static_cast<size_t>(s) * SECTIONVOLUME];
+			for (int x = 0; x < SECTIONSIZE; x++)
+				for (int y = 0; y < SECTIONSIZE; y++)
+					for (int z = 0; z < SECTIONSIZE; z++)
+						voxels[Layout::index(x, y, z)] = getBenchmarkBlock(s, x, y, z);
+			sections[s].assign(voxels);
+		}
+		return static_cast<uint64_t>(sections[BENCHMARK_SECTIONS - 1].getPaletteSize());
+	}, checksum);
+
+	// mesher input: rows along z, as PaddedChunk copies them
+	const double rows = timeRun(VOXELS, [&]
+	{
+		uint64_t sum = 0;
+		uint8_t row[SECTIONSIZE];
+		for (int s = 0; s < BENCHMARK_SECTIONS; s++)
+			for (int x = 0; x < SECTIONSIZE; x++)
+				for (int y = 0; y < SECTIONSIZE; y++)
+				{
+					sections[s].getRow(x, y, row);
+					for (uint8_t block : row) sum += block;
+				}
+		return sum;
+	}, checksum);
+
+	// heightmaps, skylight and column masks: columns along y
+	const double columns = timeRun(VOXELS, [&]
+	{
+		uint64_t sum = 0;
+		uint8_t column[SECTIONSIZE];
+		for (int s = 0; s < BENCHMARK_SECTIONS; s++)
+			for (int x = 0; x < SECTIONSIZE; x++)
+				for (int z = 0; z < SECTIONSIZE; z++)
+				{
+					sections[s].getColumn(x, z, column);
+					for (uint8_t block : column) sum += block;
+				}
+		return sum;
+	}, checksum);
+
+	// light propagation and flood fills: the six neighbours of every inner voxel
+	auto stencil = [&](auto&& get)
+	{
+		uint64_t sum = 0;
+		for (int s = 0; s < BENCHMARK_SECTIONS; s++)
+			for (int x = 1; x < SECTIONSIZE - 1; x++)
+				for (int y = 1; y < SECTIONSIZE - 1; y++)
+					for (int z = 1; z < SECTIONSIZE - 1; z++)
+						sum += get(s, x - 1, y, z) + get(s, x + 1, y, z) + get(s, x, y - 1, z)
+							+ get(s, x, y + 1, z) + get(s, x, y, z - 1) + get(s, x, y, z + 1);
+		return sum;
+	};
+	constexpr uint64_t INNER = static_cast<uint64_t>(BENCHMARK_SECTIONS) * (SECTIONSIZE - 2) * (SECTIONSIZE - 2) * (SECTIONSIZE - 2);
+	const double packedStencil = timeRun(INNER, [&]
+	{
+		return stencil([&](int s, int x, int y, int z) { return sections[s].getBlock(x, y, z); });
+	}, checksum);
+	const double rawStencil = timeRun(INNER, [&]
+	{
+		return stencil([&](int s, int x, int y, int z) { return raw[static_cast<size_t>(s) * SECTIONVOLUME + Layout::index(x, y, z)]; });
+	}, checksum);
+
+	// picking, collision and block updates: scattered single lookups
+	std::mt19937 rng(1234);
+	std::vector<uint32_t> lookups(BENCHMARK_RANDOM_READS);
+	for (uint32_t& lookup : lookups)
+		lookup = rng() % BENCHMARK_SECTIONS << 12 | rng() % SECTIONVOLUME;
+	const double random = timeRun(BENCHMARK_RANDOM_READS, [&]
+	{
+		uint64_t sum = 0;
+		for (uint32_t lookup : lookups)
+		{
+			const uint32_t v = lookup & (SECTIONVOLUME - 1);
+			sum += sections[lookup >> 12].getBlock(v >> 8, v >> 4 & 15, v & 15);
+		}
+		return sum;
+	}, checksum);
+
+	// the layout World.h currently uses is starred
+	const std::string label = std::string(name) + (std::is_same_v<Layout, SectionLayout> ? "*" : "");
+	out << std::left << std::setw(8) << label << std::right << std::fixed << std::setprecision(2)
+		<< std::setw(8) << fill << std::setw(8) << rows << std::setw(8) << columns
+		<< std::setw(10) << packedStencil << std::setw(10) << rawStencil << std::setw(8) << random << "\n";
+}
+
+void runLayoutBenchmarks(std::ostream& out)
+{
+	static_assert(SECTIONVOLUME == 1 << 12, "lookups pack the voxel into 12 bits");
+
+	out << BENCHMARK_SECTIONS << " sections, best of " << BENCHMARK_REPEATS << ", ns per voxel\n";
+	out << std::left << std::setw(8) << "layout" << std::right << std::setw(8) << "fill" << std::setw(8) << "rows"
+		<< std::setw(8) << "columns" << std::setw(10) << "stencil" << std::setw(10) << "raw sten" << std::setw(8) << "random" << "\n";
+
+	uint64_t checksum = 0;
+	benchmarkLayout<LinearLayout<SECTIONSIZE>>(out, "linear", checksum);
+	benchmarkLayout<ColumnLayout<SECTIONSIZE>>(out, "column", checksum);
+	benchmarkLayout<MortonLayout<SECTIONSIZE>>(out, "morton", checksum);
+	out << "checksum " << checksum << std::endl;
+}
+
+// runs every stage on a square of chunks, BENCHMARK_GENERATED_GRID unless given, indexed
+// x * grid + z, where the ring only runs the stages its neighbours read. Every chunk
+// completes a stage before any runs the next, as the ChunkManager guarantees for neighbours
+template<typename Dims>
+static void generateBenchmarkChunks(const WorldGenerator& generator, BasicChunkData<Dims>* chunks, int grid = BENCHMARK_GENERATED_GRID)
+{
+	const int GRID = grid;
+	int ringStages = 0;
+	for (const GenerationStageInfo& info : GENERATIONSTAGEINFO)
+		if (info.neighbourRadius > 0)
+			ringStages = std::max(ringStages, info.neighbourStages);
+
+	for (int stage = 0; stage < GENERATIONSTAGES; stage++)
+	{
+		const int radius = GENERATIONSTAGEINFO[stage].neighbourRadius;
+		for (int x = 0; x < GRID; x++)
+		{
+			for (int z = 0; z < GRID; z++)
+			{
+				const bool inner = x >= GENERATION_MARGIN && x < GRID - GENERATION_MARGIN && z >= GENERATION_MARGIN && z < GRID - GENERATION_MARGIN;
+				if (!inner && stage >= ringStages) continue;
+
+				GenerationNeighbours<Dims> neighbours{};
+				for (int dx = -radius; dx <= radius; dx++)
+					for (int dz = -radius; dz <= radius; dz++)
+						neighbours[getGenerationNeighbourIndex(dx, dz)] = &chunks[(x + dx) * GRID + z + dz];
+
+				const glm::ivec2 position(x - GENERATION_MARGIN, z - GENERATION_MARGIN);
+				generator.runStage(static_cast<GENERATIONSTAGE>(stage), position, chunks[x * GRID + z], neighbours);
+			}
+		}
+	}
+}
+
+template<typename Dims>
+static void benchmarkDimensions(std::ostream& out, const WorldGenerator& generator, uint64_t& checksum)
+{
+	constexpr double COLUMNS = static_cast<double>(Dims::SIZE) * Dims::SIZE;
+	constexpr int GRID = BENCHMARK_GENERATED_GRID;
+
+	std::unique_ptr<BasicChunkData<Dims>[]> chunks = std::make_unique<BasicChunkData<Dims>[]>(GRID * GRID);
+	auto chunkAt = [&](int x, int z) -> BasicChunkData<Dims>&
+	{
+		return chunks[x * GRID + z];
+	};
+
+	// includes the ring's share of the work
+	const double generate = timeRun(BENCHMARK_CHUNKS, [&]
+	{
+		generateBenchmarkChunks(generator, chunks.get());
+		return static_cast<uint64_t>(chunkAt(GENERATION_MARGIN, GENERATION_MARGIN).getSurface(0, 0));
+	}, checksum);
+
+	// each chunk meshed with its four generated neighbours
+	MeshScratch<Dims>& scratch = MeshScratch<Dims>::get();
+	uint64_t quads = 0;
+	size_t memory = 0;
+	const double mesh = timeRun(BENCHMARK_CHUNKS, [&]
+	{
+		quads = 0;
+		memory = 0;
+		for (int x = GENERATION_MARGIN; x < GRID - GENERATION_MARGIN; x++)
+		{
+			for (int z = GENERATION_MARGIN; z < GRID - GENERATION_MARGIN; z++)
+			{
+				const std::array<const BasicChunkData<Dims>*, BORDERMESHES> neighbours = {
+					&chunkAt(x, z - 1), // FRONT
+					&chunkAt(x, z + 1), // BACK
+					&chunkAt(x + 1, z), // RIGHT
+					&chunkAt(x - 1, z), // LEFT
+				};
+
+				for (int band = 0; band < BANDCOUNT<Dims>; band++)
+					scratch.bands[band].fill(chunkAt(x, z), neighbours, band);
+				scratch.mesher.prepare();
+				// section by section, as BasicChunk does
+				for (int region = 0; region < MESHREGIONS; region++)
+					for (int section = 0; section < Dims::SECTIONCOUNT; section++)
+						if (ChunkMesher<Dims>::regionHasSection(region, section))
+							quads += scratch.mesher.buildMesh(GREEDY, region, section, scratch.vertices.data()).quadCount;
+				memory += chunkAt(x, z).getMemoryUsage();
+			}
+		}
+		return quads;
+	}, checksum);
+
+	const std::string name = std::to_string(Dims::SIZE) + "x" + std::to_string(Dims::HEIGHT) + (std::is_same_v<Dims, WorldDimensions> ? "*" : "");
+	out << std::left << std::setw(8) << name << std::right << std::fixed << std::setprecision(1)
+		<< std::setw(10) << generate / 1000 << std::setw(10) << mesh / 1000
+		<< std::setw(10) << generate / COLUMNS << std::setw(10) << mesh / COLUMNS
+		<< std::setw(10) << memory / BENCHMARK_CHUNKS / COLUMNS
+		<< std::setw(8) << quads / BENCHMARK_CHUNKS << "\n";
+}
+
+void runChunkDimensionBenchmarks(std::ostream& out)
+{
+	out << BENCHMARK_CHUNKS << " generated chunks, best of " << BENCHMARK_REPEATS << ", per chunk and per block column\n";
+	out << std::left << std::setw(8) << "shape" << std::right << std::setw(10) << "gen us" << std::setw(10) << "mesh us"
+		<< std::setw(10) << "gen ns/c" << std::setw(10) << "mesh ns/c" << std::setw(10) << "bytes/c" << std::setw(8) << "quads" << "\n";
+
+	const WorldGenerator generator(BENCHMARK_SEED);
+	uint64_t checksum = 0;
+	benchmarkDimensions<ChunkDimensions<16, 64>>(out, generator, checksum);
+	benchmarkDimensions<ChunkDimensions<16, 256>>(out, generator, checksum);
+	benchmarkDimensions<ChunkDimensions<32, 64>>(out, generator, checksum);
+	benchmarkDimensions<ChunkDimensions<32, 384>>(out, generator, checksum);
+	out << "checksum " << checksum << std::endl;
+}
+
+// whether b holds exactly what a does, blocks, surface heights and biomes
+template<typename Dims>
+static bool isSameChunk(const BasicChunkData<Dims>& a, const BasicChunkData<Dims>& b)
+{
+	std::array<uint8_t, SECTIONVOLUME> voxelsA, voxelsB;
+	for (int section = 0; section < Dims::SECTIONCOUNT; section++)
+	{
+		a.getSection(section).getVoxels(voxelsA.data());
+		b.getSection(section).getVoxels(voxelsB.data());
+		if (voxelsA != voxelsB) return false;
+	}
+	for (int x = 0; x < Dims::SIZE; x++)
+		for (int z = 0; z < Dims::SIZE; z++)
+			if (a.getSurface(x, z) != b.getSurface(x, z) || a.getBiome(x, z) != b.getBiome(x, z))
+				return false;
+	return true;
+}
+
+// one chunk of loadChunksAsync, counts itself in done once read and decoded
+template<typename Dims>
+static DetachedTask loadChunkAsync(RegionStorage& storage, glm::ivec2 position, BasicChunkData<Dims>& data, std::atomic<uint32_t>& found, std::atomic<uint32_t>& done)
+{
+	const bool stored = co_await storage.readChunk(position, data);
+	if (stored)
+		found.fetch_add(1, std::memory_order_relaxed);
+	done.fetch_add(1, std::memory_order_release);
+	done.notify_one();
+}
+
+// every chunk in flight at once, read through the storage's AsyncIO and decoded wherever
+// the reads complete. The tasks still touch the counters after the wait returns, they
+// must outlive the threads the tasks resume on
+template<typename Dims>
+static uint64_t loadChunksAsync(RegionStorage& storage, glm::ivec2 (*position)(int), BasicChunkData<Dims>* loaded, std::atomic<uint32_t>& found, std::atomic<uint32_t>& done)
+{
+	found = 0;
+	done = 0;
+	for (int i = 0; i < BENCHMARK_CHUNKS; i++)
+		loadChunkAsync(storage, position(i), loaded[i], found, done);
+
+	for (uint32_t count = done.load(std::memory_order_acquire); count != BENCHMARK_CHUNKS; count = done.load(std::memory_order_acquire))
+		done.wait(count, std::memory_order_acquire);
+	return found.load(std::memory_order_relaxed);
+}
+
+template<typename Dims>
+static void benchmarkRegions(std::ostream& out, const WorldGenerator& generator, uint64_t& checksum)
+{
+	constexpr int GRID = BENCHMARK_GENERATED_GRID;
+	std::unique_ptr<BasicChunkData<Dims>[]> chunks = std::make_unique<BasicChunkData<Dims>[]>(GRID * GRID);
+	std::unique_ptr<BasicChunkData<Dims>[]> loaded = std::make_unique<BasicChunkData<Dims>[]>(BENCHMARK_CHUNKS);
+	auto generated = [&](int i) -> const BasicChunkData<Dims>&
+	{
+		return chunks[(i / BENCHMARK_CHUNK_GRID + GENERATION_MARGIN) * GRID + i % BENCHMARK_CHUNK_GRID + GENERATION_MARGIN];
+	};
+	auto position = [](int i)
+	{
+		return glm::ivec2(i / BENCHMARK_CHUNK_GRID, i % BENCHMARK_CHUNK_GRID);
+	};
+
+	const double generate = timeRun(BENCHMARK_CHUNKS, [&]
+	{
+		generateBenchmarkChunks(generator, chunks.get());
+		return static_cast<uint64_t>(generated(0).getSurface(0, 0));
+	}, checksum);
+
+	// encoding and decoding alone, every chunk checked to come back unchanged
+	std::vector<uint8_t> bytes;
+	size_t encodedBytes = 0;
+	size_t memory = 0;
+	const double encode = timeRun(BENCHMARK_CHUNKS, [&]
+	{
+		encodedBytes = 0;
+		memory = 0;
+		for (int i = 0; i < BENCHMARK_CHUNKS; i++)
+		{
+			bytes.clear();
+			encodeChunk(generated(i), bytes);
+			encodedBytes += bytes.size();
+			memory += generated(i).getMemoryUsage();
+		}
+		return static_cast<uint64_t>(encodedBytes);
+	}, checksum);
+
+	for (int i = 0; i < BENCHMARK_CHUNKS; i++)
+	{
+		bytes.clear();
+		encodeChunk(generated(i), bytes);
+		if (!decodeChunk(bytes.data(), bytes.size(), loaded[i]) || !isSameChunk(generated(i), loaded[i]))
+			throw std::runtime_error("Failed region benchmark, a chunk changed in an encode and decode round trip!");
+	}
+
+	// through the region files of a scratch world, read back by a second storage that maps them afresh
+	const std::filesystem::path directory = std::filesystem::temp_directory_path() / ("region-benchmark-" + std::to_string(Dims::SIZE) + "x" + std::to_string(Dims::HEIGHT));
+	std::filesystem::remove_all(directory);
+	double save, load, uringLoad = 0.0, threadLoad = 0.0;
+	size_t fileSize = 0;
+	AsyncIO io;
+	{
+		RegionStorage storage(directory, io);
+		save = timeRun(BENCHMARK_CHUNKS, [&]
+		{
+			for (int i = 0; i < BENCHMARK_CHUNKS; i++)
+				storage.saveChunk(position(i), generated(i));
+			// as a checkpoint does, so the next run reuses the sectors this one moved off
+			storage.sync();
+			return storage.getStats().chunksSaved;
+		}, checksum);
+	}
+	{
+		RegionStorage storage(directory, io);
+		load = timeRun(BENCHMARK_CHUNKS, [&]
+		{
+			uint64_t found = 0;
+			for (int i = 0; i < BENCHMARK_CHUNKS; i++)
+				found += storage.loadChunk(position(i), loaded[i]);
+			return found;
+		}, checksum);
+
+		for (int i = 0; i < BENCHMARK_CHUNKS; i++)
+			if (!isSameChunk(generated(i), loaded[i]))
+				throw std::runtime_error("Failed region benchmark, a chunk changed in a save and load round trip!");
+	}
+	for (IOBACKEND backend : { IO_URING, IO_THREADS })
+	{
+		std::atomic<uint32_t> found, done;
+		JobSystem jobs;
+		jobs.start();
+		AsyncIO asyncIO(&jobs, backend);
+		// the backend falls back to threads where io_uring is not available
+		if (asyncIO.getBackend() != backend) continue;
+
+		RegionStorage storage(directory, asyncIO);
+		(backend == IO_URING ? uringLoad : threadLoad) = timeRun(BENCHMARK_CHUNKS, [&]
+		{
+			return loadChunksAsync(storage, position, loaded.get(), found, done);
+		}, checksum);
+
+		for (int i = 0; i < BENCHMARK_CHUNKS; i++)
+			if (!isSameChunk(generated(i), loaded[i]))
+				throw std::runtime_error("Failed region benchmark, a chunk changed in an asynchronous save and load round trip!");
+	}
+	for (const auto& entry : std::filesystem::directory_iterator(directory))
+		fileSize += entry.file_size();
+	std::filesystem::remove_all(directory);
+
+	const std::string name = std::to_string(Dims::SIZE) + "x" + std::to_string(Dims::HEIGHT) + (std::is_same_v<Dims, WorldDimensions> ? "*" : "");
+	out << std::left << std::setw(8) << name << std::right << std::fixed << std::setprecision(1)
+		<< std::setw(10) << generate / 1000 << std::setw(10) << encode / 1000 << std::setw(10) << save / 1000 << std::setw(10) << load / 1000
+		<< std::setw(9) << generate / load << "x";
+	if (uringLoad > 0.0)
+		out << std::setw(10) << uringLoad / 1000;
+	else
+		out << std::setw(10) << "-";
+	if (threadLoad > 0.0)
+		out << std::setw(11) << threadLoad / 1000;
+	else
+		out << std::setw(11) << "-";
+	out << std::setw(10) << encodedBytes / BENCHMARK_CHUNKS << std::setw(10) << memory / BENCHMARK_CHUNKS
+		<< std::setw(10) << fileSize / 1024 << "\n";
+}
+
+void runRegionBenchmarks(std::ostream& out)
+{
+	out << BENCHMARK_CHUNKS << " generated chunks saved to and loaded from a region file, best of " << BENCHMARK_REPEATS << ", per chunk\n";
+	out << "load reads the mapping on one thread, uring and threads have every chunk in flight and decode on the job system\n";
+	out << std::left << std::setw(8) << "shape" << std::right << std::setw(10) << "gen us" << std::setw(10) << "encode us"
+		<< std::setw(10) << "save us" << std::setw(10) << "load us" << std::setw(10) << "vs gen"
+		<< std::setw(10) << "uring us" << std::setw(11) << "threads us"
+		<< std::setw(10) << "bytes" << std::setw(10) << "in memory" << std::setw(10) << "file KiB" << "\n";
+
+	const WorldGenerator generator(BENCHMARK_SEED);
+	uint64_t checksum = 0;
+	benchmarkRegions<ChunkDimensions<16, 64>>(out, generator, checksum);
+	benchmarkRegions<ChunkDimensions<16, 256>>(out, generator, checksum);
+	benchmarkRegions<ChunkDimensions<32, 64>>(out, generator, checksum);
+	benchmarkRegions<ChunkDimensions<32, 384>>(out, generator, checksum);
+	out << "every chunk matched after an encode and decode and a save and load round trip\n";
+	out << "checksum " << checksum << std::endl;
+}
+
+enum BENCHMARKSAVE {
+	SAVE_NONE,        // edits only, the frame time to compare against
+	SAVE_SYNCHRONOUS, // encoding and writing every chunk on the frame thread
+	SAVE_AUTOSAVE     // snapshots handed to an Autosave
+};
+
+// frames that edit random blocks of the generated chunks, saving them all every
+// BENCHMARK_SAVE_FRAMES, writes frame times in microseconds to out
+static void benchmarkAutosave(std::ostream& out, const char* name, BENCHMARKSAVE mode, const WorldGenerator& generator, uint64_t& checksum)
+{
+	constexpr int GRID = BENCHMARK_GENERATED_GRID;
+	std::unique_ptr<ChunkData[]> chunks = std::make_unique<ChunkData[]>(GRID * GRID);
+	generateBenchmarkChunks(generator, chunks.get());
+	auto chunk = [&](int i) -> ChunkData&
+	{
+		return chunks[(i / BENCHMARK_CHUNK_GRID + GENERATION_MARGIN) * GRID + i % BENCHMARK_CHUNK_GRID + GENERATION_MARGIN];
+	};
+	auto position = [](int i)
+	{
+		return glm::ivec2(i / BENCHMARK_CHUNK_GRID, i % BENCHMARK_CHUNK_GRID);
+	};
+
+	const std::filesystem::path directory = std::filesystem::temp_directory_path() / "autosave-benchmark";
+	std::filesystem::remove_all(directory);
+	const uint64_t copiesBefore = ChunkSection::getCopyOnWriteCount();
+	double totalUs = 0.0, worstUs = 0.0, worstSaveUs = 0.0, savingUs = 0.0;
+	int savingFrames = 0;
+	{
+		JobSystem jobs;
+		jobs.start();
+		AsyncIO io(&jobs);
+		RegionStorage storage(directory, io);
+		Autosave autosave(storage, jobs);
+
+		std::mt19937 random(BENCHMARK_SEED);
+		for (int frame = 0; frame < BENCHMARK_FRAMES; frame++)
+		{
+			const bool saving = autosave.isSaving();
+			const auto start = std::chrono::steady_clock::now();
+			for (int edit = 0; edit < BENCHMARK_FRAME_EDITS; edit++)
+			{
+				const uint32_t value = random();
+				const int x = value % CHUNKSIZE, y = value / CHUNKSIZE % CHUNKHEIGHT, z = value / CHUNKSIZE / CHUNKHEIGHT % CHUNKSIZE;
+				chunk(value / (CHUNKSIZE * CHUNKHEIGHT * CHUNKSIZE) % BENCHMARK_CHUNKS).getSection(x / SECTIONSIZE, y / SECTIONSIZE, z / SECTIONSIZE)
+					.setBlock(x % SECTIONSIZE, y % SECTIONSIZE, z % SECTIONSIZE, static_cast<uint8_t>(random() % (STONE + 1)));
+			}
+
+			const bool save = frame % BENCHMARK_SAVE_FRAMES == BENCHMARK_SAVE_FRAMES - 1;
+			if (save && mode == SAVE_SYNCHRONOUS)
+				for (int i = 0; i < BENCHMARK_CHUNKS; i++)
+					storage.saveChunk(position(i), chunk(i));
+			else if (save && mode == SAVE_AUTOSAVE)
+				for (int i = 0; i < BENCHMARK_CHUNKS; i++)
+					autosave.save(position(i), chunk(i));
+			jobs.runCompletions();
+
+			const double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+			totalUs += us;
+			worstUs = std::max(worstUs, us);
+			if (save) worstSaveUs = std::max(worstSaveUs, us);
+			if (saving)
+			{
+				savingUs += us;
+				savingFrames++;
+			}
+			std::this_thread::sleep_for(std::chrono::microseconds(BENCHMARK_FRAME_IDLE_US));
+		}
+		autosave.stop();
+		storage.waitIdle();
+		jobs.runCompletions();
+
+		if (mode != SAVE_NONE)
+		{
+			// the last save was of the chunks as they are now
+			ChunkData loaded;
+			for (int i = 0; i < BENCHMARK_CHUNKS; i++)
+				if (!storage.loadChunk(position(i), loaded) || !isSameChunk(chunk(i), loaded))
+					throw std::runtime_error("Failed autosave benchmark, a saved chunk changed!");
+			checksum += storage.getStats().bytesSaved;
+		}
+	}
+	std::filesystem::remove_all(directory);
+
+	out << std::left << std::setw(12) << name << std::right << std::fixed << std::setprecision(1)
+		<< std::setw(11) << totalUs / BENCHMARK_FRAMES << std::setw(11) << worstUs << std::setw(11) << worstSaveUs;
+	if (savingFrames > 0)
+		out << std::setw(11) << savingUs / savingFrames;
+	else
+		out << std::setw(11) << "-";
+	out << std::setw(11) << ChunkSection::getCopyOnWriteCount() - copiesBefore << "\n";
+}
+
+void runAutosaveBenchmarks(std::ostream& out)
+{
+	out << BENCHMARK_FRAMES << " frames of " << BENCHMARK_FRAME_EDITS << " random block edits to " << BENCHMARK_CHUNKS << " " << CHUNKSIZE << "x" << CHUNKHEIGHT
+		<< " chunks, all saved every " << BENCHMARK_SAVE_FRAMES << " frames, in microseconds of frame work with " << BENCHMARK_FRAME_IDLE_US << " idle between frames\n";
+	out << std::left << std::setw(12) << "save" << std::right << std::setw(11) << "frame" << std::setw(11) << "worst" << std::setw(11) << "save frame"
+		<< std::setw(11) << "saving" << std::setw(11) << "copies" << "\n";
+
+	const WorldGenerator generator(BENCHMARK_SEED);
+	uint64_t checksum = 0;
+	benchmarkAutosave(out, "none", SAVE_NONE, generator, checksum);
+	benchmarkAutosave(out, "synchronous", SAVE_SYNCHRONOUS, generator, checksum);
+	benchmarkAutosave(out, "autosave", SAVE_AUTOSAVE, generator, checksum);
+	out << "saving is the average frame while an autosave was being written, copies the sections edited while shared with a snapshot\n";
+	out << "every chunk matched after saving and loading it back\n";
+	out << "checksum " << checksum << std::endl;
+}
+
+// a random block of one of the BENCHMARK_CHUNKS chunks at (i / BENCHMARK_CHUNK_GRID, i % BENCHMARK_CHUNK_GRID)
+static BlockEdit randomBenchmarkEdit(std::mt19937& random)
+{
+	const uint32_t value = random();
+	const int chunk = value / (CHUNKSIZE * CHUNKHEIGHT * CHUNKSIZE) % BENCHMARK_CHUNKS;
+	const glm::ivec3 position(value % CHUNKSIZE, value / CHUNKSIZE % CHUNKHEIGHT, value / CHUNKSIZE / CHUNKHEIGHT % CHUNKSIZE);
+	return { glm::ivec2(chunk / BENCHMARK_CHUNK_GRID, chunk % BENCHMARK_CHUNK_GRID), position, static_cast<uint8_t>(random() % (STONE + 1)) };
+}
+
+// appends edits back to back, committing after each one when synced, and writes
+// how many per second the log makes durable to out
+static void benchmarkEditLog(std::ostream& out, const char* name, float flushInterval, bool synced, uint64_t& checksum)
+{
+	const int edits = synced ? BENCHMARK_LOG_SYNCED_EDITS : BENCHMARK_LOG_EDITS;
+	const std::filesystem::path directory = std::filesystem::temp_directory_path() / "editlog-benchmark";
+	std::filesystem::remove_all(directory);
+
+	double appendNs, totalMs;
+	EditLogStats stats;
+	{
+		EditLog log(directory, flushInterval);
+		std::mt19937 random(BENCHMARK_SEED);
+		const auto start = std::chrono::steady_clock::now();
+		for (int i = 0; i < edits; i++)
+		{
+			log.append(randomBenchmarkEdit(random));
+			if (synced) log.commit();
+		}
+		const auto appended = std::chrono::steady_clock::now();
+		log.commit();
+		const auto committed = std::chrono::steady_clock::now();
+
+		appendNs = std::chrono::duration<double, std::nano>(appended - start).count() / edits;
+		totalMs = std::chrono::duration<double, std::milli>(committed - start).count();
+		stats = log.getStats();
+	}
+	std::filesystem::remove_all(directory);
+	checksum += stats.bytes;
+
+	out << std::left << std::setw(12) << name << std::right << std::fixed << std::setprecision(1)
+		<< std::setw(12) << flushInterval * 1000.0f << std::setw(12) << edits / totalMs * 1000.0 << std::setw(12) << appendNs
+		<< std::setw(10) << stats.commits << std::setw(12) << static_cast<double>(stats.edits) / stats.commits
+		<< std::setw(10) << stats.syncMs / stats.commits << "\n";
+}
+
+// logs edits to saved chunks, copies the world away the moment they are committed with
+// half a group torn off the end of the log, and times opening the copy: replaying the
+// log, then loading the chunks and applying their edits. Throws unless exactly the
+// committed edits come back
+static void benchmarkRecovery(std::ostream& out, int edits, ChunkData* chunks, uint64_t& checksum)
+{
+	constexpr int GRID = BENCHMARK_GENERATED_GRID;
+	auto chunk = [&](int i) -> ChunkData&
+	{
+		return chunks[(i / BENCHMARK_CHUNK_GRID + GENERATION_MARGIN) * GRID + i % BENCHMARK_CHUNK_GRID + GENERATION_MARGIN];
+	};
+	auto position = [](int i)
+	{
+		return glm::ivec2(i / BENCHMARK_CHUNK_GRID, i % BENCHMARK_CHUNK_GRID);
+	};
+
+	const std::filesystem::path directory = std::filesystem::temp_directory_path() / "recovery-benchmark";
+	const std::filesystem::path crashed = std::filesystem::temp_directory_path() / "recovery-benchmark-crashed";
+	std::filesystem::remove_all(directory);
+	std::filesystem::remove_all(crashed);
+
+	// what the chunks hold after every edit, sharing the saved chunks' sections until edited
+	std::unique_ptr<ChunkData[]> expected = std::make_unique<ChunkData[]>(BENCHMARK_CHUNKS);
+	uint64_t logBytes;
+	{
+		AsyncIO io;
+		RegionStorage storage(directory, io);
+		for (int i = 0; i < BENCHMARK_CHUNKS; i++)
+		{
+			storage.saveChunk(position(i), chunk(i));
+			expected[i].share(chunk(i));
+		}
+
+		EditLog log(directory);
+		std::mt19937 random(BENCHMARK_SEED);
+		for (int i = 0; i < edits; i++)
+		{
+			const BlockEdit edit = randomBenchmarkEdit(random);
+			expected[edit.chunk.x * BENCHMARK_CHUNK_GRID + edit.chunk.y].setBlock(edit.position, edit.type);
+			log.append(edit);
+		}
+		log.commit();
+		logBytes = log.getStats().bytes;
+
+		std::filesystem::copy(directory, crashed);
+		for (const auto& entry : std::filesystem::directory_iterator(crashed))
+			if (entry.path().extension() == ".log")
+			{
+				// the group the crash interrupted, its header made it to the disk and half its edits
+				const uint32_t torn[4] = { EDITLOG_MAGIC, 64, 0, 0 };
+				std::ofstream file(entry.path(), std::ios::binary | std::ios::app);
+				file.write(reinterpret_cast<const char*>(torn), sizeof(torn));
+				file.write(std::string(32 * 12, '\x5A').data(), 32 * 12);
+			}
+	}
+
+	const auto start = std::chrono::steady_clock::now();
+	std::vector<std::vector<BlockEdit>> recovered(BENCHMARK_CHUNKS);
+	EditLog log(crashed);
+	const uint64_t replayed = log.replay([&](const BlockEdit& edit)
+	{
+		recovered[edit.chunk.x * BENCHMARK_CHUNK_GRID + edit.chunk.y].push_back(edit);
+	});
+	const auto replayDone = std::chrono::steady_clock::now();
+
+	std::unique_ptr<ChunkData[]> loaded = std::make_unique<ChunkData[]>(BENCHMARK_CHUNKS);
+	{
+		AsyncIO io;
+		RegionStorage storage(crashed, io);
+		for (int i = 0; i < BENCHMARK_CHUNKS; i++)
+		{
+			if (!storage.loadChunk(position(i), loaded[i]))
+				throw std::runtime_error("Failed recovery benchmark, a saved chunk is missing!");
+			for (const BlockEdit& edit : recovered[i])
+				loaded[i].setBlock(edit.position, edit.type);
+		}
+	}
+	const auto applied = std::chrono::steady_clock::now();
+
+	if (replayed != static_cast<uint64_t>(edits))
+		throw std::runtime_error("Failed recovery benchmark, " + std::to_string(replayed) + " edits replayed of " + std::to_string(edits) + "!");
+	for (int i = 0; i < BENCHMARK_CHUNKS; i++)
+		if (!isSameChunk(loaded[i], expected[i]))
+			throw std::runtime_error("Failed recovery benchmark, a recovered chunk is different!");
+	log.close();
+	std::filesystem::remove_all(directory);
+	std::filesystem::remove_all(crashed);
+	checksum += replayed;
+
+	const double replayMs = std::chrono::duration<double, std::milli>(replayDone - start).count();
+	const double applyMs = std::chrono::duration<double, std::milli>(applied - replayDone).count();
+	out << std::setw(10) << edits << std::fixed << std::setprecision(1) << std::setw(11) << logBytes / 1024.0
+		<< std::setprecision(2) << std::setw(11) << replayMs << std::setw(11) << applyMs << std::setw(11) << replayMs + applyMs
+		<< std::setprecision(1) << std::setw(11) << edits / (replayMs + applyMs) / 1000.0 << "\n";
+}
+
+void runEditLogBenchmarks(std::ostream& out)
+{
+	out << "edit log throughput, " << BENCHMARK_LOG_EDITS << " edits appended back to back (" << BENCHMARK_LOG_SYNCED_EDITS << " when synced one by one) and committed\n";
+	out << std::left << std::setw(12) << "commit" << std::right << std::setw(12) << "interval ms" << std::setw(12) << "edits/s" << std::setw(12) << "append ns"
+		<< std::setw(10) << "syncs" << std::setw(12) << "edits/sync" << std::setw(10) << "ms/sync" << "\n";
+
+	uint64_t checksum = 0;
+	benchmarkEditLog(out, "each edit", 0.0f, true, checksum);
+	benchmarkEditLog(out, "group", 0.0f, false, checksum);
+	benchmarkEditLog(out, "group", 0.005f, false, checksum);
+	benchmarkEditLog(out, "group", EDITLOG_FLUSH_INTERVAL, false, checksum);
+	out << "append ns is the time the editing thread spends per edit, including the sync when synced one by one\n";
+
+	out << "\nrecovery after a crash, " << BENCHMARK_CHUNKS << " saved " << CHUNKSIZE << "x" << CHUNKHEIGHT << " chunks and the edits logged since, in milliseconds\n";
+	out << std::setw(10) << "edits" << std::setw(11) << "log KiB" << std::setw(11) << "replay" << std::setw(11) << "apply" << std::setw(11) << "total"
+		<< std::setw(11) << "M edits/s" << "\n";
+
+	const WorldGenerator generator(BENCHMARK_SEED);
+	std::unique_ptr<ChunkData[]> chunks = std::make_unique<ChunkData[]>(BENCHMARK_GENERATED_GRID * BENCHMARK_GENERATED_GRID);
+	generateBenchmarkChunks(generator, chunks.get());
+	for (int edits : BENCHMARK_RECOVERY_EDITS)
+		benchmarkRecovery(out, edits, chunks.get(), checksum);
+	out << "replay reads the log and sorts its edits by chunk, apply loads the chunks and applies them; a torn group at the end of the log was dropped\n";
+	out << "every recovered chunk matched the chunk as edited\n";
+	out << "checksum " << checksum << std::endl;
+}
+
+// edits random blocks of the benchmarked chunks, then greedy-meshes every section of
+// them and only the sections the edits marked, as BasicChunk::buildMesh does, and
+// writes the time and the vertex data uploaded per chunk of both to out
+template<typename Dims>
+static void benchmarkRemesh(std::ostream& out, const WorldGenerator& generator, uint64_t& checksum)
+{
+	constexpr int GRID = BENCHMARK_GENERATED_GRID;
+	constexpr int BANDSECTIONCOUNT = Dims::SECTIONSXZ * Dims::SECTIONSXZ * BANDSECTIONS;
+	constexpr double QUADKIB = 4.0 * sizeof(ChunkVertex) / 1024;
+
+	std::unique_ptr<BasicChunkData<Dims>[]> chunks = std::make_unique<BasicChunkData<Dims>[]>(GRID * GRID);
+	generateBenchmarkChunks(generator, chunks.get());
+	// sections to mesh per chunk, of the ring too, which is never meshed
+	std::vector<std::bitset<Dims::SECTIONCOUNT>> marked(GRID * GRID);
+
+	MeshScratch<Dims>& scratch = MeshScratch<Dims>::get();
+	auto remesh = [&](bool all) -> uint64_t
+	{
+		uint64_t quads = 0;
+		for (int x = GENERATION_MARGIN; x < GRID - GENERATION_MARGIN; x++)
+		{
+			for (int z = GENERATION_MARGIN; z < GRID - GENERATION_MARGIN; z++)
+			{
+				const std::array<const BasicChunkData<Dims>*, BORDERMESHES> neighbours = {
+					&chunks[x * GRID + z - 1], // FRONT
+					&chunks[x * GRID + z + 1], // BACK
+					&chunks[(x + 1) * GRID + z], // RIGHT
+					&chunks[(x - 1) * GRID + z], // LEFT
+				};
+				const std::bitset<Dims::SECTIONCOUNT>& sections = marked[x * GRID + z];
+
+				uint32_t bands = 0;
+				for (int section = 0; section < Dims::SECTIONCOUNT; section++)
+					if (all || sections[section])
+						bands |= 1u << (section / BANDSECTIONCOUNT);
+				for (int band = 0; band < BANDCOUNT<Dims>; band++)
+					if (bands & (1u << band))
+						scratch.bands[band].fill(chunks[x * GRID + z], neighbours, band);
+				scratch.mesher.prepare(bands);
+
+				for (int region = 0; region < MESHREGIONS; region++)
+					for (int section = 0; section < Dims::SECTIONCOUNT; section++)
+						if ((all || sections[section]) && ChunkMesher<Dims>::regionHasSection(region, section))
+							quads += scratch.mesher.buildMesh(GREEDY, region, section, scratch.vertices.data()).quadCount;
+			}
+		}
+		return quads;
+	};
+
+	const std::string name = std::to_string(Dims::SIZE) + "x" + std::to_string(Dims::HEIGHT) + (std::is_same_v<Dims, WorldDimensions> ? "*" : "");
+	std::mt19937 random(BENCHMARK_SEED);
+	for (int edits : BENCHMARK_REMESH_EDITS)
+	{
+		for (auto& sections : marked)
+			sections.reset();
+		for (int x = GENERATION_MARGIN; x < GRID - GENERATION_MARGIN; x++)
+			for (int z = GENERATION_MARGIN; z < GRID - GENERATION_MARGIN; z++)
+				for (int edit = 0; edit < edits; edit++)
+				{
+					const uint32_t value = random();
+					const glm::ivec3 position(value % Dims::SIZE, value / Dims::SIZE % Dims::HEIGHT, random() % Dims::SIZE);
+					chunks[x * GRID + z].setBlock(position, static_cast<uint8_t>(random() % (STONE + 1)));
+
+					// the neighbours' sections too, where they are benchmarked chunks
+					BasicChunk<Dims>::forEachAffectedSection(position, [&](glm::ivec2 offset, int section)
+					{
+						marked[(x + offset.x) * GRID + z + offset.y].set(section);
+					});
+				}
+
+		uint64_t sections = 0;
+		for (int x = GENERATION_MARGIN; x < GRID - GENERATION_MARGIN; x++)
+			for (int z = GENERATION_MARGIN; z < GRID - GENERATION_MARGIN; z++)
+				sections += marked[x * GRID + z].count();
+
+		// both of the chunks as edited
+		uint64_t fullQuads = 0, quads = 0;
+		const double full = timeRun(BENCHMARK_CHUNKS, [&] { return fullQuads = remesh(true); }, checksum);
+		const double ns = timeRun(BENCHMARK_CHUNKS, [&] { return quads = remesh(false); }, checksum);
+
+		out << std::left << std::setw(8) << name << std::right << std::setw(8) << edits << std::fixed << std::setprecision(1)
+			<< std::setw(10) << static_cast<double>(sections) / BENCHMARK_CHUNKS << std::setw(10) << full / 1000 << std::setw(10) << ns / 1000
+			<< std::setw(10) << fullQuads * QUADKIB / BENCHMARK_CHUNKS << std::setw(10) << quads * QUADKIB / BENCHMARK_CHUNKS
+			<< std::setw(9) << full / ns << "x\n";
+	}
+}
+
+void runRemeshBenchmarks(std::ostream& out)
+{
+	out << BENCHMARK_CHUNKS << " generated chunks after random block edits, greedy-meshed whole and only the sections the edits marked, best of "
+		<< BENCHMARK_REPEATS << ", per chunk\n";
+	out << std::left << std::setw(8) << "shape" << std::right << std::setw(8) << "edits" << std::setw(10) << "sections" << std::setw(10) << "full us"
+		<< std::setw(10) << "marked us" << std::setw(10) << "full KiB" << std::setw(10) << "KiB" << std::setw(10) << "speedup" << "\n";
+
+	const WorldGenerator generator(BENCHMARK_SEED);
+	uint64_t checksum = 0;
+	benchmarkRemesh<ChunkDimensions<16, 64>>(out, generator, checksum);
+	benchmarkRemesh<ChunkDimensions<16, 256>>(out, generator, checksum);
+	benchmarkRemesh<ChunkDimensions<32, 64>>(out, generator, checksum);
+	benchmarkRemesh<ChunkDimensions<32, 384>>(out, generator, checksum);
+	out << "edits accumulate from row to row, KiB is the vertex data uploaded: the marked sections' quads replace theirs in the uploaded buffer\n";
+	out << "checksum " << checksum << std::endl;
+}
+
+// counts the visible faces of the benchmarked chunks with the column masks ChunkMesher
+// builds and with a per-block isFaceVisible loop, as meshing did before the masks, and
+// writes the time of both per chunk to out. Neighbours are left out, both see air past
+// the chunk's edges, so the counts must match
+template<typename Dims>
+static void benchmarkCulling(std::ostream& out, const WorldGenerator& generator, uint64_t& checksum)
+{
+	constexpr int GRID = BENCHMARK_GENERATED_GRID;
+	std::unique_ptr<BasicChunkData<Dims>[]> chunks = std::make_unique<BasicChunkData<Dims>[]>(GRID * GRID);
+	generateBenchmarkChunks(generator, chunks.get());
+	auto chunk = [&](int i) -> BasicChunkData<Dims>&
+	{
+		return chunks[(i / BENCHMARK_CHUNK_GRID + GENERATION_MARGIN) * GRID + i % BENCHMARK_CHUNK_GRID + GENERATION_MARGIN];
+	};
+
+	uint64_t loopFaces = 0;
+	const double loop = timeRun(BENCHMARK_CHUNKS, [&]
+	{
+		loopFaces = 0;
+		for (int i = 0; i < BENCHMARK_CHUNKS; i++)
+		{
+			BasicChunkData<Dims>& data = chunk(i);
+			for (int x = 0; x < Dims::SIZE; x++)
+				for (int y = 0; y < Dims::HEIGHT; y++)
+					for (int z = 0; z < Dims::SIZE; z++)
+					{
+						const glm::ivec3 position(x, y, z);
+						if (!isBlockRendered(data.getBlock(position))) continue;
+						for (int face = FRONT; face <= BOTTOM; face++)
+							loopFaces += data.isFaceVisible(position, static_cast<BLOCKFACE>(face));
+					}
+		}
+		return loopFaces;
+	}, checksum);
+
+	// the bands are filled once per chunk for meshing anyway, timed on their own
+	MeshScratch<Dims>& scratch = MeshScratch<Dims>::get();
+	const std::array<const BasicChunkData<Dims>*, BORDERMESHES> noNeighbours{};
+	auto fill = [&](int i)
+	{
+		for (int band = 0; band < BANDCOUNT<Dims>; band++)
+			scratch.bands[band].fill(chunk(i), noNeighbours, band);
+	};
+	const double filled = timeRun(BENCHMARK_CHUNKS, [&]
+	{
+		for (int i = 0; i < BENCHMARK_CHUNKS; i++)
+			fill(i);
+		return static_cast<uint64_t>(scratch.bands[0].activeSections);
+	}, checksum);
+
+	uint64_t maskFaces = 0;
+	double masks = 0.0;
+	for (int i = 0; i < BENCHMARK_CHUNKS; i++)
+	{
+		fill(i);
+		uint64_t faces = 0;
+		masks += timeRun(1, [&]
+		{
+			scratch.mesher.prepare();
+			faces = 0;
+			for (int region = 0; region < MESHREGIONS; region++)
+				faces += scratch.mesher.countFaces(region);
+			return faces;
+		}, checksum) / BENCHMARK_CHUNKS;
+		maskFaces += faces;
+	}
+	if (maskFaces != loopFaces)
+		throw std::runtime_error("Failed culling benchmark, the column masks found " + std::to_string(maskFaces) + " faces where the loop found " + std::to_string(loopFaces) + "!");
+
+	const std::string name = std::to_string(Dims::SIZE) + "x" + std::to_string(Dims::HEIGHT) + (std::is_same_v<Dims, WorldDimensions> ? "*" : "");
+	out << std::left << std::setw(8) << name << std::right << std::setw(10) << loopFaces / BENCHMARK_CHUNKS << std::fixed << std::setprecision(1)
+		<< std::setw(10) << loop / 1000 << std::setw(10) << filled / 1000 << std::setw(10) << masks / 1000
+		<< std::setw(9) << loop / masks << "x" << std::setw(9) << loop / (filled + masks) << "x\n";
+}
+
+void runCullingBenchmarks(std::ostream& out)
+{
+	out << BENCHMARK_CHUNKS << " generated chunks, visible faces found by a per-block isFaceVisible loop and by the column masks, best of "
+		<< BENCHMARK_REPEATS << ", per chunk\n";
+	out << std::left << std::setw(8) << "shape" << std::right << std::setw(10) << "faces" << std::setw(10) << "loop us" << std::setw(10) << "fill us"
+		<< std::setw(10) << "masks us" << std::setw(10) << "speedup" << std::setw(10) << "w/ fill" << "\n";
+
+	const WorldGenerator generator(BENCHMARK_SEED);
+	uint64_t checksum = 0;
+	benchmarkCulling<ChunkDimensions<16, 64>>(out, generator, checksum);
+	benchmarkCulling<ChunkDimensions<16, 256>>(out, generator, checksum);
+	benchmarkCulling<ChunkDimensions<32, 64>>(out, generator, checksum);
+	benchmarkCulling<ChunkDimensions<32, 384>>(out, generator, checksum);
+	out << "fill copies the chunk into the padded bands the masks are built from, meshing does it either way; masks us builds the masks and counts their faces\n";
+	out << "both found the same faces in every chunk\n";
+	out << "checksum " << checksum << std::endl;
+}
+
+// frames of random edits to chunks published after each, while reader threads pin the
+// newest versions of a random chunk and its neighbours and greedy-mesh it whole, writes
+// the frame thread's time and the readers' meshes to out. Every frame also sets two
+// blocks in different sections of a chunk to the same block, a reader that finds them
+// different saw half a frame
+static void benchmarkVersions(std::ostream& out, int readers, const WorldGenerator& generator, uint64_t& checksum)
+{
+	constexpr int GRID = BENCHMARK_GENERATED_GRID;
+	const glm::ivec3 FIRSTMARKER(0, 0, 0);
+	const glm::ivec3 LASTMARKER(CHUNKSIZE - 1, CHUNKHEIGHT - 1, CHUNKSIZE - 1);
+	EpochDomain& domain = EpochDomain::get();
+	const EpochStats statsBefore = domain.getStats();
+	const uint64_t copiesBefore = ChunkSection::getCopyOnWriteCount();
+
+	std::unique_ptr<Chunk[]> chunks = std::make_unique<Chunk[]>(GRID * GRID);
+	{
+		std::unique_ptr<ChunkData[]> data = std::make_unique<ChunkData[]>(GRID * GRID);
+		generateBenchmarkChunks(generator, data.get());
+		for (int i = 0; i < GRID * GRID; i++)
+		{
+			chunks[i].getData().share(data[i]);
+			chunks[i].setBlock(FIRSTMARKER, STONE);
+			chunks[i].setBlock(LASTMARKER, STONE);
+			chunks[i].publish();
+		}
+	}
+	auto chunk = [&](int i) -> Chunk&
+	{
+		return chunks[(i / BENCHMARK_CHUNK_GRID + GENERATION_MARGIN) * GRID + i % BENCHMARK_CHUNK_GRID + GENERATION_MARGIN];
+	};
+
+	std::atomic<bool> stop{ false };
+	std::atomic<uint64_t> meshes{ 0 }, quads{ 0 }, torn{ 0 };
+	std::vector<std::thread> threads;
+	for (int reader = 0; reader < readers; reader++)
+	{
+		threads.emplace_back([&, reader]
+		{
+			MeshScratch<WorldDimensions>& scratch = MeshScratch<WorldDimensions>::get();
+			std::mt19937 random(BENCHMARK_SEED + reader);
+			uint64_t readerMeshes = 0, readerQuads = 0, readerTorn = 0;
+			while (!stop.load(std::memory_order_relaxed))
+			{
+				const int i = random() % BENCHMARK_CHUNKS;
+				const int x = i / BENCHMARK_CHUNK_GRID + GENERATION_MARGIN, z = i % BENCHMARK_CHUNK_GRID + GENERATION_MARGIN;
+
+				EpochGuard guard = domain.pin();
+				const ChunkData& data = chunks[x * GRID + z].getPublished()->data;
+				const std::array<const ChunkData*, BORDERMESHES> neighbours = {
+					&chunks[x * GRID + z - 1].getPublished()->data, // FRONT
+					&chunks[x * GRID + z + 1].getPublished()->data, // BACK
+					&chunks[(x + 1) * GRID + z].getPublished()->data, // RIGHT
+					&chunks[(x - 1) * GRID + z].getPublished()->data, // LEFT
+				};
+				if (data.getBlock(FIRSTMARKER) != data.getBlock(LASTMARKER))
+					readerTorn++;
+
+				for (int band = 0; band < BANDCOUNT<WorldDimensions>; band++)
+					scratch.bands[band].fill(data, neighbours, band);
+				scratch.mesher.prepare();
+				for (int region = 0; region < MESHREGIONS; region++)
+					readerQuads += scratch.mesher.buildMesh(GREEDY, region, scratch.vertices.data()).quadCount;
+				readerMeshes++;
+			}
+			meshes += readerMeshes;
+			quads += readerQuads;
+			torn += readerTorn;
+		});
+	}
+
+	std::mt19937 random(BENCHMARK_SEED);
+	double totalUs = 0.0, worstUs = 0.0;
+	uint64_t peakWaiting = 0;
+	const auto runStart = std::chrono::steady_clock::now();
+	for (int frame = 0; frame < BENCHMARK_FRAMES; frame++)
+	{
+		const auto start = std::chrono::steady_clock::now();
+		for (int edit = 0; edit < BENCHMARK_FRAME_EDITS; edit++)
+		{
+			const BlockEdit blockEdit = randomBenchmarkEdit(random);
+			if (blockEdit.position != FIRSTMARKER && blockEdit.position != LASTMARKER)
+				chunk(blockEdit.chunk.x * BENCHMARK_CHUNK_GRID + blockEdit.chunk.y).setBlock(blockEdit.position, blockEdit.type);
+		}
+		Chunk& marked = chunk(random() % BENCHMARK_CHUNKS);
+		const uint8_t marker = frame % 2 ? DIRT : STONE;
+		marked.setBlock(FIRSTMARKER, marker);
+		marked.setBlock(LASTMARKER, marker);
+
+		for (int i = 0; i < BENCHMARK_CHUNKS; i++)
+			chunk(i).publish();
+		domain.collect();
+		peakWaiting = std::max(peakWaiting, domain.getStats().waiting);
+
+		const double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+		totalUs += us;
+		worstUs = std::max(worstUs, us);
+		std::this_thread::sleep_for(std::chrono::microseconds(BENCHMARK_FRAME_IDLE_US));
+	}
+	const double runSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - runStart).count();
+	stop = true;
+	for (std::thread& thread : threads)
+		thread.join();
+
+	chunks.reset();
+	domain.collect();
+	const EpochStats stats = domain.getStats();
+	if (torn > 0)
+		throw std::runtime_error("Failed version benchmark, a reader saw part of a frame's edits!");
+	if (stats.waiting > statsBefore.waiting)
+		throw std::runtime_error("Failed version benchmark, a version was never reclaimed!");
+	checksum += quads;
+
+	out << std::setw(8) << readers << std::fixed << std::setprecision(1) << std::setw(10) << totalUs / BENCHMARK_FRAMES << std::setw(10) << worstUs
+		<< std::setprecision(0) << std::setw(12) << BENCHMARK_FRAMES * (BENCHMARK_FRAME_EDITS + 2) / (totalUs / 1e6);
+	if (readers > 0)
+		out << std::setw(12) << meshes / runSeconds;
+	else
+		out << std::setw(12) << "-";
+	out << std::setw(10) << stats.retired - statsBefore.retired << std::setw(10) << peakWaiting << std::setw(10) << ChunkSection::getCopyOnWriteCount() - copiesBefore << "\n";
+}
+
+void runVersionBenchmarks(std::ostream& out)
+{
+	out << BENCHMARK_FRAMES << " frames of " << BENCHMARK_FRAME_EDITS << " random block edits to " << BENCHMARK_CHUNKS << " " << CHUNKSIZE << "x" << CHUNKHEIGHT
+		<< " chunks, each published after, with " << BENCHMARK_FRAME_IDLE_US << " us idle between frames, while readers mesh pinned versions on "
+		<< std::thread::hardware_concurrency() << " hardware threads\n";
+	out << std::right << std::setw(8) << "readers" << std::setw(10) << "frame us" << std::setw(10) << "worst" << std::setw(12) << "edits/s"
+		<< std::setw(12) << "meshes/s" << std::setw(10) << "versions" << std::setw(10) << "waiting" << std::setw(10) << "copies" << "\n";
+
+	const WorldGenerator generator(BENCHMARK_SEED);
+	uint64_t checksum = 0;
+	for (int readers : BENCHMARK_VERSION_READERS)
+		benchmarkVersions(out, readers, generator, checksum);
+	out << "frame us is the frame thread's editing, publishing and reclaiming; versions were published and freed, waiting is the most retired ones readers still held after a frame\n";
+	out << "copies are the sections copied on write because a published version shared them; no reader saw a torn version\n";
+	out << "checksum " << checksum << std::endl;
+}
+
+// generates the square of chunks within distance of the centre, interns their sections as
+// the ChunkManager does, and writes how many were identical and the section storage
+// resident with and without sharing to out
+static void benchmarkDedup(std::ostream& out, int distance, const WorldGenerator& generator, uint64_t& checksum)
+{
+	const int side = 2 * distance + 1;
+	const int grid = side + 2 * GENERATION_MARGIN;
+	std::unique_ptr<ChunkData[]> chunks = std::make_unique<ChunkData[]>(grid * grid);
+	generateBenchmarkChunks(generator, chunks.get(), grid);
+
+	uint64_t sections = 0, mixed = 0;
+	const auto start = std::chrono::steady_clock::now();
+	for (int x = GENERATION_MARGIN; x < grid - GENERATION_MARGIN; x++)
+		for (int z = GENERATION_MARGIN; z < grid - GENERATION_MARGIN; z++)
+			chunks[x * grid + z].deduplicate();
+	const double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+	for (int x = GENERATION_MARGIN; x < grid - GENERATION_MARGIN; x++)
+		for (int z = GENERATION_MARGIN; z < grid - GENERATION_MARGIN; z++)
+			for (int section = 0; section < WorldDimensions::SECTIONCOUNT; section++)
+			{
+				sections++;
+				mixed += chunks[x * grid + z].getSection(section).getType() == MIXED;
+				checksum += chunks[x * grid + z].getSection(section).getBlock(section % SECTIONSIZE, 0, 0);
+			}
+
+	// only the benchmarked chunks reference the store, earlier runs' chunks are gone
+	const SectionStoreStats stats = ChunkSection::getStoreStats();
+	const double withoutKiB = stats.referencedBytes / 1024.0, withKiB = stats.uniqueBytes / 1024.0;
+	out << std::setw(8) << distance << std::setw(8) << side * side << std::setw(10) << sections << std::setw(10) << mixed
+		<< std::setw(10) << stats.unique << std::fixed << std::setprecision(2) << std::setw(8) << static_cast<double>(stats.references) / std::max<uint64_t>(stats.unique, 1)
+		<< std::setprecision(0) << std::setw(12) << withoutKiB << std::setw(12) << withKiB << std::setprecision(1) << std::setw(9) << 100.0 * (1.0 - withKiB / std::max(withoutKiB, 1.0)) << "%"
+		<< std::setprecision(0) << std::setw(11) << stats.storeBytes / 1024.0 << std::setprecision(2) << std::setw(10) << us / (side * side) << "\n";
+}
+
+void runDedupBenchmarks(std::ostream& out)
+{
+	out << "Generated " << CHUNKSIZE << "x" << CHUNKHEIGHT << " chunks within each render distance, a square of them, with their MIXED sections interned\n";
+	out << std::right << std::setw(8) << "distance" << std::setw(8) << "chunks" << std::setw(10) << "sections" << std::setw(10) << "mixed" << std::setw(10) << "unique"
+		<< std::setw(8) << "ratio" << std::setw(12) << "KiB before" << std::setw(12) << "KiB after" << std::setw(10) << "saved" << std::setw(11) << "store KiB" << std::setw(10) << "us/chunk"
+		<< "\n";
+
+	const WorldGenerator generator(BENCHMARK_SEED);
+	uint64_t checksum = 0;
+	for (int distance : BENCHMARK_DEDUP_DISTANCES)
+		benchmarkDedup(out, distance, generator, checksum);
+	out << "ratio is mixed sections per distinct storage block, KiB the pooled section storage they need; what interning frees goes back to the pools for the next chunks\n";
+	out << "store KiB is the memory of the store's table, which interning adds; EMPTY and UNIFORM sections hold no storage to begin with\n";
+	out << "checksum " << checksum << std::endl;
+}
+
+// moves the square of loaded chunks back and forth over the generated ones, storing those
+// that leave it in a cache of budgetKiB and decoding those that enter it from there, and
+// writes the hit rate, the cache's memory and the time a chunk took to load again to out.
+// Misses cost generateUs, the time generating a chunk took
+static void benchmarkCache(std::ostream& out, int budgetKiB, const ChunkData* chunks, int grid, double generateUs, uint64_t& checksum)
+{
+	constexpr int DISTANCE = BENCHMARK_CACHE_DISTANCE;
+	auto chunkAt = [&](int x, int z) -> const ChunkData&
+	{
+		return chunks[(x + DISTANCE + GENERATION_MARGIN) * grid + z + DISTANCE + GENERATION_MARGIN];
+	};
+
+	JobSystem jobs;
+	jobs.start();
+	ChunkCache cache(jobs, static_cast<size_t>(budgetKiB) << 10);
+	ChunkData loaded;
+	std::vector<uint8_t> bytes;
+	uint64_t entered = 0, hits = 0;
+	size_t peakDecoded = 0;
+	double decodeUs = 0.0;
+
+	int centre = 0;
+	for (int step = 0; step < 2 * BENCHMARK_CACHE_SWEEPS * BENCHMARK_CACHE_TRAVEL; step++)
+	{
+		const int direction = step / BENCHMARK_CACHE_TRAVEL % 2 == 0 ? 1 : -1;
+		const int leaving = centre - direction * DISTANCE;
+		centre += direction;
+		const int entering = centre + direction * DISTANCE;
+
+		for (int z = -DISTANCE; z <= DISTANCE; z++)
+			cache.store({ leaving, z }, chunkAt(leaving, z));
+		for (int z = -DISTANCE; z <= DISTANCE; z++)
+		{
+			entered++;
+			if (!cache.take({ entering, z }, bytes)) continue;
+
+			const auto start = std::chrono::steady_clock::now();
+			cache.decode(bytes, loaded);
+			decodeUs += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+			hits++;
+			if (!isSameChunk(chunkAt(entering, z), loaded))
+				throw std::runtime_error("Failed cache benchmark, a chunk changed in the cache!");
+		}
+
+		// every chunk that left is in the cache or evicted before the next step
+		while (jobs.getPendingCount() > 0)
+		{
+			jobs.runCompletions();
+			std::this_thread::yield();
+		}
+		peakDecoded = std::max(peakDecoded, cache.getStats().decodedBytes);
+	}
+	jobs.stop();
+
+	const ChunkCacheStats stats = cache.getStats();
+	checksum += stats.stored + hits;
+	const double reloadUs = (decodeUs + (entered - hits) * generateUs) / entered;
+	out << std::setw(10) << budgetKiB << std::fixed << std::setprecision(1) << std::setw(9) << 100.0 * hits / entered << "%"
+		<< std::setw(10) << stats.evictions << std::setw(10) << stats.peakBytes / 1024 << std::setw(12) << peakDecoded / 1024
+		<< std::setprecision(2) << std::setw(10) << (stats.stored ? stats.encodeMs * 1000 / stats.stored : 0.0)
+		<< std::setw(10) << (hits ? decodeUs / hits : 0.0) << std::setprecision(1) << std::setw(10) << reloadUs << std::setw(9) << generateUs / reloadUs << "x\n";
+}
+
+void runCacheBenchmarks(std::ostream& out)
+{
+	constexpr int DISTANCE = BENCHMARK_CACHE_DISTANCE;
+	const int side = 2 * DISTANCE + 1;
+	out << "A " << side << "x" << side << " square of loaded " << CHUNKSIZE << "x" << CHUNKHEIGHT << " chunks moving " << BENCHMARK_CACHE_TRAVEL << " chunks along x and back "
+		<< BENCHMARK_CACHE_SWEEPS << " times, the chunks leaving it compressed into a ChunkCache and those entering decoded from it\n";
+
+	// generating the benchmark grid, per chunk, is what a miss costs
+	const WorldGenerator generator(BENCHMARK_SEED);
+	uint64_t checksum = 0;
+	{
+		std::unique_ptr<ChunkData[]> chunks = std::make_unique<ChunkData[]>(BENCHMARK_GENERATED_GRID * BENCHMARK_GENERATED_GRID);
+		const double generateUs = timeRun(BENCHMARK_CHUNKS, [&]
+		{
+			generateBenchmarkChunks(generator, chunks.get());
+			return static_cast<uint64_t>(chunks[0].getSurface(0, 0));
+		}, checksum) / 1000;
+
+		const int grid = BENCHMARK_CACHE_TRAVEL + side + 2 * GENERATION_MARGIN;
+		std::unique_ptr<ChunkData[]> world = std::make_unique<ChunkData[]>(grid * grid);
+		generateBenchmarkChunks(generator, world.get(), grid);
+
+		out << "a miss is costed at generating the chunk, " << std::fixed << std::setprecision(1) << generateUs << " us\n";
+		out << std::right << std::setw(10) << "budget KiB" << std::setw(10) << "hits" << std::setw(10) << "evicted" << std::setw(10) << "peak KiB"
+			<< std::setw(12) << "decoded KiB" << std::setw(10) << "encode us" << std::setw(10) << "decode us" << std::setw(10) << "reload us" << std::setw(10) << "vs gen" << "\n";
+		for (int budgetKiB : BENCHMARK_CACHE_BUDGETS)
+			benchmarkCache(out, budgetKiB, world.get(), grid, generateUs, checksum);
+	}
+	out << "peak KiB is the most compressed chunks the cache held, decoded KiB the most memory they would have taken loaded; encoding runs on the job system\n";
+	out << "reload us is the average chunk entering the square, decoded or generated; the first move over the chunks always misses, so hits top out at "
+		<< 100.0 - 50.0 / BENCHMARK_CACHE_SWEEPS << "%\n";
+	out << "every decoded chunk matched the one stored\n";
+	out << "checksum " << checksum << std::endl;
+}
+
+// samples per second filling one grid per chunk of a BENCHMARK_NOISE_GRIDS row
+static double benchmarkNoiseGrid(const NoiseSettings& settings, int dimensions, std::vector<float>& out)
+{
+	const glm::ivec3 size(CHUNKSIZE, dimensions == 2 ? 1 : CHUNKHEIGHT, CHUNKSIZE);
+	const uint64_t samples = static_cast<uint64_t>(size.x) * size.y * size.z * BENCHMARK_NOISE_GRIDS;
+	out.resize(samples);
+
+	uint64_t checksum = 0;
+	const double ns = timeRun(samples, [&]
+	{
+		for (int grid = 0; grid < BENCHMARK_NOISE_GRIDS; grid++)
+		{
+			float* gridOut = out.data() + static_cast<size_t>(grid) * size.x * size.y * size.z;
+			if (dimensions == 2)
+				generateNoise2D(settings, { grid * size.x, 0 }, { size.x, size.z }, gridOut);
+			else
+				generateNoise3D(settings, { grid * size.x, 0, 0 }, size, gridOut);
+		}
+		return static_cast<uint64_t>(out[samples / 2] * 1000.0f);
+	}, checksum);
+	return 1e9 / ns;
+}
+
+void runNoiseBenchmarks(std::ostream& out)
+{
+	const SIMDLEVEL supported = getSupportedSimdLevel();
+	const SIMDLEVEL previous = getNoiseSimdLevel();
+	out << BENCHMARK_NOISE_GRIDS << " chunk grids, best of " << BENCHMARK_REPEATS << ", million samples per second, "
+		<< getSimdLevelName(supported) << " supported\n";
+	out << std::left << std::setw(22) << "noise" << std::right;
+	for (int level = SIMD_SCALAR; level <= supported; level++)
+		out << std::setw(10) << getSimdLevelName(static_cast<SIMDLEVEL>(level));
+	out << "  matches scalar\n";
+
+	const char* typeNames[] = { "perlin", "simplex" };
+	const char* fractalNames[] = { "", " fbm4", " ridged4" };
+	std::vector<float> reference, samples;
+	for (int dimensions = 2; dimensions <= 3; dimensions++)
+		for (NOISETYPE type : { PERLIN, SIMPLEX })
+			for (FRACTALTYPE fractal : { FRACTAL_NONE, FRACTAL_FBM, FRACTAL_RIDGED })
+			{
+				NoiseSettings settings;
+				settings.type = type;
+				settings.fractal = fractal;
+				settings.seed = 1337;
+				settings.frequency = 0.02f;
+				settings.octaves = 4;
+
+				out << std::left << std::setw(22) << (std::to_string(dimensions) + "D " + typeNames[type] + fractalNames[fractal]) << std::right;
+				bool matches = true;
+				for (int level = SIMD_SCALAR; level <= supported; level++)
+				{
+					setNoiseSimdLevel(static_cast<SIMDLEVEL>(level));
+					const double rate = benchmarkNoiseGrid(settings, dimensions, level == SIMD_SCALAR ? reference : samples);
+					if (level != SIMD_SCALAR)
+						matches &= std::memcmp(reference.data(), samples.data(), reference.size() * sizeof(float)) == 0;
+					out << std::fixed << std::setprecision(1) << std::setw(10) << rate / 1e6;
+				}
+				out << (matches ? "  yes" : "  NO") << "\n";
+			}
+	setNoiseSimdLevel(previous);
+	out << std::flush;
+}
\ No newline at end of file
@@ -0,0 +1,71 @@
+#pragma once
+#include <ostream>
+
+// Developer benchmarks, run from the command line instead of the game.
+
+// Times the main voxel access patterns (terrain fill, mesher row copy, column scans,
+// six-neighbour stencil, random lookups) against every layout in VoxelLayout.h, on
+// packed chunk sections and on plain byte arrays, and writes a table to out.
+// Run with --benchmark-layouts.
+void runLayoutBenchmarks(std::ostream& out);
+
+// Generates and greedy-meshes chunks of every instantiated ChunkDimensions shape,
+// with all four neighbours linked, and writes time and memory per block column to
+// out so shapes of different sizes compare. Run with --benchmark-dimensions.
+void runChunkDimensionBenchmarks(std::ostream& out);
+
+// Saves generated chunks of every ChunkDimensions shape to region files in the temp
+// directory and loads them back, writes the time of each step against generating
+// them and their size to out. Throws if a chunk comes back different.
+// Run with --benchmark-regions.
+void runRegionBenchmarks(std::ostream& out);
+
+// Edits random blocks of generated chunks frame after frame and saves them all now
+// and then, on the frame thread and through an Autosave, writes frame times and the
+// sections copied on write to out. Throws if a saved chunk comes back different.
+// Run with --benchmark-autosave.
+void runAutosaveBenchmarks(std::ostream& out);
+
+// Appends block edits to an EditLog as fast as they come, synced one by one and in
+// group commits of several flush intervals, then simulates a crash with a torn
+// write at the end of the log and times replaying it into the saved chunks. Writes
+// both to out and throws if a recovered chunk differs from the chunk as edited.
+// Run with --benchmark-editlog.
+void runEditLogBenchmarks(std::ostream& out);
+
+// Edits a few random blocks per chunk of generated chunks of every ChunkDimensions
+// shape, then greedy-meshes them whole and only the sections the edits marked, and
+// writes the time and the vertex data uploaded per chunk of both to out.
+// Run with --benchmark-remesh.
+void runRemeshBenchmarks(std::ostream& out);
+
+// Finds the visible faces of generated chunks of every ChunkDimensions shape with the
+// column masks ChunkMesher builds and with a per-block isFaceVisible loop, as meshing
+// did before them, and writes the time of both per chunk to out. Throws if they find
+// different faces. Run with --benchmark-culling.
+void runCullingBenchmarks(std::ostream& out);
+
+// Edits random blocks of generated chunks frame after frame and publishes them, while
+// more and more threads pin the published versions of random chunks and mesh them, and
+// writes the frame time, edits and meshes per second and the versions reclaimed to out.
+// Throws if a reader sees part of a frame's edits or a version is never freed.
+// Run with --benchmark-versions.
+void runVersionBenchmarks(std::ostream& out);
+
+// Generates the chunks within growing render distances, interns their sections as the
+// ChunkManager does and writes the share of sections found identical, the section
+// storage resident with and without sharing and the time it took to out.
+// Run with --benchmark-dedup.
+void runDedupBenchmarks(std::ostream& out);
+
+// Moves a square of generated chunks back and forth as the camera would, compresses
+// those leaving it into a ChunkCache of growing budgets and decodes those entering it,
+// and writes the hit rate, evictions, compressed and decoded memory and the time to
+// load a chunk again against generating it to out. Throws if a chunk comes back
+// different. Run with --benchmark-cache.
+void runCacheBenchmarks(std::ostream& out);
+
+// Fills chunk-sized noise grids with every noise, fractal and instruction set the CPU
+// supports, writes samples per second to out and whether each path matched the
+// scalar one bit for bit. Run with --benchmark-noise.
+void runNoiseBenchmarks(std::ostream& out);
\ No newline at end of file
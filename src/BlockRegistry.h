@@ -0,0 +1,94 @@
+#pragma once
+#include <array>
+#include <cstdint>
+
+enum BLOCKTYPE {
+	AIR, GRASS, DIRT, STONE,
+	BLOCKTYPECOUNT
+};
+enum BLOCKFACE {
+	FRONT, BACK, RIGHT, LEFT, TOP, BOTTOM
+};
+
+constexpr uint8_t ATLAS_TILES_PER_ROW = 10;
+constexpr float ATLAS_TILE_SIZE = 1.0f / ATLAS_TILES_PER_ROW;
+// drawn for faces without a texture of their own
+constexpr uint8_t MISSINGTILE = 99;
+
+enum BLOCKFLAGS : uint8_t {
+	BLOCK_RENDERED = 1 << 0, // has faces to draw
+	BLOCK_OPAQUE = 1 << 1    // hides the faces of the blocks it touches
+};
+
+// One row of BLOCKDEFINITIONS
+struct BlockDefinition
+{
+	const char* name;
+	std::array<uint8_t, 6> tiles; // atlas tile per BLOCKFACE
+	uint8_t flags;
+};
+
+constexpr std::array<uint8_t, 6> allFaces(uint8_t tile)
+{
+	return { tile, tile, tile, tile, tile, tile };
+}
+
+constexpr std::array<uint8_t, 6> sidesTopBottom(uint8_t sides, uint8_t top, uint8_t bottom)
+{
+	return { sides, sides, sides, sides, top, bottom };
+}
+
+// Every block type, in BLOCKTYPE order. A new block is an enum value and a row here,
+// the lookup tables below and so the mesher pick it up from this.
+constexpr std::array<BlockDefinition, BLOCKTYPECOUNT> BLOCKDEFINITIONS = { {
+	{ "air",   allFaces(MISSINGTILE),     0 },
+	{ "grass", sidesTopBottom(1, 0, 2),   BLOCK_RENDERED | BLOCK_OPAQUE },
+	{ "dirt",  allFaces(2),               BLOCK_RENDERED | BLOCK_OPAQUE },
+	{ "stone", allFaces(3),               BLOCK_RENDERED | BLOCK_OPAQUE },
+} };
+
+// BLOCKDEFINITIONS as flat arrays indexed by block value. They cover every value a
+// voxel byte can hold, so lookups need no bounds check; undefined values draw
+// MISSINGTILE and do not hide anything.
+struct BlockTables
+{
+	std::array<std::array<uint8_t, 256>, 6> faceTiles; // [BLOCKFACE][block]
+	std::array<uint8_t, 256> flags;
+};
+
+constexpr BlockTables makeBlockTables()
+{
+	BlockTables tables{};
+	for (int block = 0; block < 256; block++)
+	{
+		const bool defined = block < BLOCKTYPECOUNT;
+		for (int face = 0; face < 6; face++)
+			tables.faceTiles[face][block] = defined ? BLOCKDEFINITIONS[block].tiles[face] : MISSINGTILE;
+		tables.flags[block] = defined ? BLOCKDEFINITIONS[block].flags : static_cast<uint8_t>(BLOCK_RENDERED);
+	}
+	return tables;
+}
+
+inline constexpr BlockTables BLOCKTABLES = makeBlockTables();
+
+static_assert(BLOCKTABLES.flags[AIR] == 0, "air must be neither drawn nor hide anything");
+
+constexpr uint8_t getBlockTile(uint8_t block, BLOCKFACE face)
+{
+	return BLOCKTABLES.faceTiles[face][block];
+}
+
+constexpr uint8_t getBlockFlags(uint8_t block)
+{
+	return BLOCKTABLES.flags[block];
+}
+
+constexpr bool isBlockRendered(uint8_t block)
+{
+	return BLOCKTABLES.flags[block] & BLOCK_RENDERED;
+}
+
+constexpr bool isBlockOpaque(uint8_t block)
+{
+	return BLOCKTABLES.flags[block] & BLOCK_OPAQUE;
+}
\ No newline at end of file
@@ -7,6 +7,53 @@ MVP& Camera::getMatrices()
 	return mMatrices;
 }
 
+glm::vec3 Camera::getPosition() const
+{
+	return mPosition;
+}
+
+glm::vec3 Camera::getOrientation() const
+{
+	return mOrientation;
+}
+
+Frustum Camera::getFrustum() const
+{
+	return Frustum::fromMatrix(mMatrices.proj * mMatrices.view);
+}
+
+Frustum Frustum::fromMatrix(const glm::mat4& viewProjection)
+{
+	// rows of the matrix, glm stores columns
+	glm::vec4 rows[4];
+	for (int i = 0; i < 4; i++)
+		rows[i] = glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+
+	Frustum frustum;
+	frustum.planes[0] = rows[3] + rows[0]; // left
+	frustum.planes[1] = rows[3] - rows[0]; // right
+	frustum.planes[2] = rows[3] + rows[1]; // bottom
+	frustum.planes[3] = rows[3] - rows[1]; // top
+	frustum.planes[4] = rows[2];           // near, depth is 0 to 1
+	frustum.planes[5] = rows[3] - rows[2]; // far
+
+	for (glm::vec4& plane : frustum.planes)
+		plane /= glm::length(glm::vec3(plane));
+	return frustum;
+}
+
+bool Frustum::intersectsBox(glm::vec3 min, glm::vec3 max) const
+{
+	// the box is outside once its corner furthest along a plane's normal is behind it
+	for (const glm::vec4& plane : planes)
+	{
+		glm::vec3 corner(plane.x > 0 ? max.x : min.x, plane.y > 0 ? max.y : min.y, plane.z > 0 ? max.z : min.z);
+		if (glm::dot(glm::vec3(plane), corner) + plane.w < 0)
+			return false;
+	}
+	return true;
+}
+
 void Camera::processInput(GLFWwindow* window)
 {
 	//KEYBOARD INPUT
@@ -3,6 +3,16 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include "structs.h"
 #include <GLFW/glfw3.h>
+#include <array>
+
+// six inward facing planes, xyz = normal and w = distance
+struct Frustum
+{
+	std::array<glm::vec4, 6> planes;
+
+	static Frustum fromMatrix(const glm::mat4& viewProjection);
+	bool intersectsBox(glm::vec3 min, glm::vec3 max) const;
+};
 
 class Camera
 {
@@ -12,6 +22,9 @@ public:
 	Camera(Camera&) = delete;
 
 	MVP& getMatrices();
+	glm::vec3 getPosition() const;
+	glm::vec3 getOrientation() const;
+	Frustum getFrustum() const;
 	void processInput(GLFWwindow* window);
 	void modifyAspectRatio(float newAR);
 
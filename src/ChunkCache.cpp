@@ -0,0 +1,152 @@
+#include "ChunkCache.h"
+#include "ChunkCodec.h"
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <memory>
+#include <stdexcept>
+
+static uint64_t packPosition(glm::ivec2 position)
+{
+	return static_cast<uint64_t>(static_cast<uint32_t>(position.x)) << 32 | static_cast<uint32_t>(position.y);
+}
+
+ChunkCache::ChunkCache(JobSystem& jobs, size_t budget)
+	:mJobs(jobs), mBudget(budget)
+{
+}
+
+void ChunkCache::store(glm::ivec2 position, const ChunkData& data)
+{
+	// what the worker hands to the completion
+	struct Compressed
+	{
+		ChunkData snapshot;
+		std::vector<uint8_t> bytes;
+		size_t decodedBytes = 0;
+		uint64_t ns = 0;
+	};
+	std::shared_ptr<Compressed> compressed = std::make_shared<Compressed>();
+	compressed->snapshot.share(data);
+
+	const uint64_t key = packPosition(position);
+	const uint64_t ticket = ++mNextTicket;
+	mInFlight[key] = ticket;
+
+	mJobs.submit([compressed]
+	{
+		const auto start = std::chrono::steady_clock::now();
+		encodeChunk(compressed->snapshot, compressed->bytes);
+		compressed->bytes.shrink_to_fit();
+		compressed->decodedBytes = compressed->snapshot.getMemoryUsage();
+		compressed->ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+	}, [this, compressed, key, ticket](std::exception_ptr error)
+	{
+		mEncodeNs += compressed->ns;
+		auto it = mInFlight.find(key);
+		if (it == mInFlight.end() || it->second != ticket)
+		{
+			mStale++;
+			return;
+		}
+		mInFlight.erase(it);
+		// the cache is only a copy, a chunk that failed to compress is just not in it
+		if (error) return;
+		insert(key, std::move(compressed->bytes), compressed->decodedBytes);
+	});
+}
+
+bool ChunkCache::take(glm::ivec2 position, std::vector<uint8_t>& bytes)
+{
+	const uint64_t key = packPosition(position);
+	mInFlight.erase(key);
+	mLookups++;
+
+	auto it = mIndex.find(key);
+	if (it == mIndex.end()) return false;
+
+	bytes = erase(it->second);
+	mHits++;
+	return true;
+}
+
+void ChunkCache::decode(const std::vector<uint8_t>& bytes, ChunkData& data) const
+{
+	const auto start = std::chrono::steady_clock::now();
+	if (!decodeChunk(bytes.data(), bytes.size(), data))
+	{
+		mCorrupt.fetch_add(1, std::memory_order_relaxed);
+		throw std::runtime_error("Failed to decode a cached chunk!");
+	}
+	mDecodeNs.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count(), std::memory_order_relaxed);
+}
+
+void ChunkCache::setBudget(size_t budget)
+{
+	mBudget = budget;
+	evict();
+}
+
+void ChunkCache::insert(uint64_t key, std::vector<uint8_t> bytes, size_t decodedBytes)
+{
+	// a chunk is taken whenever it loads, so this is only ever an older copy
+	auto it = mIndex.find(key);
+	if (it != mIndex.end()) erase(it->second);
+
+	mBytes += bytes.capacity();
+	mDecodedBytes += decodedBytes;
+	mEntries.push_front({ key, std::move(bytes), decodedBytes });
+	mIndex[key] = mEntries.begin();
+	mStored++;
+	evict();
+	mPeakBytes = std::max(mPeakBytes, mBytes);
+}
+
+std::vector<uint8_t> ChunkCache::erase(std::list<Entry>::iterator entry)
+{
+	mBytes -= entry->bytes.capacity();
+	mDecodedBytes -= entry->decodedBytes;
+	std::vector<uint8_t> bytes = std::move(entry->bytes);
+	mIndex.erase(entry->key);
+	mEntries.erase(entry);
+	return bytes;
+}
+
+void ChunkCache::evict()
+{
+	while (mBytes > mBudget && !mEntries.empty())
+	{
+		erase(std::prev(mEntries.end()));
+		mEvictions++;
+	}
+}
+
+ChunkCacheStats ChunkCache::getStats() const
+{
+	ChunkCacheStats stats;
+	stats.stored = mStored;
+	stats.stale = mStale;
+	stats.lookups = mLookups;
+	stats.hits = mHits;
+	stats.evictions = mEvictions;
+	stats.corrupt = mCorrupt.load(std::memory_order_relaxed);
+	stats.chunks = static_cast<uint32_t>(mEntries.size());
+	stats.bytes = mBytes;
+	stats.decodedBytes = mDecodedBytes;
+	stats.peakBytes = mPeakBytes;
+	stats.budget = mBudget;
+	stats.encodeMs = mEncodeNs / 1e6;
+	stats.decodeMs = mDecodeNs.load(std::memory_order_relaxed) / 1e6;
+	return stats;
+}
+
+void ChunkCache::reportStats(std::ostream& out) const
+{
+	const ChunkCacheStats stats = getStats();
+	out << "Chunk cache: " << stats.hits << " of " << stats.lookups << " loads hit (" << std::fixed << std::setprecision(1)
+		<< (stats.lookups ? 100.0 * stats.hits / stats.lookups : 0.0) << "%), " << stats.stored << " stored, " << stats.evictions << " evicted, " << stats.corrupt << " corrupt, "
+		<< stats.chunks << " chunks in " << stats.bytes / 1024 << " KiB holding " << stats.decodedBytes / 1024 << " KiB decoded, peak "
+		<< stats.peakBytes / 1024 << " of " << stats.budget / 1024 << " KiB, " << std::setprecision(3)
+		<< (stats.stored + stats.stale ? stats.encodeMs / (stats.stored + stats.stale) : 0.0) << " ms encoding and " << (stats.hits ? stats.decodeMs / stats.hits : 0.0)
+		<< " ms decoding per chunk" << std::endl;
+}
\ No newline at end of file
@@ -0,0 +1,102 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <ostream>
+#include <unordered_map>
+#include <vector>
+#include <glm/glm.hpp>
+#include "World.h"
+#include "JobSystem.h"
+
+// compressed bytes the cache keeps of unloaded chunks before it evicts the oldest
+constexpr size_t CHUNKCACHE_BUDGET = 32 << 20;
+
+struct ChunkCacheStats
+{
+	// chunks compressed into the cache, and compressions dropped because their chunk
+	// loaded again before they were done
+	uint64_t stored = 0;
+	uint64_t stale = 0;
+	// loads that looked for their chunk, and found it
+	uint64_t lookups = 0;
+	uint64_t hits = 0;
+	// dropped to stay within the budget, oldest first
+	uint64_t evictions = 0;
+	// taken but failed to decode, the chunk was read or generated instead
+	uint64_t corrupt = 0;
+	// chunks held, their compressed size and the memory they took decoded
+	uint32_t chunks = 0;
+	size_t bytes = 0;
+	size_t decodedBytes = 0;
+	size_t peakBytes = 0;
+	size_t budget = 0;
+	// time the workers spent compressing and decompressing, in milliseconds
+	double encodeMs = 0.0;
+	double decodeMs = 0.0;
+};
+
+// Keeps chunks that left the loaded area in memory, compressed with the ChunkCodec,
+// so moving back and forth over the edge of the render distance decodes them again
+// instead of reading or generating them. store snapshots the chunk and a worker
+// compresses it; the cache holds the newest chunks within its byte budget and evicts
+// the least recently used, which are those unloaded longest ago since a chunk leaves
+// the cache when it loads. It is only ever a copy of what is saved or being saved.
+// Render thread only, except decode.
+class ChunkCache
+{
+public:
+	ChunkCache(JobSystem& jobs, size_t budget = CHUNKCACHE_BUDGET);
+
+	ChunkCache(const ChunkCache&) = delete;
+	ChunkCache& operator=(const ChunkCache&) = delete;
+
+	// snapshots data and compresses it on a worker, the completion adds it as the most
+	// recently used chunk and evicts what no longer fits
+	void store(glm::ivec2 position, const ChunkData& data);
+	// moves the compressed chunk at position into bytes and drops it, false if it is not
+	// cached. A compression of it still in flight is dropped too, call whenever the chunk
+	// loads so the cache never holds one older than the chunk's next changes
+	bool take(glm::ivec2 position, std::vector<uint8_t>& bytes);
+	// decompresses what take returned into data, throws if it is corrupt. Any thread
+	void decode(const std::vector<uint8_t>& bytes, ChunkData& data) const;
+	// evicts at once if the cache holds more
+	void setBudget(size_t budget);
+
+	ChunkCacheStats getStats() const;
+	void reportStats(std::ostream& out) const;
+private:
+	struct Entry
+	{
+		uint64_t key;
+		std::vector<uint8_t> bytes;
+		size_t decodedBytes;
+	};
+
+	void insert(uint64_t key, std::vector<uint8_t> bytes, size_t decodedBytes);
+	// returns the entry's bytes
+	std::vector<uint8_t> erase(std::list<Entry>::iterator entry);
+	void evict();
+private:
+	JobSystem& mJobs;
+	size_t mBudget;
+
+	// most recently stored first, indexed by packed position
+	std::list<Entry> mEntries;
+	std::unordered_map<uint64_t, std::list<Entry>::iterator> mIndex;
+	// the newest compression in flight of each chunk, an older one finishing later is dropped
+	std::unordered_map<uint64_t, uint64_t> mInFlight;
+	uint64_t mNextTicket = 0;
+	size_t mBytes = 0;
+	size_t mDecodedBytes = 0;
+	size_t mPeakBytes = 0;
+
+	uint64_t mStored = 0;
+	uint64_t mStale = 0;
+	uint64_t mLookups = 0;
+	uint64_t mHits = 0;
+	uint64_t mEvictions = 0;
+	uint64_t mEncodeNs = 0;
+	mutable std::atomic<uint64_t> mDecodeNs{ 0 };
+	mutable std::atomic<uint64_t> mCorrupt{ 0 };
+};
\ No newline at end of file
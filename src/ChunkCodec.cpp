@@ -0,0 +1,207 @@
+#include "ChunkCodec.h"
+#include <array>
+#include <bit>
+#include <cstring>
+
+static void writeVarint(std::vector<uint8_t>& out, uint32_t value)
+{
+	while (value >= 0x80)
+	{
+		out.push_back(static_cast<uint8_t>(value | 0x80));
+		value >>= 7;
+	}
+	out.push_back(static_cast<uint8_t>(value));
+}
+
+// Bounds-checked reads, a read past the end fails the reader and returns 0 from then on
+class ByteReader
+{
+public:
+	ByteReader(const uint8_t* bytes, size_t size)
+		:mBytes(bytes), mEnd(bytes + size)
+	{
+	}
+
+	uint8_t readByte()
+	{
+		if (mBytes == mEnd)
+		{
+			mFailed = true;
+			return 0;
+		}
+		return *mBytes++;
+	}
+
+	uint32_t readVarint()
+	{
+		uint32_t value = 0;
+		for (int shift = 0; shift < 35; shift += 7)
+		{
+			const uint8_t byte = readByte();
+			value |= static_cast<uint32_t>(byte & 0x7F) << shift;
+			if (!(byte & 0x80)) return value;
+		}
+		mFailed = true;
+		return 0;
+	}
+
+	bool failed() const
+	{
+		return mFailed;
+	}
+
+	bool atEnd() const
+	{
+		return mBytes == mEnd;
+	}
+private:
+	const uint8_t* mBytes;
+	const uint8_t* mEnd;
+	bool mFailed = false;
+};
+
+static void encodeSection(const ChunkSection& section, std::vector<uint8_t>& out)
+{
+	out.push_back(static_cast<uint8_t>(section.getType()));
+	if (section.getType() == UNIFORM)
+		out.push_back(section.getUniformBlock());
+	if (section.getType() != MIXED) return;
+
+	// the section's own palette and indices, so neither side has to build one
+	const uint32_t paletteSize = section.getPaletteSize();
+	out.push_back(static_cast<uint8_t>(paletteSize - 1));
+	for (uint32_t i = 0; i < paletteSize; i++)
+		out.push_back(section.getPaletteEntry(i));
+
+	std::array<uint8_t, SECTIONVOLUME> indices;
+	section.getPaletteIndices(indices.data());
+	const uint32_t indexBits = std::bit_width(paletteSize - 1);
+	for (uint32_t i = 0; i < SECTIONVOLUME;)
+	{
+		uint32_t end = i + 1;
+		while (end < SECTIONVOLUME && indices[end] == indices[i])
+			end++;
+		writeVarint(out, (end - i - 1) << indexBits | indices[i]);
+		i = end;
+	}
+}
+
+static bool decodeSection(ByteReader& reader, ChunkSection& section)
+{
+	const uint8_t type = reader.readByte();
+	if (type == EMPTY)
+	{
+		section.fill(AIR);
+		return !reader.failed();
+	}
+	if (type == UNIFORM)
+	{
+		section.fill(reader.readByte());
+		return !reader.failed();
+	}
+	if (type != MIXED) return false;
+
+	const uint32_t paletteSize = reader.readByte() + 1u;
+	std::array<uint8_t, 256> palette;
+	std::array<bool, 256> listed{};
+	for (uint32_t i = 0; i < paletteSize; i++)
+	{
+		palette[i] = reader.readByte();
+		if (listed[palette[i]]) return false;
+		listed[palette[i]] = true;
+	}
+
+	// padded so runs of up to 16, most of those in caves and along the surface, are two stores and no memset
+	std::array<uint8_t, SECTIONVOLUME + 16> indices;
+	const uint32_t indexBits = std::bit_width(paletteSize - 1);
+	for (uint32_t i = 0; i < SECTIONVOLUME;)
+	{
+		const uint32_t run = reader.readVarint();
+		const uint32_t length = (run >> indexBits) + 1;
+		const uint8_t index = static_cast<uint8_t>(run & ((1u << indexBits) - 1));
+		if (reader.failed() || length > SECTIONVOLUME - i || index >= paletteSize) return false;
+
+		if (length <= 16)
+		{
+			const uint64_t pattern = index * 0x0101010101010101ull;
+			memcpy(indices.data() + i, &pattern, 8);
+			memcpy(indices.data() + i + 8, &pattern, 8);
+		}
+		else
+			memset(indices.data() + i, index, length);
+		i += length;
+	}
+
+	section.assignPalette(palette.data(), paletteSize, indices.data());
+	return true;
+}
+
+template<typename Dims>
+void encodeChunk(const BasicChunkData<Dims>& data, std::vector<uint8_t>& out)
+{
+	for (int section = 0; section < Dims::SECTIONCOUNT; section++)
+		encodeSection(data.getSection(section), out);
+
+	// neighbouring columns are rarely more than a block or two apart, zigzagged to stay small
+	int previous = 0;
+	for (int x = 0; x < Dims::SIZE; x++)
+		for (int z = 0; z < Dims::SIZE; z++)
+		{
+			const int delta = data.getSurface(x, z) - previous;
+			writeVarint(out, static_cast<uint32_t>(delta << 1) ^ static_cast<uint32_t>(delta >> 31));
+			previous = data.getSurface(x, z);
+		}
+
+	for (int i = 0; i < Dims::SIZE * Dims::SIZE;)
+	{
+		const uint8_t biome = data.getBiome(i / Dims::SIZE, i % Dims::SIZE);
+		int end = i + 1;
+		while (end < Dims::SIZE * Dims::SIZE && data.getBiome(end / Dims::SIZE, end % Dims::SIZE) == biome)
+			end++;
+		writeVarint(out, static_cast<uint32_t>(end - i - 1) << 8 | biome);
+		i = end;
+	}
+}
+
+template<typename Dims>
+bool decodeChunk(const uint8_t* bytes, size_t size, BasicChunkData<Dims>& data)
+{
+	ByteReader reader(bytes, size);
+
+	for (int sectionY = 0; sectionY < Dims::SECTIONSY; sectionY++)
+		for (int sectionX = 0; sectionX < Dims::SECTIONSXZ; sectionX++)
+			for (int sectionZ = 0; sectionZ < Dims::SECTIONSXZ; sectionZ++)
+				if (!decodeSection(reader, data.getSection(sectionX, sectionY, sectionZ)))
+					return false;
+
+	std::array<int16_t, Dims::SIZE * Dims::SIZE> surface;
+	int previous = 0;
+	for (int i = 0; i < Dims::SIZE * Dims::SIZE; i++)
+	{
+		const uint32_t zigzag = reader.readVarint();
+		previous += static_cast<int>(zigzag >> 1) ^ -static_cast<int>(zigzag & 1);
+		surface[i] = static_cast<int16_t>(previous);
+	}
+
+	for (int i = 0; i < Dims::SIZE * Dims::SIZE;)
+	{
+		const uint32_t run = reader.readVarint();
+		const uint32_t length = (run >> 8) + 1;
+		if (reader.failed() || length > static_cast<uint32_t>(Dims::SIZE * Dims::SIZE - i)) return false;
+
+		for (uint32_t j = 0; j < length; j++, i++)
+			data.setColumn(i / Dims::SIZE, i % Dims::SIZE, surface[i], static_cast<uint8_t>(run));
+	}
+
+	// trailing bytes mean the chunk was written by something else
+	return !reader.failed() && reader.atEnd();
+}
+
+template void encodeChunk<ChunkDimensions<16, 64>>(const BasicChunkData<ChunkDimensions<16, 64>>&, std::vector<uint8_t>&);
+template void encodeChunk<ChunkDimensions<16, 256>>(const BasicChunkData<ChunkDimensions<16, 256>>&, std::vector<uint8_t>&);
+template void encodeChunk<ChunkDimensions<32, 64>>(const BasicChunkData<ChunkDimensions<32, 64>>&, std::vector<uint8_t>&);
+template void encodeChunk<ChunkDimensions<32, 384>>(const BasicChunkData<ChunkDimensions<32, 384>>&, std::vector<uint8_t>&);
+template bool decodeChunk<ChunkDimensions<16, 64>>(const uint8_t*, size_t, BasicChunkData<ChunkDimensions<16, 64>>&);
+template bool decodeChunk<ChunkDimensions<16, 256>>(const uint8_t*, size_t, BasicChunkData<ChunkDimensions<16, 256>>&);
+template bool decodeChunk<ChunkDimensions<32, 64>>(const uint8_t*, size_t, BasicChunkData<ChunkDimensions<32, 64>>&);
+template bool decodeChunk<ChunkDimensions<32, 384>>(const uint8_t*, size_t, BasicChunkData<ChunkDimensions<32, 384>>&);
\ No newline at end of file
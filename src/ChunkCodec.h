@@ -0,0 +1,19 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "World.h"
+
+// Serialised chunks, as stored in region files. Every section is written as its
+// type, and MIXED ones as their palette followed by runs of palette indices in
+// SectionLayout order. Each run is a single varint, the length - 1 shifted left by
+// the bits a palette index needs, so on generated terrain most runs take one or two
+// bytes. The surface heights follow as varint deltas and the biomes as runs.
+
+// appends data's encoding to out
+template<typename Dims>
+void encodeChunk(const BasicChunkData<Dims>& data, std::vector<uint8_t>& out);
+
+// false if bytes is truncated or corrupt, data is then partly overwritten
+template<typename Dims>
+bool decodeChunk(const uint8_t* bytes, size_t size, BasicChunkData<Dims>& data);
\ No newline at end of file
@@ -0,0 +1,589 @@
+#include "ChunkManager.h"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <exception>
+#include <string>
+
+// chunk coordinate offset of the neighbour on each horizontal side, (x, z)
+static const std::array<glm::ivec2, BORDERMESHES> NEIGHBOUROFFSETS = { {
+	{ 0, -1 }, // FRONT
+	{ 0, 1 },  // BACK
+	{ 1, 0 },  // RIGHT
+	{ -1, 0 }, // LEFT
+} };
+
+static uint64_t packPosition(glm::ivec2 position)
+{
+	return static_cast<uint64_t>(static_cast<uint32_t>(position.x)) << 32 | static_cast<uint32_t>(position.y);
+}
+
+// the chunk holding a block, rounding towards negative infinity
+static glm::ivec2 getChunkPosition(glm::ivec3 position)
+{
+	auto chunkCoordinate = [](int block)
+	{
+		return (block >= 0 ? block : block - CHUNKSIZE + 1) / CHUNKSIZE;
+	};
+	return glm::ivec2(chunkCoordinate(position.x), chunkCoordinate(position.z));
+}
+
+ChunkManager::ChunkManager(JobSystem& jobs, int renderDistance, uint32_t seed)
+	:mJobs(jobs), mScheduler(jobs), mGenerator(seed), mIO(&jobs), mStorage(std::filesystem::path(SAVEDIRECTORY) / ("world-" + std::to_string(seed)), mIO), mEditLog(mStorage.getDirectory()), mAutosave(mStorage, jobs), mCache(jobs), mRenderDistance(0), mGridSize(0)
+{
+	setRenderDistance(renderDistance);
+
+	// edits made since the last autosave before a crash
+	mEditLog.replay([this](const BlockEdit& edit)
+	{
+		mRecovered[packPosition(edit.chunk)].push_back(edit);
+	});
+}
+
+void ChunkManager::update(const Camera& camera)
+{
+	const glm::vec3 cameraPosition = camera.getPosition();
+	const glm::ivec2 centre(static_cast<int>(std::floor(cameraPosition.x / CHUNKSIZE)), static_cast<int>(std::floor(cameraPosition.z / CHUNKSIZE)));
+
+	if (!mCentreValid || centre != mCentre)
+	{
+		mCentre = centre;
+		mCentreValid = true;
+
+		for (ManagedChunk* managed : mGrid)
+			if (managed && !inLoadRange(managed->chunk.getPosition()))
+				unload(managed);
+
+		for (const glm::ivec2& offset : mLoadOrder)
+			if (!find(mCentre + offset))
+				load(mCentre + offset);
+	}
+
+	// all edits since the last update in one mesh per chunk
+	for (ManagedChunk* managed : mEdited)
+		linkNeighbours(managed);
+	mEdited.clear();
+
+	mScheduler.dispatch(camera);
+	recycleRetired();
+	// the chunk versions no mesh job reads anymore
+	EpochDomain::get().collect();
+	if (mAutosave.isDue())
+		autosave();
+}
+
+void ChunkManager::setRenderDistance(int renderDistance)
+{
+	mRenderDistance = std::max(renderDistance, 1);
+
+	const int loadDistance = mRenderDistance + GENERATION_MARGIN;
+	mLoadOrder.clear();
+	for (int x = -loadDistance; x <= loadDistance; x++)
+		for (int z = -loadDistance; z <= loadDistance; z++)
+			if (isLoadOffset({ x, z }))
+				mLoadOrder.push_back({ x, z });
+	std::stable_sort(mLoadOrder.begin(), mLoadOrder.end(), [](const glm::ivec2& a, const glm::ivec2& b)
+	{
+		return a.x * a.x + a.y * a.y < b.x * b.x + b.y * b.y;
+	});
+
+	std::vector<ManagedChunk*> loaded;
+	for (ManagedChunk* managed : mGrid)
+		if (managed) loaded.push_back(managed);
+
+	// one spare row so the row being unloaded never shares slots with the row being loaded
+	mGridSize = static_cast<int>(std::bit_ceil(static_cast<unsigned>(loadDistance * 2 + 2)));
+	mGrid.assign(mGridSize * mGridSize, nullptr);
+	mLoadedCount = static_cast<uint32_t>(loaded.size());
+
+	// place everything that stays before unloading the rest, so their neighbours unlink
+	std::vector<ManagedChunk*> dropped;
+	for (ManagedChunk* managed : loaded)
+	{
+		ManagedChunk*& slot = mGrid[slotIndex(managed->chunk.getPosition())];
+		if (slot || (mCentreValid && !inLoadRange(managed->chunk.getPosition())))
+			dropped.push_back(managed);
+		else
+			slot = managed;
+	}
+	for (ManagedChunk* managed : dropped)
+		unload(managed);
+
+	// a bigger radius has new chunks to load on the next update
+	mCentreValid = false;
+}
+
+int ChunkManager::getRenderDistance() const
+{
+	return mRenderDistance;
+}
+
+void ChunkManager::Render(VkCommandBuffer commandBuffer, VkPipelineLayout pipelineLayout)
+{
+	for (ManagedChunk* managed : mGrid)
+		if (managed && (managed->state == MESHED || managed->state == MESHING))
+			managed->chunk.Render(commandBuffer, pipelineLayout);
+}
+
+void ChunkManager::finishIO()
+{
+	autosave();
+	mAutosave.stop();
+	mEditLog.close();
+	mStorage.waitIdle();
+	mIO.stop();
+}
+
+void ChunkManager::destroy()
+{
+	for (auto& managed : mChunks)
+		managed->chunk.destroyChunk();
+
+	mGrid.assign(mGrid.size(), nullptr);
+	mLoadedCount = 0;
+	mCentreValid = false;
+	mFree.clear();
+	mRetired.clear();
+	mChunks.clear();
+	EpochDomain::get().collect();
+}
+
+uint8_t ChunkManager::getBlock(glm::ivec3 position) const
+{
+	if (position.y < 0 || position.y >= CHUNKHEIGHT) return AIR;
+
+	const glm::ivec2 chunk = getChunkPosition(position);
+	const ManagedChunk* managed = find(chunk);
+	if (!managed || managed->state == GENERATING) return AIR;
+
+	return managed->chunk.getData().getBlock(position - glm::ivec3(chunk.x * CHUNKSIZE, 0, chunk.y * CHUNKSIZE));
+}
+
+bool ChunkManager::setBlock(glm::ivec3 position, uint8_t block)
+{
+	if (position.y < 0 || position.y >= CHUNKHEIGHT) return false;
+
+	const glm::ivec2 chunk = getChunkPosition(position);
+	ManagedChunk* managed = find(chunk);
+	if (!managed || managed->state == GENERATING) return false;
+	if (getBlock(position) == block) return true;
+
+	const BlockEdit edit{ chunk, position - glm::ivec3(chunk.x * CHUNKSIZE, 0, chunk.y * CHUNKSIZE), block };
+	mEditLog.append(edit);
+	applyEdit(managed, edit);
+	return true;
+}
+
+Chunk* ChunkManager::getChunk(glm::ivec2 position) const
+{
+	ManagedChunk* managed = find(position);
+	return managed ? &managed->chunk : nullptr;
+}
+
+uint32_t ChunkManager::getLoadedCount() const
+{
+	return mLoadedCount;
+}
+
+uint32_t ChunkManager::getPooledCount() const
+{
+	return static_cast<uint32_t>(mFree.size());
+}
+
+const ChunkScheduler& ChunkManager::getScheduler() const
+{
+	return mScheduler;
+}
+
+const WorldGenerator& ChunkManager::getGenerator() const
+{
+	return mGenerator;
+}
+
+const RegionStorage& ChunkManager::getStorage() const
+{
+	return mStorage;
+}
+
+const Autosave& ChunkManager::getAutosave() const
+{
+	return mAutosave;
+}
+
+const EditLog& ChunkManager::getEditLog() const
+{
+	return mEditLog;
+}
+
+const ChunkCache& ChunkManager::getCache() const
+{
+	return mCache;
+}
+
+int ChunkManager::slotIndex(glm::ivec2 position) const
+{
+	// the grid size is a power of two, so masking wraps negative coordinates too
+	const int mask = mGridSize - 1;
+	return (position.x & mask) * mGridSize + (position.y & mask);
+}
+
+ManagedChunk* ChunkManager::find(glm::ivec2 position) const
+{
+	ManagedChunk* managed = mGrid[slotIndex(position)];
+	return managed && managed->chunk.getPosition() == position ? managed : nullptr;
+}
+
+bool ChunkManager::inRange(glm::ivec2 position) const
+{
+	const glm::ivec2 offset = position - mCentre;
+	return offset.x * offset.x + offset.y * offset.y <= mRenderDistance * mRenderDistance;
+}
+
+bool ChunkManager::inLoadRange(glm::ivec2 position) const
+{
+	return isLoadOffset(position - mCentre);
+}
+
+bool ChunkManager::isLoadOffset(glm::ivec2 offset) const
+{
+	// every neighbour a chunk in range waits for, diagonals included
+	for (int dx = -GENERATION_MARGIN; dx <= GENERATION_MARGIN; dx++)
+		for (int dz = -GENERATION_MARGIN; dz <= GENERATION_MARGIN; dz++)
+		{
+			const glm::ivec2 neighbour = offset + glm::ivec2(dx, dz);
+			if (neighbour.x * neighbour.x + neighbour.y * neighbour.y <= mRenderDistance * mRenderDistance)
+				return true;
+		}
+	return false;
+}
+
+void ChunkManager::load(glm::ivec2 position)
+{
+	ManagedChunk* managed;
+	if (!mFree.empty())
+	{
+		managed = mFree.back();
+		mFree.pop_back();
+	}
+	else
+	{
+		mChunks.push_back(std::make_unique<ManagedChunk>());
+		managed = mChunks.back().get();
+	}
+
+	managed->chunk.reset(position);
+	managed->state = GENERATING;
+	managed->retired = false;
+	managed->cancelled = false;
+	managed->jobRefs = 0;
+	managed->generatedStages = 0;
+	managed->stageQueued = false;
+	managed->stored = false;
+	managed->dirty = false;
+
+	ManagedChunk*& slot = mGrid[slotIndex(position)];
+	if (slot) unload(slot);
+	slot = managed;
+	mLoadedCount++;
+
+	readChunk(managed);
+}
+
+void ChunkManager::readChunk(ManagedChunk* managed)
+{
+	const glm::ivec2 position = managed->chunk.getPosition();
+	// taken even when the autosave has it, the cache must not keep a copy the chunk's
+	// edits make stale before it unloads again
+	std::shared_ptr<std::vector<uint8_t>> cached = std::make_shared<std::vector<uint8_t>>();
+	const bool isCached = mCache.take(position, *cached);
+
+	// unloaded and loaded again before the autosave wrote it, sharing beats decoding
+	if (mAutosave.restore(position, managed->chunk.getData()))
+	{
+		managed->stored = true;
+		managed->generatedStages = GENERATIONSTAGES;
+		stageCompleted(managed);
+		return;
+	}
+
+	managed->stageQueued = true;
+	managed->jobRefs++;
+	if (!isCached)
+	{
+		streamChunk(managed);
+		return;
+	}
+
+	// if it unloads before the job runs, it is still saved or being saved
+	mScheduler.request(position, managed->cancelled, [this, managed, cached]
+	{
+		mCache.decode(*cached, managed->chunk.getData());
+		if (SECTION_DEDUPLICATION)
+			managed->chunk.getData().deduplicate();
+	}, [this, managed](std::exception_ptr error)
+	{
+		if (managed->retired)
+		{
+			managed->jobRefs--;
+			managed->stageQueued = false;
+			return;
+		}
+		// a cache entry that does not decode is dropped like a corrupt stored chunk, the
+		// chunk is read from its region or generated again. The job's refs carry over
+		if (error)
+		{
+			streamChunk(managed);
+			return;
+		}
+
+		managed->jobRefs--;
+		managed->stageQueued = false;
+		managed->stored = true;
+		managed->generatedStages = GENERATIONSTAGES;
+		stageCompleted(managed);
+	});
+}
+
+DetachedTask ChunkManager::streamChunk(ManagedChunk* managed)
+{
+	// reads are not ranked by the scheduler, load already issues them nearest first
+	std::exception_ptr error;
+	try
+	{
+		if (!managed->cancelled.load(std::memory_order_relaxed))
+			managed->stored = co_await mStorage.readChunk(managed->chunk.getPosition(), managed->chunk.getData());
+		if (SECTION_DEDUPLICATION && managed->stored)
+			managed->chunk.getData().deduplicate();
+	}
+	catch (...)
+	{
+		error = std::current_exception();
+	}
+
+	mJobs.complete([this, managed, error]
+	{
+		managed->jobRefs--;
+		managed->stageQueued = false;
+		if (error) std::rethrow_exception(error);
+		if (managed->retired) return;
+
+		if (managed->stored)
+		{
+			managed->generatedStages = GENERATIONSTAGES;
+			stageCompleted(managed);
+		}
+		else
+			advanceGeneration(managed);
+	});
+}
+
+void ChunkManager::advanceGeneration(ManagedChunk* managed)
+{
+	if (managed->retired || managed->stageQueued || managed->generatedStages == GENERATIONSTAGES) return;
+
+	const GENERATIONSTAGE stage = static_cast<GENERATIONSTAGE>(managed->generatedStages);
+	const GenerationStageInfo& info = GENERATIONSTAGEINFO[stage];
+	const glm::ivec2 position = managed->chunk.getPosition();
+
+	// the stage reads these neighbours, keep them out of the pool until it is done
+	std::array<ManagedChunk*, GENERATIONNEIGHBOURS> readers{};
+	GenerationNeighbours<WorldDimensions> neighbours{};
+	for (int dx = -info.neighbourRadius; dx <= info.neighbourRadius; dx++)
+		for (int dz = -info.neighbourRadius; dz <= info.neighbourRadius; dz++)
+		{
+			if (dx == 0 && dz == 0) continue;
+			ManagedChunk* neighbour = find(position + glm::ivec2(dx, dz));
+			if (!neighbour || neighbour->generatedStages < info.neighbourStages) return;
+
+			readers[getGenerationNeighbourIndex(dx, dz)] = neighbour;
+			neighbours[getGenerationNeighbourIndex(dx, dz)] = &neighbour->chunk.getData();
+		}
+	neighbours[getGenerationNeighbourIndex(0, 0)] = &managed->chunk.getData();
+
+	for (ManagedChunk* reader : readers)
+		if (reader) reader->jobRefs++;
+	managed->stageQueued = true;
+	managed->jobRefs++;
+
+	mScheduler.request(position, managed->cancelled, [this, managed, stage, position, neighbours]
+	{
+		mGenerator.runStage(stage, position, managed->chunk.getData(), neighbours);
+		// sections identical to those of chunks generated before share their storage
+		if (SECTION_DEDUPLICATION && stage == GENERATIONSTAGES - 1)
+			managed->chunk.getData().deduplicate();
+	}, [this, managed, readers](std::exception_ptr error)
+	{
+		for (ManagedChunk* reader : readers)
+			if (reader) reader->jobRefs--;
+		managed->jobRefs--;
+		managed->stageQueued = false;
+		if (error) std::rethrow_exception(error);
+		if (managed->retired) return;
+
+		managed->generatedStages++;
+		if (managed->generatedStages == GENERATIONSTAGES)
+			managed->dirty = true;
+		stageCompleted(managed);
+	});
+}
+
+void ChunkManager::stageCompleted(ManagedChunk* managed)
+{
+	const glm::ivec2 position = managed->chunk.getPosition();
+	if (managed->generatedStages == GENERATIONSTAGES)
+	{
+		applyRecovered(managed);
+		managed->state = GENERATED;
+		linkNeighbours(managed);
+		for (const glm::ivec2& offset : NEIGHBOUROFFSETS)
+			if (ManagedChunk* neighbour = find(position + offset))
+				linkNeighbours(neighbour);
+	}
+	else
+		advanceGeneration(managed);
+
+	// neighbours may have been waiting for this stage
+	for (int dx = -GENERATION_MARGIN; dx <= GENERATION_MARGIN; dx++)
+		for (int dz = -GENERATION_MARGIN; dz <= GENERATION_MARGIN; dz++)
+			if (ManagedChunk* neighbour = (dx || dz) ? find(position + glm::ivec2(dx, dz)) : nullptr)
+				advanceGeneration(neighbour);
+}
+
+void ChunkManager::unload(ManagedChunk* managed)
+{
+	const glm::ivec2 position = managed->chunk.getPosition();
+	ManagedChunk*& slot = mGrid[slotIndex(position)];
+	if (slot == managed) slot = nullptr;
+
+	// its jobs only read it now, the snapshots share the data they read
+	if (managed->dirty)
+	{
+		mAutosave.save(position, managed->chunk.getData());
+		managed->dirty = false;
+	}
+	// chunks not generated yet are cheaper to generate again than to keep
+	if (managed->state != GENERATING)
+		mCache.store(position, managed->chunk.getData());
+
+	managed->retired = true;
+	managed->cancelled = true;
+	mRetired.push_back(managed);
+	mLoadedCount--;
+
+	// chunks meshing right now read the version of it they pinned
+	for (const glm::ivec2& offset : NEIGHBOUROFFSETS)
+		if (ManagedChunk* neighbour = find(position + offset))
+			linkNeighbours(neighbour);
+}
+
+void ChunkManager::autosave()
+{
+	// the snapshots hold every edit logged before the checkpoint, except those of
+	// recovered chunks that have not loaded yet, which move on to the new segment
+	const uint32_t checkpoint = mEditLog.checkpoint();
+	for (const auto& [key, edits] : mRecovered)
+		for (const BlockEdit& edit : edits)
+			mEditLog.append(edit);
+
+	for (ManagedChunk* managed : mGrid)
+		if (managed && managed->dirty)
+		{
+			mAutosave.save(managed->chunk.getPosition(), managed->chunk.getData());
+			managed->dirty = false;
+		}
+	// chunks unloaded since the last autosave were snapshotted then, ahead of this
+	mAutosave.checkpoint([this, checkpoint] { mEditLog.compact(checkpoint); });
+}
+
+void ChunkManager::applyRecovered(ManagedChunk* managed)
+{
+	auto it = mRecovered.find(packPosition(managed->chunk.getPosition()));
+	if (it == mRecovered.end()) return;
+
+	// nothing meshes the chunk yet, and the neighbours' generation stages only read
+	// its surface and biomes
+	for (const BlockEdit& edit : it->second)
+		managed->chunk.getData().setBlock(edit.position, edit.type);
+	mRecovered.erase(it);
+	// the edits are in the log until the next autosave has saved the chunk
+	managed->dirty = true;
+}
+
+void ChunkManager::applyEdit(ManagedChunk* managed, const BlockEdit& edit)
+{
+	// mesh jobs read published versions and neighbours' generation stages only the
+	// surface and biomes, so nothing in flight reads what this changes
+	const uint32_t neighbours = managed->chunk.setBlock(edit.position, edit.type);
+	// saved by the next autosave, the log holds the edit until then
+	managed->dirty = true;
+
+	mEdited.push_back(managed);
+	for (int side = 0; side < BORDERMESHES; side++)
+		if (neighbours & (1u << side))
+			if (ManagedChunk* neighbour = find(managed->chunk.getPosition() + NEIGHBOUROFFSETS[side]))
+				mEdited.push_back(neighbour);
+}
+
+void ChunkManager::linkNeighbours(ManagedChunk* managed)
+{
+	if (managed->retired || managed->state == GENERATING) return;
+
+	const glm::ivec2 position = managed->chunk.getPosition();
+	for (int side = 0; side < BORDERMESHES; side++)
+	{
+		ManagedChunk* neighbour = find(position + NEIGHBOUROFFSETS[side]);
+		const bool hasData = neighbour && neighbour->state != GENERATING;
+		managed->chunk.setNeighbour(static_cast<BLOCKFACE>(side), hasData ? &neighbour->chunk : nullptr);
+	}
+
+	scheduleMesh(managed);
+}
+
+void ChunkManager::scheduleMesh(ManagedChunk* managed)
+{
+	// one mesh job at a time, the completion schedules the next
+	if (managed->state == MESHING) return;
+	const glm::ivec2 position = managed->chunk.getPosition();
+
+	// the first mesh waits for the neighbours that will load, so it is built only once
+	if (managed->state == GENERATED)
+		for (const glm::ivec2& offset : NEIGHBOUROFFSETS)
+		{
+			ManagedChunk* neighbour = find(position + offset);
+			if (inRange(position + offset) && (!neighbour || neighbour->state == GENERATING))
+				return;
+		}
+
+	if (!managed->chunk.needsMesh()) return;
+
+	// the job reads the versions pinned here, the neighbours may be edited, unloaded
+	// and reused meanwhile
+	managed->chunk.prepareMesh();
+	managed->state = MESHING;
+	managed->jobRefs++;
+
+	mScheduler.request(position, managed->cancelled, [managed] { managed->chunk.buildMesh(); }, [this, managed](std::exception_ptr error)
+	{
+		managed->jobRefs--;
+		if (error) std::rethrow_exception(error);
+		if (managed->retired) return;
+
+		managed->chunk.uploadMesh();
+		managed->state = MESHED;
+		// neighbours may have come or gone while it was meshing
+		linkNeighbours(managed);
+	});
+}
+
+void ChunkManager::recycleRetired()
+{
+	auto done = std::partition(mRetired.begin(), mRetired.end(), [](ManagedChunk* managed) { return managed->jobRefs > 0; });
+
+	for (auto it = done; it != mRetired.end(); it++)
+	{
+		// meshes go back to the GPU buffer pool, the chunk and its ChunkData to ours
+		(*it)->chunk.destroyChunk();
+		mFree.push_back(*it);
+	}
+	mRetired.erase(done, mRetired.end());
+}
\ No newline at end of file
@@ -0,0 +1,165 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <glm/glm.hpp>
+#include "World.h"
+#include "WorldGenerator.h"
+#include "RegionFile.h"
+#include "AsyncIO.h"
+#include "Autosave.h"
+#include "ChunkCache.h"
+#include "EditLog.h"
+#include "Task.h"
+#include "JobSystem.h"
+#include "ChunkScheduler.h"
+#include "Camera.h"
+
+// chunks kept loaded around the camera, in chunks
+constexpr int RENDERDISTANCE = 6;
+// the same seed always generates the same world
+constexpr uint32_t WORLDSEED = 1337;
+// worlds are saved in a directory per seed under this one
+constexpr const char* SAVEDIRECTORY = "saves";
+
+enum CHUNKSTATE {
+	GENERATING, // world generation stages still to run
+	GENERATED,  // data ready, waiting for its neighbours before the first mesh
+	MESHING,    // buildMesh job in flight
+	MESHED
+};
+
+// A chunk and the manager's bookkeeping for it. Unloaded chunks go back to the
+// manager's pool with their ChunkData and are reset for the next position.
+struct ManagedChunk
+{
+	Chunk chunk;
+	CHUNKSTATE state = GENERATING;
+	// jobs in flight that read this chunk: its own generation and meshing and its
+	// neighbours' generation stages. Meshing neighbours read its published version
+	uint32_t jobRefs = 0;
+	// world generation stages completed, a stage or load job is in flight while stageQueued
+	int generatedStages = 0;
+	bool stageQueued = false;
+	// set when the chunk was read from the region files, an unwritten autosave snapshot or the cache
+	bool stored = false;
+	// changed since it was last saved, saved by the next autosave or when unloaded
+	bool dirty = false;
+	// unloaded, returns to the pool once no job reads it anymore
+	bool retired = false;
+	// set with retired, read by workers to skip its queued work
+	std::atomic<bool> cancelled{ false };
+};
+
+// Keeps every chunk within the render distance of the camera loaded. Chunks live in
+// a toroidal grid, a power of two square indexed by chunk coordinate modulo its
+// size: lookups are a mask and no hashing, and the grid follows the camera without
+// moving anything. Chunks saved before are read from the region files, the others
+// run the WorldGenerator stages as soon as their neighbours have got far enough, so
+// a GENERATION_MARGIN ring of chunks beyond the render distance is loaded too.
+// With SECTION_DEDUPLICATION, generated and read chunks intern their sections, so
+// sections identical across chunks share storage until one of them changes.
+// Generated chunks are saved by the Autosave every AUTOSAVE_INTERVAL or when they
+// unload, block edits in between are kept in the EditLog, which each autosave
+// compacts. Edits the log still held at startup are applied as their chunks load.
+// Blocks are changed through setBlock, which marks only the sections whose faces
+// can change, so the chunk's next mesh rebuilds just those; a frame's edits are
+// published and meshed together on the next update. Mesh jobs read the versions of
+// the chunk and its neighbours pinned when they were queued, so edits apply at once
+// even while they run; old versions are freed from update once no job reads them.
+// Chunks that unload after they were generated are kept compressed in a ChunkCache,
+// so those just beyond the edge decode again when the camera turns back, instead of
+// being read or generated. Region files are read and written asynchronously, the
+// workers only decode. All members must be called from the render thread.
+class ChunkManager
+{
+public:
+	ChunkManager(JobSystem& jobs, int renderDistance = RENDERDISTANCE, uint32_t seed = WORLDSEED);
+
+	ChunkManager(const ChunkManager&) = delete;
+	ChunkManager& operator=(const ChunkManager&) = delete;
+
+	// loads and unloads chunks around the camera and hands their work to the
+	// scheduler, call once per frame
+	void update(const Camera& camera);
+	void setRenderDistance(int renderDistance);
+	int getRenderDistance() const;
+	void Render(VkCommandBuffer commandBuffer, VkPipelineLayout pipelineLayout);
+	// saves every changed chunk and waits until it, the edit log and all other I/O are
+	// done, call before stopping the job system
+	void finishIO();
+	// frees every chunk's meshes, the job system must be stopped first
+	void destroy();
+
+	// the block at a world position, AIR where no chunk is loaded or generated yet
+	uint8_t getBlock(glm::ivec3 position) const;
+	// changes the block at a world position and logs it, false where no chunk is
+	// loaded or generated yet. The chunk and the neighbours it borders on are meshed
+	// again on the next update, or once the mesh being built of them is done
+	bool setBlock(glm::ivec3 position, uint8_t block);
+	// nullptr unless the chunk is loaded
+	Chunk* getChunk(glm::ivec2 position) const;
+	uint32_t getLoadedCount() const;
+	uint32_t getPooledCount() const;
+	const ChunkScheduler& getScheduler() const;
+	const WorldGenerator& getGenerator() const;
+	const RegionStorage& getStorage() const;
+	const Autosave& getAutosave() const;
+	const EditLog& getEditLog() const;
+	const ChunkCache& getCache() const;
+private:
+	int slotIndex(glm::ivec2 position) const;
+	ManagedChunk* find(glm::ivec2 position) const;
+	// within the render distance
+	bool inRange(glm::ivec2 position) const;
+	// within the render distance or the generation margin around it
+	bool inLoadRange(glm::ivec2 position) const;
+	// the same for an offset from the centre
+	bool isLoadOffset(glm::ivec2 offset) const;
+	void load(glm::ivec2 position);
+	// decodes the chunk from the cache or reads it from the region files, generating it
+	// if it is in neither
+	void readChunk(ManagedChunk* managed);
+	DetachedTask streamChunk(ManagedChunk* managed);
+	// snapshots every loaded chunk with changes for the Autosave, and compacts the
+	// edit log once they are saved
+	void autosave();
+	// the edits replayed from the log for the chunk, once it is generated or read
+	void applyRecovered(ManagedChunk* managed);
+	void applyEdit(ManagedChunk* managed, const BlockEdit& edit);
+	void unload(ManagedChunk* managed);
+	// queues the chunk's next generation stage if its neighbours are ready for it
+	void advanceGeneration(ManagedChunk* managed);
+	// after a stage completed or the chunk was read: the next stage, or linking and meshing once generated
+	void stageCompleted(ManagedChunk* managed);
+	void linkNeighbours(ManagedChunk* managed);
+	void scheduleMesh(ManagedChunk* managed);
+	void recycleRetired();
+private:
+	JobSystem& mJobs;
+	ChunkScheduler mScheduler;
+	WorldGenerator mGenerator;
+	AsyncIO mIO;
+	RegionStorage mStorage;
+	// ahead of the Autosave, which compacts it from checkpoints until it is gone
+	EditLog mEditLog;
+	Autosave mAutosave;
+	ChunkCache mCache;
+	// edits replayed from the log whose chunk has not loaded since, keyed by packed position
+	std::unordered_map<uint64_t, std::vector<BlockEdit>> mRecovered;
+	int mRenderDistance;
+	int mGridSize;
+	std::vector<ManagedChunk*> mGrid;
+	uint32_t mLoadedCount = 0;
+
+	glm::ivec2 mCentre{ 0, 0 };
+	bool mCentreValid = false;
+	// offsets within the load range, nearest first
+	std::vector<glm::ivec2> mLoadOrder;
+
+	std::vector<std::unique_ptr<ManagedChunk>> mChunks; // every chunk ever allocated
+	std::vector<ManagedChunk*> mFree;
+	std::vector<ManagedChunk*> mRetired;
+	// chunks edits marked sections of since the last update
+	std::vector<ManagedChunk*> mEdited;
+};
\ No newline at end of file
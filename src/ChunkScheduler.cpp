@@ -0,0 +1,106 @@
+#include "ChunkScheduler.h"
+#include "World.h"
+#include <algorithm>
+#include <glm/gtc/constants.hpp>
+
+ChunkScheduler::ChunkScheduler(JobSystem& jobs)
+	:mJobs(jobs)
+{
+}
+
+void ChunkScheduler::request(glm::ivec2 chunkPosition, const std::atomic<bool>& cancelled, std::function<void()> work, std::function<void(std::exception_ptr)> completion)
+{
+	mQueued.push_back({ chunkPosition, &cancelled, std::move(work), std::move(completion), 0.0f });
+}
+
+void ChunkScheduler::dispatch(const Camera& camera)
+{
+	// cancelled requests never reach a worker, their completion still releases what they hold
+	for (size_t i = 0; i < mQueued.size();)
+	{
+		if (!mQueued[i].cancelled->load(std::memory_order_relaxed))
+		{
+			i++;
+			continue;
+		}
+
+		std::function<void(std::exception_ptr)> completion = std::move(mQueued[i].completion);
+		mQueued[i] = std::move(mQueued.back());
+		mQueued.pop_back();
+		mCancelled++;
+		if (completion) completion(nullptr);
+	}
+
+	const uint32_t capacity = mJobs.getWorkerCount() * SCHEDULER_JOBS_PER_WORKER;
+	if (mQueued.empty() || mInFlight >= capacity) return;
+
+	const glm::vec3 position = camera.getPosition();
+	const glm::vec3 orientation = camera.getOrientation();
+	const Frustum frustum = camera.getFrustum();
+
+	glm::vec2 direction(orientation.x, orientation.z);
+	if (glm::length(direction) > 0.0f)
+		direction = glm::normalize(direction);
+
+	for (Request& queued : mQueued)
+		queued.priority = rankChunk(queued.chunkPosition, position, direction, frustum);
+
+	// only the requests that fit are ordered, the rest are ranked again next frame
+	const size_t count = std::min<size_t>(capacity - mInFlight, mQueued.size());
+	std::partial_sort(mQueued.begin(), mQueued.begin() + count, mQueued.end(), [](const Request& a, const Request& b)
+	{
+		return a.priority < b.priority;
+	});
+
+	for (size_t i = 0; i < count; i++)
+	{
+		Request& queued = mQueued[i];
+		mInFlight++;
+		mJobs.submit([cancelled = queued.cancelled, work = std::move(queued.work)]
+		{
+			// unloaded after it was submitted, skip the work
+			if (!cancelled->load(std::memory_order_relaxed))
+				work();
+		}, [this, completion = std::move(queued.completion)](std::exception_ptr error)
+		{
+			mInFlight--;
+			if (completion) completion(error);
+			else if (error) std::rethrow_exception(error);
+		});
+	}
+	mQueued.erase(mQueued.begin(), mQueued.begin() + count);
+}
+
+uint32_t ChunkScheduler::getQueuedCount() const
+{
+	return static_cast<uint32_t>(mQueued.size());
+}
+
+uint32_t ChunkScheduler::getInFlightCount() const
+{
+	return mInFlight;
+}
+
+uint32_t ChunkScheduler::getCancelledCount() const
+{
+	return mCancelled;
+}
+
+float ChunkScheduler::rankChunk(glm::ivec2 chunkPosition, glm::vec3 position, glm::vec2 direction, const Frustum& frustum) const
+{
+	const glm::vec3 min(chunkPosition.x * CHUNKSIZE, 0.0f, chunkPosition.y * CHUNKSIZE);
+	const glm::vec3 max = min + glm::vec3(CHUNKSIZE, CHUNKHEIGHT, CHUNKSIZE);
+
+	const glm::vec2 toChunk = glm::vec2(min.x, min.z) + glm::vec2(CHUNKSIZE * 0.5f) - glm::vec2(position.x, position.z);
+	const float distance = glm::length(toChunk) / CHUNKSIZE;
+
+	// 0 straight ahead to 1 straight behind, the chunk the camera stands in has no direction
+	float angle = 0.0f;
+	if (distance > 0.5f)
+		angle = std::acos(std::clamp(glm::dot(toChunk / (distance * CHUNKSIZE), direction), -1.0f, 1.0f)) / glm::pi<float>();
+
+	float priority = distance * (1.0f + SCHEDULER_ANGLE_WEIGHT * angle);
+	if (frustum.intersectsBox(min, max))
+		priority *= SCHEDULER_FRUSTUM_BOOST;
+	return priority;
+}
\ No newline at end of file
@@ -0,0 +1,55 @@
+#pragma once
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <vector>
+#include <glm/glm.hpp>
+#include "JobSystem.h"
+#include "Camera.h"
+
+// a chunk straight behind the camera ranks as if it were this much further away
+constexpr float SCHEDULER_ANGLE_WEIGHT = 1.0f;
+// chunks inside the view frustum rank as if they were this much closer
+constexpr float SCHEDULER_FRUSTUM_BOOST = 0.5f;
+// chunk jobs handed to the job system per worker, the rest wait here so they can be re-ranked
+constexpr uint32_t SCHEDULER_JOBS_PER_WORKER = 2;
+
+// Holds chunk work back from the job system and releases it nearest and most
+// visible first. Requests are ranked again on every dispatch, so the order follows
+// the camera, and requests for chunks that were unloaded meanwhile are cancelled.
+// Render thread only.
+class ChunkScheduler
+{
+public:
+	ChunkScheduler(JobSystem& jobs);
+
+	ChunkScheduler(const ChunkScheduler&) = delete;
+	ChunkScheduler& operator=(const ChunkScheduler&) = delete;
+
+	// work runs on a worker unless cancelled is set first; completion runs on the
+	// render thread either way, so it must cope with the work not having run, and is
+	// handed what the work threw
+	void request(glm::ivec2 chunkPosition, const std::atomic<bool>& cancelled, std::function<void()> work, std::function<void(std::exception_ptr)> completion);
+	// drops cancelled requests and submits the best ranked ones to the job system
+	void dispatch(const Camera& camera);
+
+	uint32_t getQueuedCount() const;
+	uint32_t getInFlightCount() const;
+	uint32_t getCancelledCount() const;
+private:
+	struct Request
+	{
+		glm::ivec2 chunkPosition;
+		const std::atomic<bool>* cancelled;
+		std::function<void()> work;
+		std::function<void(std::exception_ptr)> completion;
+		float priority; // lower runs first
+	};
+
+	float rankChunk(glm::ivec2 chunkPosition, glm::vec3 position, glm::vec2 direction, const Frustum& frustum) const;
+private:
+	JobSystem& mJobs;
+	std::vector<Request> mQueued;
+	uint32_t mInFlight = 0;
+	uint32_t mCancelled = 0;
+};
\ No newline at end of file
@@ -0,0 +1,384 @@
+#include "EditLog.h"
+#include "World.h"
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <stdexcept>
+#include <string>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+static_assert(std::endian::native == std::endian::little, "edit logs are stored little endian");
+static_assert(CHUNKSIZE <= 64 && CHUNKHEIGHT <= 4096, "an edit's position packs into 6 + 6 + 12 bits");
+
+struct EditGroupHeader
+{
+	uint32_t magic;
+	uint32_t count;
+	uint64_t checksum; // of the records
+};
+
+struct EditRecord
+{
+	int32_t chunkX;
+	int32_t chunkZ;
+	uint32_t packed; // x, z, y and the block type, low bits first
+};
+
+// FNV-1a, only has to tell a torn or stale group from a committed one
+static uint64_t checksumRecords(const EditRecord* records, uint32_t count)
+{
+	const uint8_t* bytes = reinterpret_cast<const uint8_t*>(records);
+	uint64_t hash = 0xcbf29ce484222325ull;
+	for (size_t i = 0; i < count * sizeof(EditRecord); i++)
+		hash = (hash ^ bytes[i]) * 0x100000001b3ull;
+	return hash;
+}
+
+static EditRecord packEdit(const BlockEdit& edit)
+{
+	return { edit.chunk.x, edit.chunk.y, static_cast<uint32_t>(edit.position.x) | static_cast<uint32_t>(edit.position.z) << 6
+		| static_cast<uint32_t>(edit.position.y) << 12 | static_cast<uint32_t>(edit.type) << 24 };
+}
+
+static BlockEdit unpackEdit(const EditRecord& record)
+{
+	const glm::ivec3 position(record.packed & 0x3F, record.packed >> 12 & 0xFFF, record.packed >> 6 & 0x3F);
+	return { glm::ivec2(record.chunkX, record.chunkZ), position, static_cast<uint8_t>(record.packed >> 24) };
+}
+
+EditLog::EditLog(std::filesystem::path directory, float flushInterval)
+	:mDirectory(std::move(directory)), mFlushInterval(flushInterval)
+{
+	// segments are named edits-<number>.log, numbered in the order they were started
+	uint32_t first = UINT32_MAX, last = 0;
+	std::error_code error;
+	for (const auto& entry : std::filesystem::directory_iterator(mDirectory, error))
+	{
+		const std::string name = entry.path().filename().string();
+		if (name.size() <= 10 || name.compare(0, 6, "edits-") != 0 || name.compare(name.size() - 4, 4, ".log") != 0) continue;
+		const std::string number = name.substr(6, name.size() - 10);
+		if (!std::all_of(number.begin(), number.end(), [](char c) { return c >= '0' && c <= '9'; })) continue;
+
+		const uint32_t segment = static_cast<uint32_t>(std::stoul(number));
+		first = std::min(first, segment);
+		last = std::max(last, segment);
+	}
+	if (last > 0)
+	{
+		mFirstSegment = first;
+		mReplayEnd = last + 1;
+		mSegment = last + 1;
+	}
+
+	mThread = std::thread(&EditLog::threadLoop, this);
+}
+
+EditLog::~EditLog()
+{
+	close();
+}
+
+uint64_t EditLog::replay(const std::function<void(const BlockEdit&)>& apply)
+{
+	const auto start = std::chrono::steady_clock::now();
+	uint32_t first;
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		first = mFirstSegment;
+	}
+
+	uint64_t count = 0;
+	std::vector<uint8_t> bytes;
+	for (uint32_t segment = first; segment < mReplayEnd; segment++)
+	{
+		// segments with no edits were never created
+		std::ifstream file(getSegmentPath(segment), std::ios::binary | std::ios::ate);
+		if (!file) continue;
+		bytes.resize(static_cast<size_t>(file.tellg()));
+		file.seekg(0);
+		file.read(reinterpret_cast<char*>(bytes.data()), bytes.size());
+
+		size_t offset = 0;
+		while (bytes.size() - offset >= sizeof(EditGroupHeader))
+		{
+			EditGroupHeader header;
+			memcpy(&header, bytes.data() + offset, sizeof(header));
+			offset += sizeof(header);
+
+			// a group torn by a crash was never committed, and nothing was written after it
+			if (header.magic != EDITLOG_MAGIC || header.count > (bytes.size() - offset) / sizeof(EditRecord)) break;
+			std::vector<EditRecord> records(header.count);
+			memcpy(records.data(), bytes.data() + offset, header.count * sizeof(EditRecord));
+			if (checksumRecords(records.data(), header.count) != header.checksum) break;
+			offset += header.count * sizeof(EditRecord);
+
+			for (const EditRecord& record : records)
+				apply(unpackEdit(record));
+			count += header.count;
+		}
+	}
+
+	std::lock_guard<std::mutex> lock(mMutex);
+	mReplayed += count;
+	mReplayNs += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+	return count;
+}
+
+void EditLog::append(const BlockEdit& edit)
+{
+	bool wake;
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		if (mError) std::rethrow_exception(mError);
+		if (mStopping)
+			throw std::runtime_error("Failed to append to edit log, it is closed!");
+
+		if (mQueued.empty())
+			mFirstQueued = std::chrono::steady_clock::now();
+		mQueued.push_back(edit);
+		mAppended++;
+		// the thread only needs waking for the first edit of a group and a full group
+		wake = mQueued.size() == 1 || mQueued.size() == EDITLOG_GROUP_EDITS;
+	}
+	if (wake) mWake.notify_one();
+}
+
+void EditLog::commit()
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+	const uint64_t target = mAppended;
+	mCommitWanted = std::max(mCommitWanted, target);
+	mWake.notify_one();
+	mCommitted.wait(lock, [this, target] { return mDurable >= target || mError; });
+	if (mError) std::rethrow_exception(mError);
+}
+
+uint32_t EditLog::checkpoint()
+{
+	uint32_t segment;
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		if (!mQueued.empty())
+		{
+			mSealed.push_back({ mSegment, std::move(mQueued) });
+			mQueued.clear();
+		}
+		segment = ++mSegment;
+	}
+	// the thread closes the previous segment even if it has nothing to write
+	mWake.notify_one();
+	return segment;
+}
+
+void EditLog::compact(uint32_t checkpoint)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	for (; mFirstSegment < checkpoint; mFirstSegment++)
+	{
+		std::error_code error;
+		std::filesystem::remove(getSegmentPath(mFirstSegment), error);
+		if (error)
+			throw std::runtime_error("Failed to compact edit log " + getSegmentPath(mFirstSegment).string() + "!");
+	}
+}
+
+void EditLog::close()
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mStopping = true;
+	}
+	mWake.notify_one();
+	if (mThread.joinable())
+		mThread.join();
+}
+
+float EditLog::getFlushInterval() const
+{
+	return mFlushInterval;
+}
+
+EditLogStats EditLog::getStats() const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	EditLogStats stats;
+	stats.edits = mAppended;
+	stats.commits = mCommits;
+	stats.bytes = mBytes;
+	stats.syncMs = mSyncNs / 1e6;
+	stats.replayed = mReplayed;
+	stats.replayMs = mReplayNs / 1e6;
+	return stats;
+}
+
+void EditLog::reportStats(std::ostream& out) const
+{
+	const EditLogStats stats = getStats();
+	out << "Edit log " << mDirectory.string() << ": " << stats.edits << " edits in " << stats.commits << " group commits, " << std::fixed << std::setprecision(1)
+		<< (stats.commits ? static_cast<double>(stats.edits) / stats.commits : 0.0) << " edits per sync, " << std::setprecision(3)
+		<< stats.syncMs << " ms writing and syncing, " << stats.replayed << " edits replayed in " << stats.replayMs << " ms" << std::endl;
+}
+
+std::filesystem::path EditLog::getSegmentPath(uint32_t segment) const
+{
+	return mDirectory / ("edits-" + std::to_string(segment) + ".log");
+}
+
+size_t EditLog::writeGroup(uint32_t segment, const std::vector<BlockEdit>& edits)
+{
+	if (mFileOpen && mFileSegment != segment)
+		closeSegment();
+	if (!mFileOpen)
+		openSegment(segment);
+
+	std::vector<uint8_t> bytes(sizeof(EditGroupHeader) + edits.size() * sizeof(EditRecord));
+	EditRecord* records = reinterpret_cast<EditRecord*>(bytes.data() + sizeof(EditGroupHeader));
+	for (size_t i = 0; i < edits.size(); i++)
+		records[i] = packEdit(edits[i]);
+	const EditGroupHeader header = { EDITLOG_MAGIC, static_cast<uint32_t>(edits.size()), checksumRecords(records, static_cast<uint32_t>(edits.size())) };
+	memcpy(bytes.data(), &header, sizeof(header));
+
+	// the group is durable once the sync returns, not when the write does
+	const uint8_t* data = bytes.data();
+	size_t size = bytes.size();
+	while (size > 0)
+	{
+#ifdef _WIN32
+		DWORD written = 0;
+		if (!WriteFile(mFile, data, static_cast<DWORD>(size), &written, nullptr))
+			throw std::runtime_error("Failed to write edit log!");
+#else
+		const ssize_t written = ::write(mFile, data, size);
+		if (written <= 0)
+			throw std::runtime_error("Failed to write edit log!");
+#endif
+		data += written;
+		size -= written;
+	}
+#ifdef _WIN32
+	if (!FlushFileBuffers(mFile))
+		throw std::runtime_error("Failed to sync edit log!");
+#elif defined(__linux__)
+	if (fdatasync(mFile) != 0)
+		throw std::runtime_error("Failed to sync edit log!");
+#else
+	if (fsync(mFile) != 0)
+		throw std::runtime_error("Failed to sync edit log!");
+#endif
+	return bytes.size();
+}
+
+void EditLog::openSegment(uint32_t segment)
+{
+	std::filesystem::create_directories(mDirectory);
+	const std::filesystem::path path = getSegmentPath(segment);
+#ifdef _WIN32
+	// deletable while open, compact may get to a segment before the thread closes it
+	HANDLE file = CreateFileW(path.c_str(), FILE_APPEND_DATA, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		throw std::runtime_error("Failed to open edit log " + path.string() + "!");
+	mFile = file;
+#else
+	mFile = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0644);
+	if (mFile < 0)
+		throw std::runtime_error("Failed to open edit log " + path.string() + "!");
+
+	// the new file's directory entry has to be durable too, or the segment can vanish in a crash
+	const int directory = open(mDirectory.c_str(), O_RDONLY);
+	if (directory >= 0)
+	{
+		fsync(directory);
+		::close(directory);
+	}
+#endif
+	mFileOpen = true;
+	mFileSegment = segment;
+}
+
+void EditLog::closeSegment()
+{
+	if (!mFileOpen) return;
+#ifdef _WIN32
+	CloseHandle(mFile);
+#else
+	::close(mFile);
+#endif
+	mFileOpen = false;
+}
+
+void EditLog::threadLoop()
+{
+	while (true)
+	{
+		std::deque<Group> groups;
+		uint64_t appended;
+		uint32_t segment;
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			mWake.wait(lock, [this] { return mStopping || !mQueued.empty() || !mSealed.empty() || (mFileOpen && mFileSegment != mSegment); });
+
+			// group commit: the first edit waits up to the flush interval for more to share its
+			// sync, unless someone is waiting for it or a checkpoint sealed the group already
+			if (!mQueued.empty() && mSealed.empty())
+			{
+				const auto deadline = mFirstQueued + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<float>(mFlushInterval));
+				mWake.wait_until(lock, deadline, [this]
+				{
+					return mStopping || !mSealed.empty() || mQueued.size() >= EDITLOG_GROUP_EDITS || mCommitWanted > mDurable;
+				});
+			}
+
+			groups.swap(mSealed);
+			if (!mQueued.empty())
+			{
+				groups.push_back({ mSegment, std::move(mQueued) });
+				mQueued.clear();
+			}
+			appended = mAppended;
+			segment = mSegment;
+			if (groups.empty() && mStopping) break;
+		}
+
+		const auto start = std::chrono::steady_clock::now();
+		size_t bytes = 0;
+		std::exception_ptr error;
+		try
+		{
+			for (const Group& group : groups)
+				bytes += writeGroup(group.segment, group.edits);
+			// a checkpoint moved on, the file can go before compact deletes it
+			if (mFileOpen && mFileSegment != segment)
+				closeSegment();
+		}
+		catch (...)
+		{
+			error = std::current_exception();
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mSyncNs += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+			if (error)
+			{
+				// append and commit rethrow it from now on
+				mError = error;
+				mCommitted.notify_all();
+				break;
+			}
+			mCommits += groups.size();
+			mBytes += bytes;
+			mDurable = appended;
+			mCommitted.notify_all();
+		}
+	}
+	closeSegment();
+}
\ No newline at end of file
@@ -0,0 +1,130 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <ostream>
+#include <thread>
+#include <vector>
+#include <glm/glm.hpp>
+#include "AsyncIO.h"
+
+// seconds an edit waits at most for the group commit that makes it durable
+constexpr float EDITLOG_FLUSH_INTERVAL = 0.05f;
+// a group is committed early once this many edits wait for it
+constexpr uint32_t EDITLOG_GROUP_EDITS = 8192;
+constexpr uint32_t EDITLOG_MAGIC = 0x54494445; // "EDIT"
+
+// block at position inside chunk set to type
+struct BlockEdit
+{
+	glm::ivec2 chunk;
+	glm::ivec3 position; // local to the chunk
+	uint8_t type;
+};
+
+struct EditLogStats
+{
+	uint64_t edits = 0;
+	// groups written and synced, each one sync however many edits it holds
+	uint64_t commits = 0;
+	uint64_t bytes = 0;
+	// time the log thread spent writing and syncing, in milliseconds
+	double syncMs = 0.0;
+	uint64_t replayed = 0;
+	double replayMs = 0.0;
+};
+
+// Write-ahead log of block edits, so an edit survives a crash long before its chunk
+// is saved again. append only queues the edit; a thread of its own writes whatever
+// queued up as one group and syncs the file once for all of it, at the latest a
+// flush interval after the group's first edit. Groups carry a checksum, so one torn
+// by a crash is dropped on replay along with everything after it.
+// The log is split into segments. checkpoint starts a new one, and once every chunk
+// changed before it is saved, compact deletes the ones before, so the log only ever
+// holds the edits since the last autosave. Thread-safe.
+class EditLog
+{
+public:
+	// finds the segments left in directory for replay, appending starts a new one
+	EditLog(std::filesystem::path directory, float flushInterval = EDITLOG_FLUSH_INTERVAL);
+	~EditLog();
+
+	EditLog(const EditLog&) = delete;
+	EditLog& operator=(const EditLog&) = delete;
+
+	// calls apply with every committed edit of the segments found when the log was
+	// opened, oldest first, returns how many there were
+	uint64_t replay(const std::function<void(const BlockEdit&)>& apply);
+	// queues the edit for the next group commit, throws if an earlier commit failed
+	void append(const BlockEdit& edit);
+	// blocks until every edit appended so far is durable
+	void commit();
+	// edits appended from now on go to a new segment, returns it for compact
+	uint32_t checkpoint();
+	// deletes the segments before the one checkpoint returned, once the chunks
+	// changed before that checkpoint are safely saved
+	void compact(uint32_t checkpoint);
+	// commits what is queued and ends the thread, appending afterwards throws
+	void close();
+
+	float getFlushInterval() const;
+	EditLogStats getStats() const;
+	void reportStats(std::ostream& out) const;
+private:
+	struct Group
+	{
+		uint32_t segment;
+		std::vector<BlockEdit> edits;
+	};
+
+	std::filesystem::path getSegmentPath(uint32_t segment) const;
+	// writes the edits as one group to the segment's file and syncs it, switching files
+	// first if another segment is open; returns the bytes written
+	size_t writeGroup(uint32_t segment, const std::vector<BlockEdit>& edits);
+	void openSegment(uint32_t segment);
+	void closeSegment();
+	void threadLoop();
+private:
+	std::filesystem::path mDirectory;
+	float mFlushInterval;
+	// the oldest segment not compacted yet, those before mReplayEnd were there when
+	// the log was opened
+	uint32_t mFirstSegment = 1;
+	uint32_t mReplayEnd = 1;
+
+	// the thread's file, opened on the first group of a segment
+#ifdef _WIN32
+	FileHandle mFile = nullptr;
+#else
+	FileHandle mFile = -1;
+#endif
+	bool mFileOpen = false;
+	uint32_t mFileSegment = 0;
+
+	mutable std::mutex mMutex;
+	std::condition_variable mWake;      // the thread waits for edits
+	std::condition_variable mCommitted; // commit waits for the thread
+	// edits for mSegment, and groups sealed by a checkpoint before the thread took them
+	std::vector<BlockEdit> mQueued;
+	std::deque<Group> mSealed;
+	std::chrono::steady_clock::time_point mFirstQueued;
+	uint32_t mSegment = 1;
+	uint64_t mAppended = 0;
+	uint64_t mDurable = 0;
+	// commit waits for mDurable to get here, the thread does not wait out the interval for it
+	uint64_t mCommitWanted = 0;
+	std::exception_ptr mError;
+	bool mStopping = false;
+	std::thread mThread;
+
+	uint64_t mCommits = 0;
+	uint64_t mBytes = 0;
+	uint64_t mSyncNs = 0;
+	uint64_t mReplayed = 0;
+	uint64_t mReplayNs = 0;
+};
\ No newline at end of file
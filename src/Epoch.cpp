@@ -0,0 +1,169 @@
+#include "Epoch.h"
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <stdexcept>
+#include <thread>
+
+EpochGuard::EpochGuard(EpochDomain* domain, std::atomic<uint64_t>* slot)
+	:mDomain(domain), mSlot(slot)
+{
+}
+
+EpochGuard::~EpochGuard()
+{
+	release();
+}
+
+EpochGuard::EpochGuard(EpochGuard&& other) noexcept
+	:mDomain(other.mDomain), mSlot(other.mSlot)
+{
+	other.mDomain = nullptr;
+	other.mSlot = nullptr;
+}
+
+EpochGuard& EpochGuard::operator=(EpochGuard&& other) noexcept
+{
+	if (this != &other)
+	{
+		release();
+		mDomain = other.mDomain;
+		mSlot = other.mSlot;
+		other.mDomain = nullptr;
+		other.mSlot = nullptr;
+	}
+	return *this;
+}
+
+bool EpochGuard::isPinned() const
+{
+	return mDomain != nullptr;
+}
+
+void EpochGuard::release()
+{
+	if (!mDomain) return;
+	mDomain->unpin(mSlot);
+	mDomain = nullptr;
+	mSlot = nullptr;
+}
+
+EpochDomain::~EpochDomain()
+{
+	for (const Retired& retired : mRetired)
+		retired.deleter(retired.object);
+
+	Block* block = mSlots.next.load(std::memory_order_relaxed);
+	while (block)
+	{
+		Block* next = block->next.load(std::memory_order_relaxed);
+		delete block;
+		block = next;
+	}
+}
+
+EpochDomain& EpochDomain::get()
+{
+	static EpochDomain domain;
+	return domain;
+}
+
+EpochGuard EpochDomain::pin()
+{
+	// threads start looking at different slots so they rarely race for one
+	static thread_local const int firstSlot = static_cast<int>(std::hash<std::thread::id>()(std::this_thread::get_id()) % EPOCH_SLOTS);
+
+	Block* block = &mSlots;
+	while (true)
+	{
+		for (int i = 0; i < EPOCH_SLOTS; i++)
+		{
+			Slot& slot = block->slots[(firstSlot + i) % EPOCH_SLOTS];
+			if (slot.epoch.load(std::memory_order_relaxed) != 0) continue;
+
+			// the epoch is read before the slot is taken, so anything the writer unpublishes
+			// after this guard's loads is retired in this epoch or a later one. Sequentially
+			// consistent, so collect sees the slot taken before any pointer this loads is swapped
+			uint64_t free = 0;
+			if (slot.epoch.compare_exchange_strong(free, mEpoch.load(std::memory_order_seq_cst), std::memory_order_seq_cst))
+				return EpochGuard(this, &slot.epoch);
+		}
+
+		// every slot of this block is pinned, move on to the next and link one if there is none.
+		// A slot in a block collect did not reach yet is taken after collect started its
+		// epoch, so what that guard loads is never retired before it
+		Block* next = block->next.load(std::memory_order_seq_cst);
+		if (!next)
+		{
+			Block* added = new Block;
+			if (block->next.compare_exchange_strong(next, added, std::memory_order_seq_cst))
+			{
+				mBlocks.fetch_add(1, std::memory_order_relaxed);
+				next = added;
+			}
+			else
+				delete added;
+		}
+		block = next;
+	}
+}
+
+void EpochDomain::unpin(std::atomic<uint64_t>* slot)
+{
+	// release, the guard's reads are done before the writer may free what they read
+	slot->store(0, std::memory_order_release);
+}
+
+void EpochDomain::retire(void* object, void (*deleter)(void*))
+{
+	mRetired.push_back({ object, deleter, mEpoch.load(std::memory_order_seq_cst) });
+	mRetiredCount++;
+	mPeakWaiting = std::max<uint64_t>(mPeakWaiting, mRetired.size());
+}
+
+size_t EpochDomain::collect()
+{
+	// guards pinned from now on cannot see anything retired so far
+	mEpoch.fetch_add(1, std::memory_order_seq_cst);
+
+	uint64_t oldest = std::numeric_limits<uint64_t>::max();
+	for (const Block* block = &mSlots; block; block = block->next.load(std::memory_order_seq_cst))
+		for (const Slot& slot : block->slots)
+		{
+			const uint64_t epoch = slot.epoch.load(std::memory_order_seq_cst);
+			if (epoch != 0) oldest = std::min(oldest, epoch);
+		}
+
+	// retired in order, so the objects that can go are a prefix
+	auto end = std::find_if(mRetired.begin(), mRetired.end(), [oldest](const Retired& retired) { return retired.epoch >= oldest; });
+	for (auto it = mRetired.begin(); it != end; it++)
+		it->deleter(it->object);
+
+	const size_t freed = end - mRetired.begin();
+	mRetired.erase(mRetired.begin(), end);
+	mReclaimed += freed;
+	return freed;
+}
+
+EpochStats EpochDomain::getStats() const
+{
+	EpochStats stats;
+	stats.epoch = mEpoch.load(std::memory_order_relaxed);
+	stats.retired = mRetiredCount;
+	stats.reclaimed = mReclaimed;
+	stats.waiting = mRetired.size();
+	stats.peakWaiting = mPeakWaiting;
+	for (const Block* block = &mSlots; block; block = block->next.load(std::memory_order_acquire))
+		for (const Slot& slot : block->slots)
+			if (slot.epoch.load(std::memory_order_relaxed) != 0)
+				stats.pinned++;
+	stats.slots = mBlocks.load(std::memory_order_relaxed) * EPOCH_SLOTS;
+	return stats;
+}
+
+void EpochDomain::reportStats(std::ostream& out) const
+{
+	const EpochStats stats = getStats();
+	out << "Epoch reclamation: " << stats.retired << " retired, " << stats.reclaimed << " reclaimed over " << stats.epoch << " epochs, at most "
+		<< stats.peakWaiting << " waiting for readers, " << stats.slots << " guard slots" << std::endl;
+}
\ No newline at end of file
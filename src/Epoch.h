@@ -0,0 +1,119 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+// guard slots a domain starts with, and adds whenever every one of them is pinned
+constexpr int EPOCH_SLOTS = 64;
+
+struct EpochStats
+{
+	uint64_t epoch = 0;
+	uint64_t retired = 0;
+	uint64_t reclaimed = 0;
+	// retired but possibly still seen by a guard pinned before, and the most there were
+	uint64_t waiting = 0;
+	uint64_t peakWaiting = 0;
+	// guards pinned right now, and the slots allocated for them
+	uint32_t pinned = 0;
+	uint32_t slots = 0;
+};
+
+class EpochDomain;
+
+// Pins the epoch of a domain while it lives, nothing retired after it was pinned is
+// freed until it is released. It is not tied to a thread: the render thread can pin
+// one and hand it to the job that reads what it pinned.
+class EpochGuard
+{
+public:
+	EpochGuard() = default;
+	~EpochGuard();
+
+	EpochGuard(EpochGuard&& other) noexcept;
+	EpochGuard& operator=(EpochGuard&& other) noexcept;
+	EpochGuard(const EpochGuard&) = delete;
+	EpochGuard& operator=(const EpochGuard&) = delete;
+
+	bool isPinned() const;
+	void release();
+private:
+	friend class EpochDomain;
+	EpochGuard(EpochDomain* domain, std::atomic<uint64_t>* slot);
+private:
+	EpochDomain* mDomain = nullptr;
+	std::atomic<uint64_t>* mSlot = nullptr;
+};
+
+// Epoch-based reclamation for data published through atomic pointers. Readers pin a
+// guard, load the pointers and read without taking a lock. The writer swaps in a new
+// version and retires the old one, which collect frees once every guard that may have
+// loaded it is released: a guard records the epoch it was pinned in, and an object
+// retired in an epoch is only freed when no guard from that epoch or an older one is
+// left. pin and guards may be used from any thread; retire and collect only from the
+// one thread that writes. The slots guards pin grow in blocks of EPOCH_SLOTS, so any
+// number of guards can be pinned at once, such as one per queued job.
+class EpochDomain
+{
+public:
+	EpochDomain() = default;
+	// frees everything still retired, no guard may be pinned anymore
+	~EpochDomain();
+
+	EpochDomain(const EpochDomain&) = delete;
+	EpochDomain& operator=(const EpochDomain&) = delete;
+
+	// the domain of published chunk data, see ChunkVersion
+	static EpochDomain& get();
+
+	// lock-free, allocates another block of slots if every one is pinned
+	EpochGuard pin();
+	// deletes object once no guard pinned before now is left
+	template<typename T>
+	void retire(const T* object)
+	{
+		retire(const_cast<T*>(object), [](void* retired) { delete static_cast<T*>(retired); });
+	}
+	void retire(void* object, void (*deleter)(void*));
+	// starts a new epoch and frees what was retired before the oldest pinned guard,
+	// returns how many objects it freed
+	size_t collect();
+
+	EpochStats getStats() const;
+	void reportStats(std::ostream& out) const;
+private:
+	friend class EpochGuard;
+
+	struct Retired
+	{
+		void* object;
+		void (*deleter)(void*);
+		uint64_t epoch;
+	};
+	// the epoch a guard was pinned in, 0 while free. A cache line each, guards on
+	// different threads never write the same one
+	struct alignas(64) Slot
+	{
+		std::atomic<uint64_t> epoch{ 0 };
+	};
+	// blocks are only linked to the end of the list and freed with the domain, so pin
+	// and collect walk it without a lock
+	struct Block
+	{
+		std::array<Slot, EPOCH_SLOTS> slots;
+		std::atomic<Block*> next{ nullptr };
+	};
+
+	void unpin(std::atomic<uint64_t>* slot);
+private:
+	std::atomic<uint64_t> mEpoch{ 1 };
+	Block mSlots;
+	std::atomic<uint32_t> mBlocks{ 1 };
+	std::vector<Retired> mRetired;
+
+	uint64_t mRetiredCount = 0;
+	uint64_t mReclaimed = 0;
+	uint64_t mPeakWaiting = 0;
+};
\ No newline at end of file
@@ -6,6 +6,8 @@
 #include <fstream>
 #include <glm/gtc/matrix_transform.hpp>
 #include <chrono>
+#include <iomanip>
+#include <bit>
 
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb/stb_image.h>
@@ -27,6 +29,20 @@ VkPhysicalDevice GraphicsEngine::m_PhysicalDevice = VK_NULL_HANDLE;
 VkDevice GraphicsEngine::m_Device = VK_NULL_HANDLE;
 VkQueue GraphicsEngine::m_GraphicsQueue = VK_NULL_HANDLE;
 VkCommandPool GraphicsEngine::m_CPool = VK_NULL_HANDLE;
+VkBuffer GraphicsEngine::m_QuadIndexBuffer16 = VK_NULL_HANDLE;
+VkDeviceMemory GraphicsEngine::m_QuadIndexBuffer16Memory = VK_NULL_HANDLE;
+VkBuffer GraphicsEngine::m_QuadIndexBuffer32 = VK_NULL_HANDLE;
+VkDeviceMemory GraphicsEngine::m_QuadIndexBuffer32Memory = VK_NULL_HANDLE;
+std::array<std::vector<PooledBuffer>, VERTEXPOOL_CLASSES> GraphicsEngine::m_FreeVertexBuffers;
+std::vector<std::pair<uint64_t, PooledBuffer>> GraphicsEngine::m_RetiredVertexBuffers;
+uint64_t GraphicsEngine::m_FrameNumber = 0;
+PoolStats GraphicsEngine::m_VertexPoolStats;
+std::mutex GraphicsEngine::m_StagingMutex;
+std::array<std::vector<StagingBuffer>, VERTEXPOOL_CLASSES> GraphicsEngine::m_FreeStagingBuffers;
+std::vector<std::pair<uint64_t, StagingBuffer>> GraphicsEngine::m_RetiredStagingBuffers;
+PoolStats GraphicsEngine::m_StagingPoolStats;
+std::array<VkCommandBuffer, MAX_FRAMES_IN_FLIGHT + 1> GraphicsEngine::m_UploadCommandBuffers{};
+bool GraphicsEngine::m_Uploading = false;
 
 
 static VKAPI_ATTR VkBool32 VKAPI_CALL debugCallback(VkDebugUtilsMessageSeverityFlagBitsEXT messageSeverity, VkDebugUtilsMessageTypeFlagsEXT messageType, const VkDebugUtilsMessengerCallbackDataEXT* pCallbackData, void* userData)
@@ -58,6 +74,7 @@ void GraphicsEngine::IntializeGraphicsEngine()
 	createUniformBuffers();
 	createDescriptorPool();
 	createDescriptorSets();
+	createQuadIndexBuffers();
 	initChunk();
 	createCommandBuffer();
 	createSyncObjects();
@@ -324,18 +341,52 @@ void GraphicsEngine::createWindow()
 
 void GraphicsEngine::mainLoop()
 {
+	auto frameStart = std::chrono::steady_clock::now();
 	while (!glfwWindowShouldClose(m_Window))
 	{
 
 		glfwPollEvents();
+		mJobs.runCompletions(JOB_COMPLETION_BUDGET_MS);
+		mChunkManager.update(mCamera);
 		drawFrame();
+
+		const auto frameEnd = std::chrono::steady_clock::now();
+		const double frameMs = std::chrono::duration<double, std::milli>(frameEnd - frameStart).count();
+		(mChunkManager.getAutosave().isSaving() ? mAutosaveFrameTimes : mFrameTimes).add(frameMs);
+		frameStart = frameEnd;
 	}
 	vkDeviceWaitIdle(m_Device);
 }
 
 void GraphicsEngine::terminate()
 {
-	mChunk.destroyChunk();
+	mChunkManager.finishIO();
+	mJobs.stop();
+	mChunkManager.destroy();
+	std::cout << "Peak pooled memory: chunk sections " << ChunkSection::getPoolStats().peakBytes / 1024
+		<< " KiB, staging " << getStagingPoolStats().peakBytes / 1024
+		<< " KiB, vertex buffers " << getVertexPoolStats().peakBytes / 1024 << " KiB" << std::endl;
+	if (SECTION_DEDUPLICATION)
+	{
+		const SectionStoreStats store = ChunkSection::getStoreStats();
+		std::cout << "Interned sections: " << store.hits << " of " << store.interned << " shared the storage of an identical one" << std::endl;
+	}
+	mChunkManager.getGenerator().reportStats(std::cout);
+	mChunkManager.getStorage().reportStats(std::cout);
+	mChunkManager.getAutosave().reportStats(std::cout);
+	mChunkManager.getEditLog().reportStats(std::cout);
+	mChunkManager.getCache().reportStats(std::cout);
+	Chunk::reportMeshStats(std::cout);
+	EpochDomain::get().reportStats(std::cout);
+	std::cout << std::fixed << std::setprecision(2) << "Frame time: " << (mFrameTimes.frames ? mFrameTimes.totalMs / mFrameTimes.frames : 0.0)
+		<< " ms average, " << mFrameTimes.worstMs << " ms worst; while autosaving " << (mAutosaveFrameTimes.frames ? mAutosaveFrameTimes.totalMs / mAutosaveFrameTimes.frames : 0.0)
+		<< " ms average, " << mAutosaveFrameTimes.worstMs << " ms worst over " << mAutosaveFrameTimes.frames << " frames" << std::endl;
+	destroyVertexBufferPool();
+	destroyStagingPool();
+	vkFreeMemory(m_Device, m_QuadIndexBuffer16Memory, nullptr);
+	vkDestroyBuffer(m_Device, m_QuadIndexBuffer16, nullptr);
+	vkFreeMemory(m_Device, m_QuadIndexBuffer32Memory, nullptr);
+	vkDestroyBuffer(m_Device, m_QuadIndexBuffer32, nullptr);
 	vkFreeMemory(m_Device, colorImageMemory, nullptr);
 	vkDestroyImageView(m_Device, colorImageView, nullptr);
 	vkDestroyImage(m_Device, colorImage, nullptr);
@@ -476,8 +527,8 @@ void GraphicsEngine::createGraphicsPipeline()
 	dynamicCreateInfo.dynamicStateCount = static_cast<uint32_t>(dynamicStates.size());
 	dynamicCreateInfo.pDynamicStates = dynamicStates.data();
 
-	auto bindingDesc = Vertex::getBindingDescription();
-	auto attDesc = Vertex::getAttributeDescriptions();
+	auto bindingDesc = ChunkVertex::getBindingDescription();
+	auto attDesc = ChunkVertex::getAttributeDescriptions();
 
 	VkPipelineVertexInputStateCreateInfo vertexInput{};
 	vertexInput.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
@@ -549,10 +600,17 @@ void GraphicsEngine::createGraphicsPipeline()
 	colorState.pAttachments = &colorBlend;
 	colorState.logicOpEnable = VK_FALSE;
 
+	VkPushConstantRange pushConstantRange{};
+	pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+	pushConstantRange.offset = 0;
+	pushConstantRange.size = sizeof(ChunkPushConstants);
+
 	VkPipelineLayoutCreateInfo layoutInfo{};
 	layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
 	layoutInfo.setLayoutCount = 1;
 	layoutInfo.pSetLayouts = &m_DescLayout;
+	layoutInfo.pushConstantRangeCount = 1;
+	layoutInfo.pPushConstantRanges = &pushConstantRange;
 
 	if (vkCreatePipelineLayout(m_Device, &layoutInfo, nullptr, &m_PipelineLayout) != VK_SUCCESS)
 		throw std::runtime_error("Failed to create pipeline layout");
@@ -588,7 +646,40 @@ void GraphicsEngine::setFramebufferResized(bool resized)
 
 void GraphicsEngine::initChunk()
 {
-	mChunk.generateMesh();
+	mJobs.start();
+	std::cout << "Job system running on " << mJobs.getWorkerCount() << " worker threads" << std::endl;
+
+	mChunkManager.update(mCamera);
+}
+
+void GraphicsEngine::createQuadIndexBuffers()
+{
+	const uint32_t quadIndices[6] = { 0,1,2, 2,3,0 };
+
+	std::vector<uint16_t> indices16;
+	indices16.reserve(MAX_QUADS_16BIT * 6);
+	for (uint32_t quad = 0; quad < MAX_QUADS_16BIT; quad++)
+		for (uint32_t index : quadIndices)
+			indices16.push_back(static_cast<uint16_t>(quad * 4 + index));
+
+	std::vector<uint32_t> indices32;
+	indices32.reserve(MAXCHUNKQUADS * 6);
+	for (uint32_t quad = 0; quad < MAXCHUNKQUADS; quad++)
+		for (uint32_t index : quadIndices)
+			indices32.push_back(quad * 4 + index);
+
+	createIndexBuffer(indices16, m_QuadIndexBuffer16, m_QuadIndexBuffer16Memory);
+	createIndexBuffer(indices32, m_QuadIndexBuffer32, m_QuadIndexBuffer32Memory);
+}
+
+void GraphicsEngine::bindQuadIndexBuffer(VkCommandBuffer commandBuffer, uint32_t quadCount)
+{
+	assert(quadCount <= MAXCHUNKQUADS);
+
+	if (quadCount <= MAX_QUADS_16BIT)
+		vkCmdBindIndexBuffer(commandBuffer, m_QuadIndexBuffer16, 0, VK_INDEX_TYPE_UINT16);
+	else
+		vkCmdBindIndexBuffer(commandBuffer, m_QuadIndexBuffer32, 0, VK_INDEX_TYPE_UINT32);
 }
 
 void GraphicsEngine::createColorResources()
@@ -776,9 +867,17 @@ void GraphicsEngine::endSingleTimeCommands(VkCommandBuffer buffer)
 	submitInfo.pCommandBuffers = &buffer;
 	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 
-	vkQueueSubmit(m_GraphicsQueue, 1, &submitInfo, VK_NULL_HANDLE);
-	vkQueueWaitIdle(m_GraphicsQueue);
+	// waits for this submission alone, not for the frames in flight
+	VkFenceCreateInfo fenceInfo{};
+	fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+	VkFence fence;
+	if (vkCreateFence(m_Device, &fenceInfo, nullptr, &fence) != VK_SUCCESS)
+		throw std::runtime_error("Failed to create fence!");
+
+	vkQueueSubmit(m_GraphicsQueue, 1, &submitInfo, fence);
+	vkWaitForFences(m_Device, 1, &fence, VK_TRUE, UINT64_MAX);
 
+	vkDestroyFence(m_Device, fence, nullptr);
 	vkFreeCommandBuffers(m_Device, m_CPool, 1, &buffer);
 }
 
@@ -1036,44 +1135,281 @@ uint32_t GraphicsEngine::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFla
 	throw std::runtime_error("Failed to find a suitable memory type!");
 }
 
-void GraphicsEngine::createIndexBuffer(const std::vector<uint16_t>& indices, VkBuffer& buffer, VkDeviceMemory& bufferMemory)
+void GraphicsEngine::createIndexBuffer(const void* indices, VkDeviceSize size, VkBuffer& buffer, VkDeviceMemory& bufferMemory)
 {
-	VkDeviceSize bufferSize = sizeof(uint16_t) * indices.size();
+	StagingBuffer staging = createStagingBuffer(size);
+	memcpy(staging.data, indices, size);
+	uploadStagingBuffer(staging, VK_BUFFER_USAGE_INDEX_BUFFER_BIT, buffer, bufferMemory);
+}
 
-	VkBuffer stagingBuffer;
-	VkDeviceMemory stagingBufferMemory;
-	createBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingBufferMemory);
+void GraphicsEngine::createVertexBuffer(const void* vertices, VkDeviceSize size, VkBuffer& buffer, VkDeviceMemory& bufferMemory)
+{
+	StagingBuffer staging = createStagingBuffer(size);
+	memcpy(staging.data, vertices, size);
+	uploadStagingBuffer(staging, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, buffer, bufferMemory);
+}
 
-	void* data;
-	vkMapMemory(m_Device, stagingBufferMemory, 0, bufferSize, 0, &data);
-	memcpy(data, indices.data(), bufferSize);
-	vkUnmapMemory(m_Device, stagingBufferMemory);
+// power of two size class of the vertex and staging pools, VERTEXPOOL_CLASSES if too big to pool
+static uint32_t getPoolSizeClass(VkDeviceSize size)
+{
+	const VkDeviceSize capacity = std::bit_ceil(std::max<VkDeviceSize>(size, 1ull << VERTEXPOOL_MIN_CLASS));
+	return std::min<uint32_t>(std::countr_zero(capacity) - VERTEXPOOL_MIN_CLASS, VERTEXPOOL_CLASSES);
+}
 
-	createBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, buffer, bufferMemory);
-	copyBuffer(stagingBuffer, buffer, bufferSize);
+StagingBuffer GraphicsEngine::createStagingBuffer(VkDeviceSize size)
+{
+	StagingBuffer staging{};
+	const uint32_t sizeClass = getPoolSizeClass(size);
+	if (sizeClass < VERTEXPOOL_CLASSES)
+	{
+		staging.capacity = 1ull << (sizeClass + VERTEXPOOL_MIN_CLASS);
 
-	vkFreeMemory(m_Device, stagingBufferMemory, nullptr);
-	vkDestroyBuffer(m_Device, stagingBuffer, nullptr);
+		std::lock_guard<std::mutex> lock(m_StagingMutex);
+		std::vector<StagingBuffer>& freeList = m_FreeStagingBuffers[sizeClass];
+		if (!freeList.empty())
+		{
+			staging = freeList.back();
+			freeList.pop_back();
+		}
+		else
+		{
+			m_StagingPoolStats.reservedBytes += staging.capacity;
+			m_StagingPoolStats.systemAllocations++;
+		}
+		m_StagingPoolStats.allocated(staging.capacity);
+	}
+
+	if (staging.buffer == VK_NULL_HANDLE)
+	{
+		const VkDeviceSize allocationSize = staging.capacity ? staging.capacity : size;
+		createBuffer(allocationSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, staging.buffer, staging.memory);
+		vkMapMemory(m_Device, staging.memory, 0, allocationSize, 0, &staging.data);
+	}
+	staging.size = size;
+
+	return staging;
 }
 
-void GraphicsEngine::createVertexBuffer(const std::vector<Vertex>& vertices, VkBuffer& buffer, VkDeviceMemory& bufferMemory)
+void GraphicsEngine::uploadStagingBuffer(StagingBuffer& staging, VkBufferUsageFlags usage, VkBuffer& buffer, VkDeviceMemory& bufferMemory)
 {
-	VkDeviceSize bufferSize = sizeof(Vertex) * vertices.size();
+	createBuffer(staging.size, usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, buffer, bufferMemory);
+	copyBuffer(staging.buffer, buffer, staging.size);
 
-	VkBuffer stagingBuffer;
-	VkDeviceMemory stagingBufferMemory;
-	createBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingBufferMemory);
+	releaseStagingBuffer(staging);
+}
 
-	void* data;
-	vkMapMemory(m_Device, stagingBufferMemory, 0, bufferSize, 0, &data);
-	memcpy(data, vertices.data(), bufferSize);
-	vkUnmapMemory(m_Device, stagingBufferMemory);
+void GraphicsEngine::uploadVertexBuffer(StagingBuffer& staging, PooledBuffer& buffer)
+{
+	const uint32_t sizeClass = getPoolSizeClass(staging.size);
+	if (sizeClass >= VERTEXPOOL_CLASSES)
+		throw std::runtime_error("Failed to allocate vertex buffer, mesh too big for the pool!");
 
-	createBuffer(bufferSize, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, buffer, bufferMemory);
-	copyBuffer(stagingBuffer, buffer, bufferSize);
+	std::vector<PooledBuffer>& freeList = m_FreeVertexBuffers[sizeClass];
+	if (!freeList.empty())
+	{
+		buffer = freeList.back();
+		freeList.pop_back();
+	}
+	else
+	{
+		buffer.capacity = 1ull << (sizeClass + VERTEXPOOL_MIN_CLASS);
+		createBuffer(buffer.capacity, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, buffer.buffer, buffer.memory);
+		m_VertexPoolStats.reservedBytes += buffer.capacity;
+		m_VertexPoolStats.systemAllocations++;
+	}
+	m_VertexPoolStats.allocated(buffer.capacity);
 
-	vkFreeMemory(m_Device, stagingBufferMemory, nullptr);
-	vkDestroyBuffer(m_Device, stagingBuffer, nullptr);
+	VkBufferCopy copy{};
+	copy.size = staging.size;
+	vkCmdCopyBuffer(beginUploads(), staging.buffer, buffer.buffer, 1, &copy);
+	retireStagingBuffer(staging);
+}
+
+void GraphicsEngine::updateVertexBuffer(StagingBuffer& staging, PooledBuffer& buffer, const std::vector<VkBufferCopy>& copies, const std::vector<BufferRange>& clears)
+{
+	if (copies.empty() && clears.empty())
+	{
+		releaseStagingBuffer(staging);
+		return;
+	}
+
+	// the barriers around the frame's uploads order them after the frames drawing from it
+	VkCommandBuffer commandBuffer = beginUploads();
+	if (!copies.empty())
+		vkCmdCopyBuffer(commandBuffer, staging.buffer, buffer.buffer, static_cast<uint32_t>(copies.size()), copies.data());
+	for (const BufferRange& range : clears)
+		vkCmdFillBuffer(commandBuffer, buffer.buffer, range.offset, range.size, 0);
+	retireStagingBuffer(staging);
+}
+
+VkCommandBuffer GraphicsEngine::beginUploads()
+{
+	VkCommandBuffer commandBuffer = m_UploadCommandBuffers[m_FrameNumber % m_UploadCommandBuffers.size()];
+	if (m_Uploading) return commandBuffer;
+
+	// last submitted MAX_FRAMES_IN_FLIGHT + 1 frames ago, the previous frame waited for it
+	vkResetCommandBuffer(commandBuffer, 0);
+	VkCommandBufferBeginInfo beginInfo{};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+		throw std::runtime_error("Failed to begin upload command buffer!");
+
+	// frames submitted before may still read the buffers updated in place
+	VkMemoryBarrier barrier{};
+	barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	barrier.srcAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT;
+	barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+	m_Uploading = true;
+	return commandBuffer;
+}
+
+VkCommandBuffer GraphicsEngine::endUploads()
+{
+	if (!m_Uploading) return VK_NULL_HANDLE;
+	VkCommandBuffer commandBuffer = m_UploadCommandBuffers[m_FrameNumber % m_UploadCommandBuffers.size()];
+
+	// and the frame's draw reads what they wrote
+	VkMemoryBarrier barrier{};
+	barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+	if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+		throw std::runtime_error("Failed to record upload command buffer!");
+	m_Uploading = false;
+	return commandBuffer;
+}
+
+void GraphicsEngine::retireStagingBuffer(StagingBuffer& staging)
+{
+	// read by the uploads submitted with frame m_FrameNumber
+	if (staging.buffer != VK_NULL_HANDLE)
+		m_RetiredStagingBuffers.push_back({ m_FrameNumber, staging });
+	staging = StagingBuffer{};
+}
+
+void GraphicsEngine::releaseVertexBuffer(PooledBuffer& buffer)
+{
+	if (buffer.buffer != VK_NULL_HANDLE)
+		m_RetiredVertexBuffers.push_back({ m_FrameNumber, buffer });
+	buffer = PooledBuffer{};
+}
+
+void GraphicsEngine::recycleBuffers()
+{
+	// a buffer released before frame n was submitted is last read by frame n - 1,
+	// which has finished once frame n - 1 + MAX_FRAMES_IN_FLIGHT can record
+	auto done = std::partition(m_RetiredVertexBuffers.begin(), m_RetiredVertexBuffers.end(),
+		[](const std::pair<uint64_t, PooledBuffer>& retired) { return retired.first + MAX_FRAMES_IN_FLIGHT > m_FrameNumber; });
+
+	for (auto it = done; it != m_RetiredVertexBuffers.end(); it++)
+	{
+		PooledBuffer& buffer = it->second;
+		m_VertexPoolStats.liveBytes -= buffer.capacity;
+
+		std::vector<PooledBuffer>& freeList = m_FreeVertexBuffers[std::countr_zero(buffer.capacity) - VERTEXPOOL_MIN_CLASS];
+		if (freeList.size() < VERTEXPOOL_MAX_FREE)
+			freeList.push_back(buffer);
+		else
+		{
+			vkFreeMemory(m_Device, buffer.memory, nullptr);
+			vkDestroyBuffer(m_Device, buffer.buffer, nullptr);
+			m_VertexPoolStats.reservedBytes -= buffer.capacity;
+		}
+	}
+	m_RetiredVertexBuffers.erase(done, m_RetiredVertexBuffers.end());
+
+	// the same for the staging buffers of the uploads submitted with frame n
+	auto copied = std::partition(m_RetiredStagingBuffers.begin(), m_RetiredStagingBuffers.end(),
+		[](const std::pair<uint64_t, StagingBuffer>& retired) { return retired.first + MAX_FRAMES_IN_FLIGHT > m_FrameNumber; });
+	for (auto it = copied; it != m_RetiredStagingBuffers.end(); it++)
+		releaseStagingBuffer(it->second);
+	m_RetiredStagingBuffers.erase(copied, m_RetiredStagingBuffers.end());
+}
+
+void GraphicsEngine::destroyVertexBufferPool()
+{
+	for (auto& [frame, buffer] : m_RetiredVertexBuffers)
+	{
+		vkFreeMemory(m_Device, buffer.memory, nullptr);
+		vkDestroyBuffer(m_Device, buffer.buffer, nullptr);
+		m_VertexPoolStats.liveBytes -= buffer.capacity;
+		m_VertexPoolStats.reservedBytes -= buffer.capacity;
+	}
+	m_RetiredVertexBuffers.clear();
+
+	for (auto& freeList : m_FreeVertexBuffers)
+	{
+		for (PooledBuffer& buffer : freeList)
+		{
+			vkFreeMemory(m_Device, buffer.memory, nullptr);
+			vkDestroyBuffer(m_Device, buffer.buffer, nullptr);
+			m_VertexPoolStats.reservedBytes -= buffer.capacity;
+		}
+		freeList.clear();
+	}
+}
+
+void GraphicsEngine::releaseStagingBuffer(StagingBuffer& staging)
+{
+	if (staging.buffer == VK_NULL_HANDLE) return;
+
+	bool pooled = false;
+	if (staging.capacity)
+	{
+		std::lock_guard<std::mutex> lock(m_StagingMutex);
+		m_StagingPoolStats.liveBytes -= staging.capacity;
+
+		std::vector<StagingBuffer>& freeList = m_FreeStagingBuffers[std::countr_zero(staging.capacity) - VERTEXPOOL_MIN_CLASS];
+		pooled = freeList.size() < STAGINGPOOL_MAX_FREE;
+		if (pooled)
+			freeList.push_back(staging);
+		else
+			m_StagingPoolStats.reservedBytes -= staging.capacity;
+	}
+
+	if (!pooled)
+	{
+		// freeing the memory also unmaps it
+		vkFreeMemory(m_Device, staging.memory, nullptr);
+		vkDestroyBuffer(m_Device, staging.buffer, nullptr);
+	}
+	staging = StagingBuffer{};
+}
+
+void GraphicsEngine::destroyStagingPool()
+{
+	// the device is idle, nothing reads them anymore
+	for (auto& [frame, staging] : m_RetiredStagingBuffers)
+		releaseStagingBuffer(staging);
+	m_RetiredStagingBuffers.clear();
+
+	std::lock_guard<std::mutex> lock(m_StagingMutex);
+	for (auto& freeList : m_FreeStagingBuffers)
+	{
+		for (StagingBuffer& staging : freeList)
+		{
+			vkFreeMemory(m_Device, staging.memory, nullptr);
+			vkDestroyBuffer(m_Device, staging.buffer, nullptr);
+			m_StagingPoolStats.reservedBytes -= staging.capacity;
+		}
+		freeList.clear();
+	}
+}
+
+PoolStats GraphicsEngine::getStagingPoolStats()
+{
+	std::lock_guard<std::mutex> lock(m_StagingMutex);
+	return m_StagingPoolStats;
+}
+
+PoolStats GraphicsEngine::getVertexPoolStats()
+{
+	return m_VertexPoolStats;
 }
 
 VkDevice GraphicsEngine::getDevice()
@@ -1146,6 +1482,7 @@ void GraphicsEngine::createSyncObjects()
 void GraphicsEngine::drawFrame()
 {
 	vkWaitForFences(m_Device, 1, &inFlightFences[currentFrame], VK_TRUE, UINT64_MAX);
+	recycleBuffers();
 
 	uint32_t imageIndex;
 	VkResult result = vkAcquireNextImageKHR(m_Device, m_Swapchain, UINT64_MAX, imageReadySemaphores[currentFrame], VK_NULL_HANDLE, &imageIndex);
@@ -1167,10 +1504,17 @@ void GraphicsEngine::drawFrame()
 
 	recordCommandBuffer(m_CommandBuffers[currentFrame], imageIndex);
 
+	// the uploads recorded since the last frame go first, the frame's fence covers them too
+	std::array<VkCommandBuffer, 2> commandBuffers;
+	uint32_t commandBufferCount = 0;
+	if (VkCommandBuffer uploads = endUploads())
+		commandBuffers[commandBufferCount++] = uploads;
+	commandBuffers[commandBufferCount++] = m_CommandBuffers[currentFrame];
+
 	VkSubmitInfo submitInfo{};
 	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-	submitInfo.commandBufferCount = 1;
-	submitInfo.pCommandBuffers = &m_CommandBuffers[currentFrame];
+	submitInfo.commandBufferCount = commandBufferCount;
+	submitInfo.pCommandBuffers = commandBuffers.data();
 
 	VkSemaphore waitSemaphores[] = { imageReadySemaphores[currentFrame] };
 	VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
@@ -1183,6 +1527,7 @@ void GraphicsEngine::drawFrame()
 
 	if (vkQueueSubmit(m_GraphicsQueue, 1, &submitInfo, inFlightFences[currentFrame]) != VK_SUCCESS)
 		throw std::runtime_error("Failed to submit draw command buffer");
+	m_FrameNumber++;
 
 	VkPresentInfoKHR presentInfo{};
 	presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
@@ -1250,7 +1595,7 @@ void GraphicsEngine::recordCommandBuffer(VkCommandBuffer buffer, uint32_t imageI
 
 	vkCmdBindDescriptorSets(buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_PipelineLayout, 0, 1, &m_DescriptorSets[currentFrame], 0, nullptr);
 
-	mChunk.Render(buffer);
+	mChunkManager.Render(buffer, m_PipelineLayout);
 	
 	vkCmdEndRenderPass(buffer);
 
@@ -1270,6 +1615,10 @@ void GraphicsEngine::createCommandBuffer()
 
 	if (vkAllocateCommandBuffers(m_Device, &allocInfo, m_CommandBuffers.data()) != VK_SUCCESS)
 		throw std::runtime_error("Failed to allocate command buffer!");
+
+	allocInfo.commandBufferCount = static_cast<uint32_t>(m_UploadCommandBuffers.size());
+	if (vkAllocateCommandBuffers(m_Device, &allocInfo, m_UploadCommandBuffers.data()) != VK_SUCCESS)
+		throw std::runtime_error("Failed to allocate upload command buffers!");
 }
 
 void GraphicsEngine::createCommandPool()
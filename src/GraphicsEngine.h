@@ -12,11 +12,26 @@
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
 #include <glm/glm.hpp>
 #include <array>
+#include <bit>
+#include <mutex>
 #include "World.h"
 #include "structs.h"
 #include "Camera.h"
+#include "JobSystem.h"
+#include "ChunkManager.h"
 
 constexpr uint8_t MAX_FRAMES_IN_FLIGHT = 3;
+// quads addressable by 16-bit indices, bigger meshes use the 32-bit buffer
+constexpr uint32_t MAX_QUADS_16BIT = 65536 / 4;
+// pooled vertex buffers come in power of two sizes from 4 KiB up to a worst-case chunk region
+constexpr uint32_t VERTEXPOOL_MIN_CLASS = 12;
+constexpr uint32_t VERTEXPOOL_CLASSES = std::bit_width(std::bit_ceil(static_cast<uint64_t>(MAXCHUNKQUADS) * 4 * sizeof(ChunkVertex))) - VERTEXPOOL_MIN_CLASS;
+// free buffers kept per size class, releases beyond that are destroyed
+constexpr uint32_t VERTEXPOOL_MAX_FREE = 64;
+// staging buffers share the vertex pool's size classes, those of uploads are back in the pool once the frame that copied them is done
+constexpr uint32_t STAGINGPOOL_MAX_FREE = 16;
+// time the render thread spends each frame on finished job completions, mostly chunk mesh uploads
+constexpr float JOB_COMPLETION_BUDGET_MS = 4.0f;
 const std::string texturePath = "src/txt/atlas.png";
 struct QueueFamilyIndices
 {
@@ -36,6 +51,21 @@ struct SwapchainSupportDetails
 	VkSurfaceCapabilitiesKHR capabilities;
 };
 
+// render loop frame times, kept apart for the frames an autosave was running in to see what saving costs
+struct FrameTimeStats
+{
+	uint64_t frames = 0;
+	double totalMs = 0.0;
+	double worstMs = 0.0;
+
+	void add(double ms)
+	{
+		frames++;
+		totalMs += ms;
+		if (ms > worstMs) worstMs = ms;
+	}
+};
+
 
 
 
@@ -53,13 +83,51 @@ public:
 	void setFramebufferResized(bool resized);
 
 	
-	static void createIndexBuffer(const std::vector<uint16_t>& indices, VkBuffer& buffer, VkDeviceMemory& bufferMemory);
-	static void createVertexBuffer(const std::vector<Vertex>& vertices, VkBuffer& buffer, VkDeviceMemory& bufferMemory);
+	static void createIndexBuffer(const void* indices, VkDeviceSize size, VkBuffer& buffer, VkDeviceMemory& bufferMemory);
+	template<typename T>
+	static void createIndexBuffer(const std::vector<T>& indices, VkBuffer& buffer, VkDeviceMemory& bufferMemory)
+	{
+		createIndexBuffer(indices.data(), sizeof(T) * indices.size(), buffer, bufferMemory);
+	}
+	static void bindQuadIndexBuffer(VkCommandBuffer commandBuffer, uint32_t quadCount);
+	// thread-safe, chunk meshes are staged on the job system's workers
+	static StagingBuffer createStagingBuffer(VkDeviceSize size);
+	// copies into a new device-local buffer and releases the staging buffer, waits for the copy
+	static void uploadStagingBuffer(StagingBuffer& staging, VkBufferUsageFlags usage, VkBuffer& buffer, VkDeviceMemory& bufferMemory);
+	// thread-safe, returns the buffer to the staging pool
+	static void releaseStagingBuffer(StagingBuffer& staging);
+	// copies into a vertex buffer from the pool with the frame's uploads, the staging
+	// buffer goes back to the pool once the frame is done. Render thread only
+	static void uploadVertexBuffer(StagingBuffer& staging, PooledBuffer& buffer);
+	// changes a vertex buffer in place with the frame's uploads, which wait for the frames
+	// drawing from it: copies ranges of the staging buffer into it and zeroes the cleared
+	// ranges, the staging buffer goes back to the pool once the frame is done
+	static void updateVertexBuffer(StagingBuffer& staging, PooledBuffer& buffer, const std::vector<VkBufferCopy>& copies, const std::vector<BufferRange>& clears);
+	// the buffer is reused once the frames in flight that may read it have finished
+	static void releaseVertexBuffer(PooledBuffer& buffer);
+	static void createVertexBuffer(const void* vertices, VkDeviceSize size, VkBuffer& buffer, VkDeviceMemory& bufferMemory);
+	template<typename T>
+	static void createVertexBuffer(const std::vector<T>& vertices, VkBuffer& buffer, VkDeviceMemory& bufferMemory)
+	{
+		createVertexBuffer(vertices.data(), sizeof(T) * vertices.size(), buffer, bufferMemory);
+	}
 	static VkDevice getDevice();
+	static PoolStats getStagingPoolStats();
+	static PoolStats getVertexPoolStats();
 private:
 	GraphicsEngine() = default;
 	
 	void initChunk();
+	void createQuadIndexBuffers();
+	// returns the vertex and staging buffers of the frames that have finished to their pools
+	void recycleBuffers();
+	// the command buffer the uploads of the next frame submitted are recorded into
+	static VkCommandBuffer beginUploads();
+	// ends it, VK_NULL_HANDLE if nothing was uploaded
+	static VkCommandBuffer endUploads();
+	static void retireStagingBuffer(StagingBuffer& staging);
+	void destroyVertexBufferPool();
+	static void destroyStagingPool();
 	void createColorResources();
 	VkSampleCountFlagBits getMaxSampleCount();
 	bool hasStencilComponent(VkFormat format);
@@ -138,6 +206,30 @@ private:
 	int m_Width, m_Height;
 
 	static VkCommandPool m_CPool;
+
+	// shared by every chunk mesh: quad q uses vertices 4q..4q+3
+	static VkBuffer m_QuadIndexBuffer16;
+	static VkDeviceMemory m_QuadIndexBuffer16Memory;
+	static VkBuffer m_QuadIndexBuffer32;
+	static VkDeviceMemory m_QuadIndexBuffer32Memory;
+
+	// vertex buffer pool, free lists per size class and releases waiting on frames in flight
+	static std::array<std::vector<PooledBuffer>, VERTEXPOOL_CLASSES> m_FreeVertexBuffers;
+	static std::vector<std::pair<uint64_t, PooledBuffer>> m_RetiredVertexBuffers;
+	static uint64_t m_FrameNumber;
+	static PoolStats m_VertexPoolStats;
+
+	// staging buffer pool, filled and emptied from workers and the render thread
+	static std::mutex m_StagingMutex;
+	static std::array<std::vector<StagingBuffer>, VERTEXPOOL_CLASSES> m_FreeStagingBuffers;
+	static std::vector<std::pair<uint64_t, StagingBuffer>> m_RetiredStagingBuffers;
+	static PoolStats m_StagingPoolStats;
+
+	// chunk uploads, recorded into the command buffer of m_FrameNumber and submitted
+	// ahead of that frame's draw so its fence covers them. One more than the frames in
+	// flight, a frame's uploads are recorded before it waits for its fence
+	static std::array<VkCommandBuffer, MAX_FRAMES_IN_FLIGHT + 1> m_UploadCommandBuffers;
+	static bool m_Uploading;
 	std::vector<VkCommandBuffer> m_CommandBuffers;
 
 	std::vector<VkFramebuffer> m_Framebuffers;
@@ -169,9 +261,12 @@ private:
 	VkDeviceMemory colorImageMemory;
 	VkImageView colorImageView;
 
-	Chunk mChunk = Chunk({ 0,0 });
+	JobSystem mJobs;
+	ChunkManager mChunkManager{ mJobs };
 
 	Camera mCamera;
+	FrameTimeStats mFrameTimes;
+	FrameTimeStats mAutosaveFrameTimes;
 };
 
 static void framebufferResizeCallback(GLFWwindow* window, int width, int height)
@@ -0,0 +1,223 @@
+#include "JobSystem.h"
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+
+// worker index of the current thread in sOwner, so nested submits stay local
+static thread_local const JobSystem* sOwner = nullptr;
+static thread_local uint32_t sWorkerIndex = 0;
+
+CompletionQueue::CompletionQueue()
+	:mHead(&mStub), mTail(&mStub)
+{
+}
+
+void CompletionQueue::push(Job* job)
+{
+	job->next.store(nullptr, std::memory_order_relaxed);
+	Job* previous = mHead.exchange(job, std::memory_order_acq_rel);
+	previous->next.store(job, std::memory_order_release);
+}
+
+Job* CompletionQueue::pop()
+{
+	Job* tail = mTail;
+	Job* next = tail->next.load(std::memory_order_acquire);
+
+	if (tail == &mStub)
+	{
+		if (next == nullptr) return nullptr;
+		mTail = next;
+		tail = next;
+		next = next->next.load(std::memory_order_acquire);
+	}
+
+	if (next != nullptr)
+	{
+		mTail = next;
+		return tail;
+	}
+
+	// tail is the last job unless a producer has swapped the head but not linked yet
+	if (tail != mHead.load(std::memory_order_acquire)) return nullptr;
+
+	push(&mStub);
+	next = tail->next.load(std::memory_order_acquire);
+	if (next != nullptr)
+	{
+		mTail = next;
+		return tail;
+	}
+	return nullptr;
+}
+
+JobSystem::~JobSystem()
+{
+	stop();
+}
+
+void JobSystem::start(uint32_t workerCount)
+{
+	if (!mWorkers.empty()) return;
+
+	if (workerCount == 0)
+		workerCount = std::max(1u, std::thread::hardware_concurrency() - 1);
+
+	mStopping = false;
+	for (uint32_t i = 0; i < workerCount; i++)
+		mWorkers.push_back(std::make_unique<Worker>());
+	for (uint32_t i = 0; i < workerCount; i++)
+		mWorkers[i]->thread = std::thread(&JobSystem::workerLoop, this, i);
+}
+
+void JobSystem::stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(mWakeMutex);
+		mStopping = true;
+	}
+	mWake.notify_all();
+
+	for (auto& worker : mWorkers)
+		if (worker->thread.joinable())
+			worker->thread.join();
+
+	for (auto& worker : mWorkers)
+		for (Job* job : worker->jobs)
+			delete job;
+	mWorkers.clear();
+
+	while (Job* job = mCompleted.pop())
+		delete job;
+
+	mQueued = 0;
+	mPending = 0;
+}
+
+void JobSystem::submit(std::function<void()> work, std::function<void(std::exception_ptr)> completion)
+{
+	if (mWorkers.empty())
+		throw std::runtime_error("Failed to submit job, job system is not running!");
+
+	Job* job = new Job();
+	job->work = std::move(work);
+	job->completion = std::move(completion);
+
+	const uint32_t index = sOwner == this ? sWorkerIndex : mNextWorker.fetch_add(1, std::memory_order_relaxed) % mWorkers.size();
+	{
+		std::lock_guard<std::mutex> lock(mWorkers[index]->mutex);
+		mWorkers[index]->jobs.push_back(job);
+	}
+	mPending.fetch_add(1, std::memory_order_relaxed);
+	mQueued.fetch_add(1, std::memory_order_release);
+
+	// taking the lock orders this against a worker that is about to sleep
+	{
+		std::lock_guard<std::mutex> lock(mWakeMutex);
+	}
+	mWake.notify_one();
+}
+
+void JobSystem::complete(std::function<void()> completion)
+{
+	Job* job = new Job();
+	job->completion = [completion = std::move(completion)](std::exception_ptr) { completion(); };
+	mPending.fetch_add(1, std::memory_order_relaxed);
+	mCompleted.push(job);
+}
+
+uint32_t JobSystem::runCompletions(float budgetMs)
+{
+	const auto start = std::chrono::steady_clock::now();
+
+	uint32_t count = 0;
+	while (Job* job = mCompleted.pop())
+	{
+		std::unique_ptr<Job> owned(job);
+		mPending.fetch_sub(1, std::memory_order_relaxed);
+		count++;
+
+		// the completion releases what the job held whether or not its work succeeded
+		if (owned->completion)
+			owned->completion(owned->error);
+		else if (owned->error)
+			std::rethrow_exception(owned->error);
+
+		if (std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count() >= budgetMs)
+			break;
+	}
+	return count;
+}
+
+uint32_t JobSystem::getWorkerCount() const
+{
+	return static_cast<uint32_t>(mWorkers.size());
+}
+
+uint32_t JobSystem::getPendingCount() const
+{
+	return mPending.load(std::memory_order_relaxed);
+}
+
+void JobSystem::workerLoop(uint32_t index)
+{
+	sOwner = this;
+	sWorkerIndex = index;
+
+	while (!mStopping)
+	{
+		if (Job* job = takeJob(index))
+		{
+			try
+			{
+				job->work();
+			}
+			catch (...)
+			{
+				job->error = std::current_exception();
+			}
+			finishJob(job);
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(mWakeMutex);
+		mWake.wait(lock, [this] { return mStopping || mQueued.load(std::memory_order_acquire) > 0; });
+	}
+}
+
+Job* JobSystem::takeJob(uint32_t index)
+{
+	// newest job of our own first, it is the most likely to still be in cache
+	{
+		Worker& own = *mWorkers[index];
+		std::lock_guard<std::mutex> lock(own.mutex);
+		if (!own.jobs.empty())
+		{
+			Job* job = own.jobs.back();
+			own.jobs.pop_back();
+			mQueued.fetch_sub(1, std::memory_order_relaxed);
+			return job;
+		}
+	}
+
+	// then the oldest job of another worker, starting with our right-hand neighbour
+	const uint32_t count = static_cast<uint32_t>(mWorkers.size());
+	for (uint32_t i = 1; i < count; i++)
+	{
+		Worker& victim = *mWorkers[(index + i) % count];
+		std::unique_lock<std::mutex> lock(victim.mutex, std::try_to_lock);
+		if (!lock.owns_lock() || victim.jobs.empty()) continue;
+
+		Job* job = victim.jobs.front();
+		victim.jobs.pop_front();
+		mQueued.fetch_sub(1, std::memory_order_relaxed);
+		return job;
+	}
+	return nullptr;
+}
+
+void JobSystem::finishJob(Job* job)
+{
+	job->work = nullptr;
+	mCompleted.push(job);
+}
\ No newline at end of file
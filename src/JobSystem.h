@@ -0,0 +1,100 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A unit of work. work runs on a worker thread, completion runs afterwards on
+// the thread that calls runCompletions (the render thread) and is handed what
+// work threw, null if it returned.
+struct Job
+{
+	std::function<void()> work;
+	std::function<void(std::exception_ptr)> completion;
+	std::exception_ptr error;
+
+	// intrusive link for the completion queue
+	std::atomic<Job*> next{ nullptr };
+};
+
+// Lock-free multi-producer single-consumer queue of finished jobs: workers push,
+// only the render thread pops.
+class CompletionQueue
+{
+public:
+	CompletionQueue();
+
+	CompletionQueue(const CompletionQueue&) = delete;
+	CompletionQueue& operator=(const CompletionQueue&) = delete;
+
+	void push(Job* job);
+	// nullptr when empty, or when a push is still half way through
+	Job* pop();
+private:
+	std::atomic<Job*> mHead;
+	Job* mTail;
+	Job mStub;
+};
+
+// Work-stealing thread pool. Every worker owns a deque: it takes its own newest
+// job from the back and steals the oldest job from the front of another worker's
+// deque when it runs dry.
+class JobSystem
+{
+public:
+	JobSystem() = default;
+	~JobSystem();
+
+	JobSystem(const JobSystem&) = delete;
+	JobSystem& operator=(const JobSystem&) = delete;
+
+	// 0 workers = one per hardware thread, minus the render thread
+	void start(uint32_t workerCount = 0);
+	// joins the workers, queued jobs that have not started are dropped
+	void stop();
+
+	// callable from any thread, jobs submitted by a worker go to its own deque
+	void submit(std::function<void()> work, std::function<void(std::exception_ptr)> completion = {});
+	// queues completion to run on the runCompletions thread as if a job had just
+	// finished, for work done outside the workers such as asynchronous I/O.
+	// Callable from any thread
+	void complete(std::function<void()> completion);
+	// runs the completions of finished jobs on the calling thread, each with the
+	// exception its work threw; one of a job without a completion is rethrown.
+	// Returns the number run. Stops once budgetMs have passed, the rest wait for
+	// the next call
+	uint32_t runCompletions(float budgetMs = std::numeric_limits<float>::infinity());
+
+	uint32_t getWorkerCount() const;
+	uint32_t getPendingCount() const;
+private:
+	struct Worker
+	{
+		std::mutex mutex;
+		std::deque<Job*> jobs;
+		std::thread thread;
+	};
+
+	void workerLoop(uint32_t index);
+	Job* takeJob(uint32_t index);
+	void finishJob(Job* job);
+private:
+	std::vector<std::unique_ptr<Worker>> mWorkers;
+	std::atomic<uint32_t> mNextWorker{ 0 };
+
+	// jobs sitting in a deque, workers sleep on mWake while it is zero
+	std::atomic<uint32_t> mQueued{ 0 };
+	// submitted jobs whose completion has not run yet
+	std::atomic<uint32_t> mPending{ 0 };
+	std::mutex mWakeMutex;
+	std::condition_variable mWake;
+	std::atomic<bool> mStopping{ false };
+
+	CompletionQueue mCompleted;
+};
\ No newline at end of file
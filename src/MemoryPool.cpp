@@ -0,0 +1,106 @@
+#include "MemoryPool.h"
+#include <new>
+#include <stdexcept>
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+static void* allocateSlab()
+{
+#ifdef __linux__
+	if (MEMORYPOOL_HUGE_PAGES)
+	{
+		// map one huge page extra and trim it off so the slab starts on a huge page boundary
+		const size_t mapped = MEMORYPOOL_SLAB_SIZE + MEMORYPOOL_HUGE_PAGE_SIZE;
+		void* raw = mmap(nullptr, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (raw == MAP_FAILED)
+			throw std::runtime_error("Failed to map memory pool slab!");
+
+		const uintptr_t start = reinterpret_cast<uintptr_t>(raw);
+		const uintptr_t aligned = (start + MEMORYPOOL_HUGE_PAGE_SIZE - 1) & ~(MEMORYPOOL_HUGE_PAGE_SIZE - 1);
+		if (aligned > start)
+			munmap(raw, aligned - start);
+		if (aligned + MEMORYPOOL_SLAB_SIZE < start + mapped)
+			munmap(reinterpret_cast<void*>(aligned + MEMORYPOOL_SLAB_SIZE), start + mapped - aligned - MEMORYPOOL_SLAB_SIZE);
+
+		// only a hint, without transparent huge pages the slab is backed by normal pages
+		madvise(reinterpret_cast<void*>(aligned), MEMORYPOOL_SLAB_SIZE, MADV_HUGEPAGE);
+		return reinterpret_cast<void*>(aligned);
+	}
+#endif
+	return ::operator new(MEMORYPOOL_SLAB_SIZE, std::align_val_t(MEMORYPOOL_BLOCK_ALIGNMENT));
+}
+
+static void freeSlab(void* slab)
+{
+#ifdef __linux__
+	if (MEMORYPOOL_HUGE_PAGES)
+	{
+		munmap(slab, MEMORYPOOL_SLAB_SIZE);
+		return;
+	}
+#endif
+	::operator delete(slab, std::align_val_t(MEMORYPOOL_BLOCK_ALIGNMENT));
+}
+
+BlockPool::BlockPool(size_t blockSize)
+	:mBlockSize((blockSize + MEMORYPOOL_BLOCK_ALIGNMENT - 1) & ~(MEMORYPOOL_BLOCK_ALIGNMENT - 1))
+{
+	if (mBlockSize > MEMORYPOOL_SLAB_SIZE)
+		throw std::runtime_error("Failed to create block pool, blocks are bigger than a slab!");
+}
+
+BlockPool::~BlockPool()
+{
+	for (void* slab : mSlabs)
+		freeSlab(slab);
+}
+
+void* BlockPool::allocate()
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	mStats.allocated(mBlockSize);
+
+	if (mFree)
+	{
+		FreeBlock* block = mFree;
+		mFree = block->next;
+		return block;
+	}
+
+	if (mCursor == nullptr || mSlabEnd - mCursor < static_cast<ptrdiff_t>(mBlockSize))
+	{
+		mSlabs.push_back(allocateSlab());
+		mCursor = static_cast<char*>(mSlabs.back());
+		mSlabEnd = mCursor + MEMORYPOOL_SLAB_SIZE;
+		mStats.reservedBytes += MEMORYPOOL_SLAB_SIZE;
+		mStats.systemAllocations++;
+	}
+
+	void* block = mCursor;
+	mCursor += mBlockSize;
+	return block;
+}
+
+void BlockPool::free(void* block)
+{
+	if (!block) return;
+
+	std::lock_guard<std::mutex> lock(mMutex);
+	mStats.liveBytes -= mBlockSize;
+
+	FreeBlock* freed = static_cast<FreeBlock*>(block);
+	freed->next = mFree;
+	mFree = freed;
+}
+
+size_t BlockPool::getBlockSize() const
+{
+	return mBlockSize;
+}
+
+PoolStats BlockPool::getStats() const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mStats;
+}
\ No newline at end of file
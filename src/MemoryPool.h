@@ -0,0 +1,71 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// Linux only: back slabs with transparent huge pages, which needs them 2 MiB big and aligned
+constexpr bool MEMORYPOOL_HUGE_PAGES = false;
+constexpr size_t MEMORYPOOL_HUGE_PAGE_SIZE = 2 << 20;
+constexpr size_t MEMORYPOOL_SLAB_SIZE = MEMORYPOOL_HUGE_PAGES ? MEMORYPOOL_HUGE_PAGE_SIZE : 256 << 10;
+// blocks are rounded up to whole cache lines so two never share one
+constexpr size_t MEMORYPOOL_BLOCK_ALIGNMENT = 64;
+
+// Usage of one of the engine's memory pools, in bytes
+struct PoolStats
+{
+	size_t liveBytes = 0;     // handed out right now
+	size_t peakBytes = 0;     // most handed out at once
+	size_t reservedBytes = 0; // taken from the system, handed out or free
+	uint64_t systemAllocations = 0;
+
+	void allocated(size_t bytes)
+	{
+		liveBytes += bytes;
+		if (liveBytes > peakBytes) peakBytes = liveBytes;
+	}
+
+	// the pools' peaks fall at different times and do not add up, whoever combines
+	// pools tracks their peak together
+	PoolStats& operator+=(const PoolStats& other)
+	{
+		liveBytes += other.liveBytes;
+		reservedBytes += other.reservedBytes;
+		systemAllocations += other.systemAllocations;
+		return *this;
+	}
+};
+
+// Fixed-size blocks carved out of slabs. Slabs go back to the system only when the
+// pool is destroyed, so once the working set has been reached allocate and free are
+// a free list pop and push. Thread-safe.
+class BlockPool
+{
+public:
+	BlockPool(size_t blockSize);
+	~BlockPool();
+
+	BlockPool(const BlockPool&) = delete;
+	BlockPool& operator=(const BlockPool&) = delete;
+
+	// uninitialised block of getBlockSize() bytes
+	void* allocate();
+	void free(void* block);
+
+	size_t getBlockSize() const;
+	PoolStats getStats() const;
+private:
+	struct FreeBlock
+	{
+		FreeBlock* next;
+	};
+private:
+	const size_t mBlockSize;
+	mutable std::mutex mMutex;
+	FreeBlock* mFree = nullptr;
+	// never handed out part of the newest slab, carved on demand so untouched pages stay uncommitted
+	char* mCursor = nullptr;
+	char* mSlabEnd = nullptr;
+	std::vector<void*> mSlabs;
+	PoolStats mStats;
+};
\ No newline at end of file
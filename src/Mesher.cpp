@@ -0,0 +1,593 @@
+#include "Mesher.h"
+#include <bit>
+#include <cstring>
+#include <memory>
+
+// FRONT = Z-
+// BACK = Z+
+// LEFT = X-
+// RIGHT = X+
+// BOTTOM = Y+
+// TOP = Y-
+// texture directions along u and v live in shader.vert (UAXES/VAXES)
+struct FaceAxes
+{
+    int normal; // axis the face points along
+    int offset; // 1 when the face lies on the far side of the block
+    int u, v;   // in-plane axes, in texture order
+};
+
+static const std::array<FaceAxes, 6> FACEAXES = { {
+    { 2, 0, 0, 1 }, // FRONT
+    { 2, 1, 0, 1 }, // BACK
+    { 0, 1, 2, 1 }, // RIGHT
+    { 0, 0, 2, 1 }, // LEFT
+    { 1, 0, 0, 2 }, // TOP
+    { 1, 1, 0, 2 }, // BOTTOM
+} };
+
+template<typename Dims>
+static inline int columnIndex(int x, int z)
+{
+    return (x + 1) * PaddedChunk<Dims>::SIZE + (z + 1);
+}
+
+// opaque throughout; outside the world and missing neighbours are air. Section
+// coordinates outside the chunk continue into the horizontal neighbours
+template<typename Dims>
+static bool isOpaqueSection(const BasicChunkData<Dims>& data, const std::array<const BasicChunkData<Dims>*, BORDERMESHES>& neighbours, int sectionX, int sectionY, int sectionZ)
+{
+    const BasicChunkData<Dims>* source = &data;
+    if (sectionX < 0)
+    {
+        source = neighbours[LEFT];
+        sectionX += Dims::SECTIONSXZ;
+    }
+    else if (sectionX >= Dims::SECTIONSXZ)
+    {
+        source = neighbours[RIGHT];
+        sectionX -= Dims::SECTIONSXZ;
+    }
+    else if (sectionZ < 0)
+    {
+        source = neighbours[FRONT];
+        sectionZ += Dims::SECTIONSXZ;
+    }
+    else if (sectionZ >= Dims::SECTIONSXZ)
+    {
+        source = neighbours[BACK];
+        sectionZ -= Dims::SECTIONSXZ;
+    }
+
+    if (!source || sectionY < 0 || sectionY >= Dims::SECTIONSY) return false;
+    const ChunkSection& section = source->getSection(sectionX, sectionY, sectionZ);
+    return section.getType() != MIXED && isBlockOpaque(section.getUniformBlock());
+}
+
+template<typename Dims>
+uint32_t PaddedChunk<Dims>::fill(const BasicChunkData<Dims>& data, const std::array<const BasicChunkData<Dims>*, BORDERMESHES>& neighbours, int band)
+{
+    // a uniform section only shows faces where it touches a section that is not opaque throughout
+    activeSections = 0;
+    for (int layer = 0; layer < BANDSECTIONS; layer++)
+    {
+        const int sectionY = band * BANDSECTIONS + layer;
+        for (int sectionX = 0; sectionX < Dims::SECTIONSXZ; sectionX++)
+            for (int sectionZ = 0; sectionZ < Dims::SECTIONSXZ; sectionZ++)
+            {
+                const ChunkSection& section = data.getSection(sectionX, sectionY, sectionZ);
+
+                bool active = section.getType() == MIXED;
+                if (!active && isBlockRendered(section.getUniformBlock()))
+                    active = !isOpaqueSection(data, neighbours, sectionX, sectionY - 1, sectionZ) || !isOpaqueSection(data, neighbours, sectionX, sectionY + 1, sectionZ)
+                        || !isOpaqueSection(data, neighbours, sectionX - 1, sectionY, sectionZ) || !isOpaqueSection(data, neighbours, sectionX + 1, sectionY, sectionZ)
+                        || !isOpaqueSection(data, neighbours, sectionX, sectionY, sectionZ - 1) || !isOpaqueSection(data, neighbours, sectionX, sectionY, sectionZ + 1);
+                if (active) activeSections |= 1u << layer;
+            }
+    }
+    if (activeSections == 0) return 0;
+
+    uniformBits.fill(0);
+    uniformRendered.fill(0);
+    uniformOpaque.fill(0);
+
+    uint32_t bytesCopied = 0;
+    for (int layer = 0; layer < BANDSECTIONS; layer++)
+        for (int sectionX = 0; sectionX < Dims::SECTIONSXZ; sectionX++)
+            for (int sectionZ = 0; sectionZ < Dims::SECTIONSXZ; sectionZ++)
+                bytesCopied += copySection(data.getSection(sectionX, band * BANDSECTIONS + layer, sectionZ), sectionX, layer, sectionZ);
+    for (int side = 0; side < BORDERMESHES; side++)
+        bytesCopied += copyBorder(static_cast<BLOCKFACE>(side), neighbours[side], band);
+    bytesCopied += copyLayer(data, band * BANDHEIGHT - 1, -1);
+    bytesCopied += copyLayer(data, band * BANDHEIGHT + BANDHEIGHT, BANDHEIGHT);
+
+    return bytesCopied;
+}
+
+template<typename Dims>
+uint32_t PaddedChunk<Dims>::copySection(const ChunkSection& section, int sectionX, int layer, int sectionZ)
+{
+    const int baseX = sectionX * SECTIONSIZE;
+    const int baseY = layer * SECTIONSIZE;
+    const int baseZ = sectionZ * SECTIONSIZE;
+
+    if (section.getType() != MIXED)
+    {
+        const int column = sectionColumn(baseX, baseZ);
+        setUniformBits(column, layer, section.getUniformBlock());
+
+        for (int x = 0; x < SECTIONSIZE; x++)
+            for (int y = 0; y < SECTIONSIZE; y++)
+                memset(&voxels[index(baseX + x, baseY + y, baseZ)], section.getUniformBlock(), SECTIONSIZE);
+        return 0;
+    }
+
+    // rows along z are contiguous both here and in the linear section layout
+    for (int x = 0; x < SECTIONSIZE; x++)
+        for (int y = 0; y < SECTIONSIZE; y++)
+            section.getRow(x, y, &voxels[index(baseX + x, baseY + y, baseZ)]);
+    return SECTIONVOLUME;
+}
+
+template<typename Dims>
+void PaddedChunk<Dims>::setUniformBits(int column, int layer, uint8_t block)
+{
+    const ColumnMask bits = getSectionBits(layer);
+    uniformBits[column] |= bits;
+    if (isBlockRendered(block)) uniformRendered[column] |= bits;
+    if (isBlockOpaque(block)) uniformOpaque[column] |= bits;
+}
+
+template<typename Dims>
+uint32_t PaddedChunk<Dims>::copyBorder(BLOCKFACE side, const BasicChunkData<Dims>* neighbour, int band)
+{
+    // the neighbour's outermost layer on the side that touches this chunk
+    const bool farSide = side == FRONT || side == LEFT;
+    const int srcSection = farSide ? Dims::SECTIONSXZ - 1 : 0;
+    const int src = farSide ? SECTIONSIZE - 1 : 0;
+    const int dst = farSide ? -1 : Dims::SIZE;
+
+    uint32_t bytesCopied = 0;
+    for (int layer = 0; layer < BANDSECTIONS; layer++)
+        for (int k = 0; k < Dims::SECTIONSXZ; k++)
+        {
+            // k runs along the border: z for LEFT and RIGHT, x for FRONT and BACK
+            const bool alongZ = side == LEFT || side == RIGHT;
+            const int sectionY = band * BANDSECTIONS + layer;
+            const ChunkSection* section = nullptr;
+            if (neighbour)
+                section = alongZ ? &neighbour->getSection(srcSection, sectionY, k) : &neighbour->getSection(k, sectionY, srcSection);
+
+            const bool mixed = section && section->getType() == MIXED;
+            const int baseY = layer * SECTIONSIZE;
+            const int base = k * SECTIONSIZE;
+
+            if (!mixed)
+            {
+                const int column = alongZ ? sectionColumn(dst, base) : sectionColumn(base, dst);
+                setUniformBits(column, layer, section ? section->getUniformBlock() : static_cast<uint8_t>(AIR));
+            }
+            else
+                bytesCopied += SECTIONSIZE * SECTIONSIZE;
+
+            const uint8_t block = section ? section->getUniformBlock() : static_cast<uint8_t>(AIR);
+            if (alongZ)
+            {
+                // rows along z are contiguous in the padded copy
+                for (int y = 0; y < SECTIONSIZE; y++)
+                {
+                    if (mixed)
+                        section->getRow(src, y, &voxels[index(dst, baseY + y, base)]);
+                    else
+                        memset(&voxels[index(dst, baseY + y, base)], block, SECTIONSIZE);
+                }
+            }
+            else
+                for (int x = 0; x < SECTIONSIZE; x++)
+                {
+                    uint8_t column[SECTIONSIZE];
+                    if (mixed)
+                        section->getColumn(x, src, column);
+                    for (int y = 0; y < SECTIONSIZE; y++)
+                        voxels[index(base + x, baseY + y, dst)] = mixed ? column[y] : block;
+                }
+        }
+    return bytesCopied;
+}
+
+template<typename Dims>
+uint32_t PaddedChunk<Dims>::copyLayer(const BasicChunkData<Dims>& data, int y, int paddedY)
+{
+    // the chunk's own layer just outside the band, air outside the world
+    const bool inside = y >= 0 && y < Dims::HEIGHT;
+    const int sectionY = y / SECTIONSIZE;
+    const int localY = y % SECTIONSIZE;
+
+    uint32_t bytesCopied = 0;
+    for (int sectionX = 0; sectionX < Dims::SECTIONSXZ; sectionX++)
+        for (int sectionZ = 0; sectionZ < Dims::SECTIONSXZ; sectionZ++)
+        {
+            const ChunkSection* section = inside ? &data.getSection(sectionX, sectionY, sectionZ) : nullptr;
+            const bool mixed = section && section->getType() == MIXED;
+
+            for (int x = 0; x < SECTIONSIZE; x++)
+            {
+                uint8_t* row = &voxels[index(sectionX * SECTIONSIZE + x, paddedY, sectionZ * SECTIONSIZE)];
+                if (mixed)
+                    section->getRow(x, localY, row);
+                else
+                    memset(row, section ? section->getUniformBlock() : static_cast<uint8_t>(AIR), SECTIONSIZE);
+            }
+            if (mixed) bytesCopied += SECTIONSIZE * SECTIONSIZE;
+        }
+    return bytesCopied;
+}
+
+template<typename Dims>
+MeshScratch<Dims>& MeshScratch<Dims>::get()
+{
+    thread_local std::unique_ptr<MeshScratch> scratch;
+    if (!scratch)
+    {
+        scratch = std::make_unique<MeshScratch>();
+        scratch->vertices.resize(Dims::MAXQUADS * 4);
+        scratch->mAllocations += 2;
+    }
+    return *scratch;
+}
+
+template<typename Dims>
+uint32_t MeshScratch<Dims>::takeAllocations()
+{
+    uint32_t allocations = mAllocations;
+    mAllocations = 0;
+    return allocations;
+}
+
+// Slices of face that belong to region. Vertical faces never touch a neighbour
+// chunk, horizontal ones on the outermost slice belong to that border's mesh.
+template<typename Dims>
+bool ChunkMesher<Dims>::getRegionSlices(BLOCKFACE face, int region, int& firstSlice, int& lastSlice)
+{
+    const FaceAxes& axes = FACEAXES[face];
+    firstSlice = 0;
+    lastSlice = AXISSIZE[axes.normal];
+
+    if (axes.normal == 1)
+        return region == INTERIORMESH;
+
+    if (region == INTERIORMESH)
+    {
+        if (axes.offset) lastSlice--;
+        else firstSlice++;
+        return true;
+    }
+    if (region != face)
+        return false;
+
+    firstSlice = axes.offset ? lastSlice - 1 : 0;
+    lastSlice = firstSlice + 1;
+    return true;
+}
+
+// whether column (x,z) holds faces of the given slices, vertical faces span every column
+static bool columnInSlices(const FaceAxes& axes, int x, int z, int firstSlice, int lastSlice)
+{
+    if (axes.normal == 1) return true;
+
+    const int slice = axes.normal == 0 ? x : z;
+    return slice >= firstSlice && slice < lastSlice;
+}
+
+template<typename Dims>
+ChunkMesher<Dims>::ChunkMesher(const std::array<PaddedChunk<Dims>, BANDCOUNT<Dims>>& input)
+    :mInput(input), mRendered{}, mOpaque{}, mMask{}
+{
+}
+
+template<typename Dims>
+void ChunkMesher<Dims>::prepare(uint32_t bands)
+{
+    for (int band = 0; band < BANDCOUNT<Dims>; band++)
+        if (bands & (1u << band))
+            buildFaceMasks(band);
+}
+
+template<typename Dims>
+MeshStats ChunkMesher<Dims>::buildMesh(MESHINGMODE mode, int region, ChunkVertex* out)
+{
+    mStats = MeshStats{};
+    mOut = out;
+    mMin = glm::ivec3(0);
+    mMax = glm::ivec3(Dims::SIZE, BANDHEIGHT, Dims::SIZE);
+    mLayerBits = ~0ull;
+
+    for (int band = 0; band < BANDCOUNT<Dims>; band++)
+        buildBand(mode, region, band);
+
+    return mStats;
+}
+
+template<typename Dims>
+MeshStats ChunkMesher<Dims>::buildMesh(MESHINGMODE mode, int region, int section, ChunkVertex* out)
+{
+    mStats = MeshStats{};
+    mOut = out;
+
+    const glm::ivec3 position = Dims::sectionPosition(section);
+    const int layer = position.y % BANDSECTIONS;
+    mMin = glm::ivec3(position.x, layer, position.z) * static_cast<int>(SECTIONSIZE);
+    mMax = mMin + static_cast<int>(SECTIONSIZE);
+    mLayerBits = getSectionBits(layer);
+
+    buildBand(mode, region, position.y / BANDSECTIONS);
+    return mStats;
+}
+
+template<typename Dims>
+void ChunkMesher<Dims>::buildBand(MESHINGMODE mode, int region, int band)
+{
+    mBand = band;
+    mBandInput = &mInput[band];
+    if (mBandInput->activeSections == 0) return;
+
+    for (int face = FRONT; face <= BOTTOM; face++)
+    {
+        int firstSlice, lastSlice;
+        if (!getRegionSlices(static_cast<BLOCKFACE>(face), region, firstSlice, lastSlice)) continue;
+
+        const int normal = FACEAXES[face].normal;
+        firstSlice = std::max(firstSlice, mMin[normal]);
+        lastSlice = std::min(lastSlice, mMax[normal]);
+        if (firstSlice >= lastSlice) continue;
+
+        if (mode == PERFACE)
+            buildPerFace(static_cast<BLOCKFACE>(face), firstSlice, lastSlice);
+        else
+            buildGreedy(static_cast<BLOCKFACE>(face), firstSlice, lastSlice);
+    }
+}
+
+template<typename Dims>
+uint32_t ChunkMesher<Dims>::countFaces(int region) const
+{
+    uint32_t faces = 0;
+    for (int band = 0; band < BANDCOUNT<Dims>; band++)
+    {
+        if (mInput[band].activeSections == 0) continue;
+
+        for (int face = FRONT; face <= BOTTOM; face++)
+        {
+            int firstSlice, lastSlice;
+            if (!getRegionSlices(static_cast<BLOCKFACE>(face), region, firstSlice, lastSlice)) continue;
+
+            for (int x = 0; x < Dims::SIZE; x++)
+                for (int z = 0; z < Dims::SIZE; z++)
+                    if (columnInSlices(FACEAXES[face], x, z, firstSlice, lastSlice))
+                        faces += std::popcount(mFaceMasks[band][face][x * Dims::SIZE + z]);
+        }
+    }
+    return faces;
+}
+
+template<typename Dims>
+uint32_t ChunkMesher<Dims>::countFaces(int region, int section) const
+{
+    const glm::ivec3 position = Dims::sectionPosition(section);
+    const int band = position.y / BANDSECTIONS;
+    if (mInput[band].activeSections == 0) return 0;
+
+    const ColumnMask layerBits = getSectionBits(position.y % BANDSECTIONS);
+    const int baseX = position.x * SECTIONSIZE;
+    const int baseZ = position.z * SECTIONSIZE;
+
+    uint32_t faces = 0;
+    for (int face = FRONT; face <= BOTTOM; face++)
+    {
+        int firstSlice, lastSlice;
+        if (!getRegionSlices(static_cast<BLOCKFACE>(face), region, firstSlice, lastSlice)) continue;
+
+        for (int x = baseX; x < baseX + SECTIONSIZE; x++)
+            for (int z = baseZ; z < baseZ + SECTIONSIZE; z++)
+                if (columnInSlices(FACEAXES[face], x, z, firstSlice, lastSlice))
+                    faces += std::popcount(mFaceMasks[band][face][x * Dims::SIZE + z] & layerBits);
+    }
+    return faces;
+}
+
+template<typename Dims>
+bool ChunkMesher<Dims>::regionHasSection(int region, int section)
+{
+    const glm::ivec3 position = Dims::sectionPosition(section);
+    switch (region)
+    {
+    case FRONT: return position.z == 0;
+    case BACK: return position.z == Dims::SECTIONSXZ - 1;
+    case RIGHT: return position.x == Dims::SECTIONSXZ - 1;
+    case LEFT: return position.x == 0;
+    default: return true;
+    }
+}
+
+template<typename Dims>
+void ChunkMesher<Dims>::buildFaceMasks(int band)
+{
+    const PaddedChunk<Dims>& input = mInput[band];
+    auto& faceMasks = mFaceMasks[band];
+
+    if (input.activeSections == 0)
+    {
+        for (auto& masks : faceMasks)
+            masks.fill(0);
+        return;
+    }
+
+    // EMPTY and UNIFORM sections come straight from the section bits, only MIXED ones are read
+    for (int x = -1; x <= Dims::SIZE; x++)
+        for (int z = -1; z <= Dims::SIZE; z++)
+        {
+            const bool borderX = x < 0 || x >= Dims::SIZE;
+            const bool borderZ = z < 0 || z >= Dims::SIZE;
+            if (borderX && borderZ) continue; // corners are never a face neighbour
+
+            const int source = PaddedChunk<Dims>::sectionColumn(x, z);
+            ColumnMask rendered = input.uniformRendered[source];
+            ColumnMask opaque = input.uniformOpaque[source];
+            const ColumnMask mixed = ~input.uniformBits[source];
+            for (int section = 0; section < BANDSECTIONS; section++)
+            {
+                if (!(mixed & getSectionBits(section))) continue;
+
+                for (int y = section * SECTIONSIZE; y < (section + 1) * SECTIONSIZE; y++)
+                {
+                    const ColumnMask flags = getBlockFlags(input.get(x, y, z));
+                    rendered |= (flags & BLOCK_RENDERED) << y;
+                    opaque |= (flags >> 1 & 1) << y;
+                }
+            }
+            mRendered[columnIndex<Dims>(x, z)] = rendered;
+            mOpaque[columnIndex<Dims>(x, z)] = opaque;
+        }
+
+    // a face is visible where the block is drawn and its neighbour is not opaque,
+    // the padding supplies the neighbouring chunks' and bands' blocks (or air)
+    for (int x = 0; x < Dims::SIZE; x++)
+        for (int z = 0; z < Dims::SIZE; z++)
+        {
+            const ColumnMask column = mRendered[columnIndex<Dims>(x, z)];
+            const ColumnMask opaque = mOpaque[columnIndex<Dims>(x, z)];
+            const ColumnMask below = isBlockOpaque(input.get(x, -1, z));
+            const ColumnMask above = isBlockOpaque(input.get(x, BANDHEIGHT, z));
+            const int i = x * Dims::SIZE + z;
+
+            faceMasks[FRONT][i] = column & ~mOpaque[columnIndex<Dims>(x, z - 1)];
+            faceMasks[BACK][i] = column & ~mOpaque[columnIndex<Dims>(x, z + 1)];
+            faceMasks[LEFT][i] = column & ~mOpaque[columnIndex<Dims>(x - 1, z)];
+            faceMasks[RIGHT][i] = column & ~mOpaque[columnIndex<Dims>(x + 1, z)];
+            faceMasks[TOP][i] = column & ~((opaque << 1) | below);
+            faceMasks[BOTTOM][i] = column & ~((opaque >> 1) | (above << (BANDHEIGHT - 1)));
+        }
+}
+
+template<typename Dims>
+void ChunkMesher<Dims>::buildPerFace(BLOCKFACE face, int firstSlice, int lastSlice)
+{
+    const FaceAxes& axes = FACEAXES[face];
+
+    for (int x = mMin.x; x < mMax.x; x++)
+        for (int z = mMin.z; z < mMax.z; z++)
+        {
+            if (!columnInSlices(axes, x, z, firstSlice, lastSlice)) continue;
+
+            ColumnMask visible = mFaceMasks[mBand][face][x * Dims::SIZE + z] & mLayerBits;
+            while (visible)
+            {
+                const int y = std::countr_zero(visible);
+                visible &= visible - 1;
+
+                glm::ivec3 pos(x, y, z);
+                emitQuad(face, pos[axes.normal], pos[axes.u], pos[axes.v], 1, 1, getBlockTile(mBandInput->get(x, y, z), face));
+                mStats.faceCount++;
+            }
+        }
+}
+
+template<typename Dims>
+void ChunkMesher<Dims>::buildGreedy(BLOCKFACE face, int firstSlice, int lastSlice)
+{
+    const FaceAxes& axes = FACEAXES[face];
+    const int uSize = AXISSIZE[axes.u];
+    // faces only merge within the box being meshed
+    const int uBegin = mMin[axes.u], uEnd = mMax[axes.u];
+    const int vBegin = mMin[axes.v], vEnd = mMax[axes.v];
+
+    for (int slice = firstSlice; slice < lastSlice; slice++)
+    {
+        // horizontal slices of a section that cannot show faces hold none
+        if (axes.normal == 1 && !(mBandInput->activeSections & (1u << (slice / SECTIONSIZE)))) continue;
+
+        // collect the visible faces of this slice, keyed by texture
+        for (int v = vBegin; v < vEnd; v++)
+            for (int u = uBegin; u < uEnd; u++)
+            {
+                glm::ivec3 pos;
+                pos[axes.normal] = slice;
+                pos[axes.u] = u;
+                pos[axes.v] = v;
+
+                uint8_t& cell = mMask[v * uSize + u];
+                cell = 0;
+
+                if (!((mFaceMasks[mBand][face][pos.x * Dims::SIZE + pos.z] >> pos.y) & 1)) continue;
+
+                cell = getBlockTile(mBandInput->get(pos.x, pos.y, pos.z), face) + 1;
+                mStats.faceCount++;
+            }
+
+        // grow each unvisited face along u, then along v while whole rows match
+        for (int v = vBegin; v < vEnd; v++)
+            for (int u = uBegin; u < uEnd;)
+            {
+                const uint8_t cell = mMask[v * uSize + u];
+                if (cell == 0)
+                {
+                    u++;
+                    continue;
+                }
+
+                int width = 1;
+                while (u + width < uEnd && mMask[v * uSize + u + width] == cell)
+                    width++;
+
+                int height = 1;
+                for (; v + height < vEnd; height++)
+                {
+                    bool rowMatches = true;
+                    for (int k = 0; k < width && rowMatches; k++)
+                        rowMatches = mMask[(v + height) * uSize + u + k] == cell;
+                    if (!rowMatches) break;
+                }
+
+                for (int dv = 0; dv < height; dv++)
+                    for (int k = 0; k < width; k++)
+                        mMask[(v + dv) * uSize + u + k] = 0;
+
+                emitQuad(face, slice, u, v, width, height, cell - 1);
+                u += width;
+            }
+    }
+}
+
+template<typename Dims>
+void ChunkMesher<Dims>::emitQuad(BLOCKFACE face, int slice, int u, int v, int width, int height, uint8_t texture)
+{
+    const FaceAxes& axes = FACEAXES[face];
+    const int corners[4][2] = { { u, v }, { u + width, v }, { u + width, v + height }, { u, v + height } };
+
+    ChunkVertex* out = mOut + mStats.quadCount * 4;
+    for (const auto& corner : corners)
+    {
+        glm::ivec3 pos;
+        pos[axes.normal] = slice + axes.offset;
+        pos[axes.u] = corner[0];
+        pos[axes.v] = corner[1];
+        pos.y += mBand * BANDHEIGHT;
+
+        *out++ = ChunkVertex::pack(pos, face, texture);
+    }
+    mStats.quadCount++;
+}
+
+
+template struct PaddedChunk<ChunkDimensions<16, 64>>;
+template struct PaddedChunk<ChunkDimensions<16, 256>>;
+template struct PaddedChunk<ChunkDimensions<32, 64>>;
+template struct PaddedChunk<ChunkDimensions<32, 384>>;
+template class ChunkMesher<ChunkDimensions<16, 64>>;
+template class ChunkMesher<ChunkDimensions<16, 256>>;
+template class ChunkMesher<ChunkDimensions<32, 64>>;
+template class ChunkMesher<ChunkDimensions<32, 384>>;
+template struct MeshScratch<ChunkDimensions<16, 64>>;
+template struct MeshScratch<ChunkDimensions<16, 256>>;
+template struct MeshScratch<ChunkDimensions<32, 64>>;
+template struct MeshScratch<ChunkDimensions<32, 384>>;
\ No newline at end of file
@@ -0,0 +1,182 @@
+#pragma once
+#include <vector>
+#include <array>
+#include <algorithm>
+#include "World.h"
+#include "structs.h"
+
+// Meshing works on bands of BANDHEIGHT blocks so a column of a band fits one mask,
+// bands without any section that can show a face are skipped without being read
+constexpr int BANDHEIGHT = 64;
+constexpr int BANDSECTIONS = BANDHEIGHT / SECTIONSIZE;
+template<typename Dims>
+constexpr int BANDCOUNT = Dims::HEIGHT / BANDHEIGHT;
+
+// one bit per block of an (x,z) column of a band, bit y = block at height y of the band
+typedef uint64_t ColumnMask;
+static_assert(BANDHEIGHT == 64, "column masks hold exactly one band column");
+
+// the bits of a column mask covering section i of the band
+inline ColumnMask getSectionBits(int section)
+{
+	return 0xFFFFull << (section * SECTIONSIZE);
+}
+
+// Meshing input for one band: the band's voxels surrounded by a one-block border
+// copied from the neighbouring chunks and the bands above and below, or air where
+// there is nothing, so the mesher never needs a bounds check.
+template<typename Dims>
+struct PaddedChunk
+{
+	static_assert(Dims::HEIGHT % BANDHEIGHT == 0, "chunks must split into whole bands");
+
+	static constexpr int SIZE = Dims::SIZE + 2;
+	static constexpr int HEIGHT = BANDHEIGHT + 2;
+	// section columns of the band, plus a ring of the neighbours' border ones
+	static constexpr int COLUMNS = Dims::SECTIONSXZ + 2;
+
+	std::array<uint8_t, SIZE * HEIGHT * SIZE> voxels;
+	// bit per section layer of the band that may have visible faces, 0 = band skipped and voxels stale
+	uint32_t activeSections = 0;
+	// per section column, the column bits whose section is EMPTY or UNIFORM and which of
+	// those are drawn and opaque, so column masks only read the voxels of MIXED sections
+	std::array<ColumnMask, COLUMNS * COLUMNS> uniformBits;
+	std::array<ColumnMask, COLUMNS * COLUMNS> uniformRendered;
+	std::array<ColumnMask, COLUMNS * COLUMNS> uniformOpaque;
+
+	// band-local coordinates, -1 and Dims::SIZE/BANDHEIGHT address the border
+	static int index(int x, int y, int z)
+	{
+		return ((x + 1) * HEIGHT + (y + 1)) * SIZE + (z + 1);
+	}
+	uint8_t get(int x, int y, int z) const
+	{
+		return voxels[index(x, y, z)];
+	}
+	// section column holding block column (x, z), border columns included
+	static int sectionColumn(int x, int z)
+	{
+		return (x + SECTIONSIZE) / SECTIONSIZE * COLUMNS + (z + SECTIONSIZE) / SECTIONSIZE;
+	}
+
+	// copies one band of data and its border, neighbours are indexed by BLOCKFACE and
+	// may be nullptr. Returns the number of voxel bytes copied
+	uint32_t fill(const BasicChunkData<Dims>& data, const std::array<const BasicChunkData<Dims>*, BORDERMESHES>& neighbours, int band);
+private:
+	void setUniformBits(int column, int layer, uint8_t block);
+	uint32_t copySection(const ChunkSection& section, int sectionX, int layer, int sectionZ);
+	uint32_t copyBorder(BLOCKFACE side, const BasicChunkData<Dims>* neighbour, int band);
+	uint32_t copyLayer(const BasicChunkData<Dims>& data, int y, int paddedY);
+};
+
+struct MeshStats
+{
+	uint32_t faceCount = 0; // visible block faces, i.e. what the per-face mesher emits
+	uint32_t quadCount = 0; // quads actually emitted
+	uint32_t allocations = 0; // heap allocations made while meshing
+	uint32_t bytesCopied = 0; // voxel and vertex bytes copied on the way to the GPU
+
+	uint32_t vertexCount() const { return quadCount * 4; }
+	uint32_t indexCount() const { return quadCount * 6; }
+	uint32_t perFaceVertexCount() const { return faceCount * 4; }
+	uint32_t perFaceIndexCount() const { return faceCount * 6; }
+	uint32_t vertexBytes() const { return vertexCount() * sizeof(ChunkVertex); }
+
+	MeshStats& operator+=(const MeshStats& other)
+	{
+		faceCount += other.faceCount;
+		quadCount += other.quadCount;
+		allocations += other.allocations;
+		bytesCopied += other.bytesCopied;
+		return *this;
+	}
+};
+
+template<typename Dims>
+class ChunkMesher
+{
+public:
+	static constexpr uint32_t ALLBANDS = (1u << BANDCOUNT<Dims>) - 1;
+
+	// bands as filled by PaddedChunk::fill, one per band of the chunk
+	ChunkMesher(const std::array<PaddedChunk<Dims>, BANDCOUNT<Dims>>& input);
+
+	ChunkMesher(const ChunkMesher&) = delete;
+	ChunkMesher& operator=(const ChunkMesher&) = delete;
+
+	// reads the bands given by bit, call whenever they have been filled again
+	void prepare(uint32_t bands = ALLBANDS);
+	// region is INTERIORMESH or the BLOCKFACE of one horizontal border. Quads are
+	// written to out as four vertices each and drawn with the engine's shared quad
+	// index buffer; out must hold four vertices per face in the region.
+	MeshStats buildMesh(MESHINGMODE mode, int region, ChunkVertex* out);
+	// the same for the faces of one section only, greedy quads do not grow past it, so
+	// a section's quads can be rebuilt on their own after an edit
+	MeshStats buildMesh(MESHINGMODE mode, int region, int section, ChunkVertex* out);
+	// visible faces in region, i.e. the exact quad count of a PERFACE mesh
+	uint32_t countFaces(int region) const;
+	uint32_t countFaces(int region, int section) const;
+	// whether section holds faces of region, the borders only have those along them
+	static bool regionHasSection(int region, int section);
+private:
+	static constexpr int AXISSIZE[3] = { Dims::SIZE, BANDHEIGHT, Dims::SIZE };
+
+	static bool getRegionSlices(BLOCKFACE face, int region, int& firstSlice, int& lastSlice);
+	void buildFaceMasks(int band);
+	// emits the faces of region in the band within mMin and mMax
+	void buildBand(MESHINGMODE mode, int region, int band);
+	void buildPerFace(BLOCKFACE face, int firstSlice, int lastSlice);
+	void buildGreedy(BLOCKFACE face, int firstSlice, int lastSlice);
+	void emitQuad(BLOCKFACE face, int slice, int u, int v, int width, int height, uint8_t texture);
+private:
+	const std::array<PaddedChunk<Dims>, BANDCOUNT<Dims>>& mInput;
+	ChunkVertex* mOut = nullptr;
+	MeshStats mStats;
+
+	// band being emitted, and the box of it being meshed in band coordinates, mMax
+	// exclusive; mLayerBits are the column bits from mMin.y to mMax.y
+	int mBand = 0;
+	const PaddedChunk<Dims>* mBandInput = nullptr;
+	glm::ivec3 mMin{ 0 };
+	glm::ivec3 mMax{ 0 };
+	ColumnMask mLayerBits = ~0ull;
+
+	// drawn and opaque columns of the band being built, including the neighbours' border columns
+	std::array<ColumnMask, PaddedChunk<Dims>::SIZE * PaddedChunk<Dims>::SIZE> mRendered;
+	std::array<ColumnMask, PaddedChunk<Dims>::SIZE * PaddedChunk<Dims>::SIZE> mOpaque;
+	// visible faces per band and direction, indexed x * Dims::SIZE + z
+	std::array<std::array<std::array<ColumnMask, Dims::SIZE * Dims::SIZE>, 6>, BANDCOUNT<Dims>> mFaceMasks;
+
+	// one slice of texture indices for the greedy pass, 0 = no face
+	std::array<uint8_t, Dims::SIZE * std::max<int>(Dims::SIZE, BANDHEIGHT)> mMask;
+};
+
+// Per-thread meshing memory. It is allocated for the worst-case chunk on first use
+// and reused for every mesh built on that thread afterwards, so steady-state meshing
+// does not touch the heap. Big chunk shapes need too much of it for the stack.
+template<typename Dims>
+struct MeshScratch
+{
+	std::array<PaddedChunk<Dims>, BANDCOUNT<Dims>> bands;
+	ChunkMesher<Dims> mesher{ bands };
+	std::vector<ChunkVertex> vertices;
+
+	static MeshScratch& get();
+	// allocations made since the last call, for MeshStats
+	uint32_t takeAllocations();
+private:
+	uint32_t mAllocations = 0;
+};
+
+extern template struct PaddedChunk<ChunkDimensions<16, 64>>;
+extern template struct PaddedChunk<ChunkDimensions<16, 256>>;
+extern template struct PaddedChunk<ChunkDimensions<32, 64>>;
+extern template struct PaddedChunk<ChunkDimensions<32, 384>>;
+extern template class ChunkMesher<ChunkDimensions<16, 64>>;
+extern template class ChunkMesher<ChunkDimensions<16, 256>>;
+extern template class ChunkMesher<ChunkDimensions<32, 64>>;
+extern template class ChunkMesher<ChunkDimensions<32, 384>>;
+extern template struct MeshScratch<ChunkDimensions<16, 64>>;
+extern template struct MeshScratch<ChunkDimensions<16, 256>>;
+extern template struct MeshScratch<ChunkDimensions<32, 64>>;
+extern template struct MeshScratch<ChunkDimensions<32, 384>>;
\ No newline at end of file
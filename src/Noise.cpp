@@ -0,0 +1,120 @@
+#include "Noise.h"
+#include <atomic>
+#include <cmath>
+#if NOISE_X86 && defined(_MSC_VER)
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+// scalar lanes for NoiseKernels.h, also the reference the SIMD paths must match bit for bit
+struct ScalarLanes
+{
+	using Float = float;
+	using Int = uint32_t;
+	static constexpr int WIDTH = 1;
+
+	static Int laneOffsets() { return 0; }
+	static void store(float* out, Float value) { *out = value; }
+};
+
+static float floorv(float value) { return std::floor(value); }
+static float absv(float value) { return std::fabs(value); }
+static float maxv(float a, float b) { return a > b ? a : b; }
+static bool greater(float a, float b) { return a > b; }
+static uint32_t toInt(float value) { return static_cast<uint32_t>(static_cast<int32_t>(value)); }
+static float toFloat(uint32_t value) { return static_cast<float>(static_cast<int32_t>(value)); }
+static bool isZero(uint32_t value) { return value == 0; }
+static float blend(bool mask, float a, float b) { return mask ? a : b; }
+
+#include "NoiseKernels.h"
+
+#if NOISE_X86
+void generateNoiseSSE4(const NoiseSettings& settings, int dimensions, const int origin[3], const int size[3], float* out);
+void generateNoiseAVX2(const NoiseSettings& settings, int dimensions, const int origin[3], const int size[3], float* out);
+#endif
+
+static std::atomic<SIMDLEVEL> sNoiseSimdLevel{ getSupportedSimdLevel() };
+
+static void generateNoise(const NoiseSettings& settings, int dimensions, const int origin[3], const int size[3], float* out)
+{
+	switch (getNoiseSimdLevel())
+	{
+#if NOISE_X86
+	case SIMD_AVX2:
+		return generateNoiseAVX2(settings, dimensions, origin, size, out);
+	case SIMD_SSE4:
+		return generateNoiseSSE4(settings, dimensions, origin, size, out);
+#endif
+	default:
+		return dimensions == 2 ? fillNoise<ScalarLanes, 2>(settings, origin, size, out) : fillNoise<ScalarLanes, 3>(settings, origin, size, out);
+	}
+}
+
+void generateNoise2D(const NoiseSettings& settings, glm::ivec2 origin, glm::ivec2 size, float* out)
+{
+	// the grid's second axis is the world's z, kernels run their lanes along z
+	const int origin3[3] = { origin.x, 0, origin.y };
+	const int size3[3] = { size.x, 1, size.y };
+	generateNoise(settings, 2, origin3, size3, out);
+}
+
+void generateNoise3D(const NoiseSettings& settings, glm::ivec3 origin, glm::ivec3 size, float* out)
+{
+	const int origin3[3] = { origin.x, origin.y, origin.z };
+	const int size3[3] = { size.x, size.y, size.z };
+	generateNoise(settings, 3, origin3, size3, out);
+}
+
+SIMDLEVEL getSupportedSimdLevel()
+{
+	static const SIMDLEVEL level = []
+	{
+#if NOISE_X86 && defined(_MSC_VER)
+		int info[4];
+		__cpuid(info, 0);
+		const int maxLeaf = info[0];
+		__cpuid(info, 1);
+		const bool sse4 = info[2] & (1 << 19);
+		// AVX needs the OS to save the upper register halves too
+		const bool osAvx = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && (_xgetbv(0) & 6) == 6;
+		bool avx2 = false;
+		if (maxLeaf >= 7)
+		{
+			__cpuidex(info, 7, 0);
+			avx2 = osAvx && (info[1] & (1 << 5));
+		}
+#elif NOISE_X86
+		__builtin_cpu_init();
+		const bool sse4 = __builtin_cpu_supports("sse4.1");
+		const bool avx2 = __builtin_cpu_supports("avx2");
+#else
+		const bool sse4 = false;
+		const bool avx2 = false;
+#endif
+		return avx2 ? SIMD_AVX2 : sse4 ? SIMD_SSE4 : SIMD_SCALAR;
+	}();
+	return level;
+}
+
+SIMDLEVEL getNoiseSimdLevel()
+{
+	return sNoiseSimdLevel.load(std::memory_order_relaxed);
+}
+
+void setNoiseSimdLevel(SIMDLEVEL level)
+{
+	sNoiseSimdLevel.store(level < getSupportedSimdLevel() ? level : getSupportedSimdLevel(), std::memory_order_relaxed);
+}
+
+const char* getSimdLevelName(SIMDLEVEL level)
+{
+	switch (level)
+	{
+	case SIMD_AVX2:
+		return "avx2";
+	case SIMD_SSE4:
+		return "sse4";
+	default:
+		return "scalar";
+	}
+}
\ No newline at end of file
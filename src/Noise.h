@@ -0,0 +1,55 @@
+#pragma once
+#include <cstdint>
+#include <glm/glm.hpp>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define NOISE_X86 1
+#else
+#define NOISE_X86 0
+#endif
+
+constexpr int NOISE_MAX_OCTAVES = 16;
+
+enum NOISETYPE {
+	PERLIN, // gradient noise on the cube lattice
+	SIMPLEX // gradient noise on the simplex lattice, fewer corners and no axis artefacts
+};
+enum FRACTALTYPE {
+	FRACTAL_NONE,
+	FRACTAL_FBM,   // octaves summed with falling amplitude
+	FRACTAL_RIDGED // octaves folded into sharp crests, for mountain ranges
+};
+// instruction sets the noise kernels are built for, each a superset of the one before
+enum SIMDLEVEL {
+	SIMD_SCALAR,
+	SIMD_SSE4,
+	SIMD_AVX2
+};
+
+struct NoiseSettings
+{
+	NOISETYPE type = SIMPLEX;
+	FRACTALTYPE fractal = FRACTAL_NONE;
+	uint32_t seed = 0;
+	// of the first octave, in cycles per block
+	float frequency = 0.01f;
+	int octaves = 4; // up to NOISE_MAX_OCTAVES, 1 without a fractal
+	float lacunarity = 2.0f; // frequency factor from one octave to the next
+	float gain = 0.5f;       // amplitude factor from one octave to the next
+};
+
+// Gradient noise over whole grids of block positions, one sample per block from origin
+// on, in roughly [-1, 1]. Grids are stored x outermost and z innermost like the
+// chunk's own arrays: out[x * size.y + z] in 2D (where y is the world's z axis) and
+// out[(x * size.y + y) * size.z + z] in 3D. Every SIMDLEVEL computes bitwise the same
+// values, so terrain does not depend on the machine that generated it. Thread-safe.
+void generateNoise2D(const NoiseSettings& settings, glm::ivec2 origin, glm::ivec2 size, float* out);
+void generateNoise3D(const NoiseSettings& settings, glm::ivec3 origin, glm::ivec3 size, float* out);
+
+// best level this CPU and OS support
+SIMDLEVEL getSupportedSimdLevel();
+// level the generate functions use, the supported one unless lowered
+SIMDLEVEL getNoiseSimdLevel();
+// clamped to the supported level, for benchmarks and comparing the paths
+void setNoiseSimdLevel(SIMDLEVEL level);
+const char* getSimdLevelName(SIMDLEVEL level);
\ No newline at end of file
@@ -0,0 +1,74 @@
+#include "Noise.h"
+#if NOISE_X86
+#include <immintrin.h>
+
+// everything below may use AVX2, the dispatch in Noise.cpp only calls it where supported
+#if defined(__GNUC__)
+#pragma GCC target("avx2")
+#endif
+
+struct AvxFloat
+{
+	__m256 v;
+	AvxFloat() = default;
+	AvxFloat(__m256 value) : v(value) {}
+	AvxFloat(float value) : v(_mm256_set1_ps(value)) {}
+};
+
+struct AvxInt
+{
+	__m256i v;
+	AvxInt() = default;
+	AvxInt(__m256i value) : v(value) {}
+	AvxInt(uint32_t value) : v(_mm256_set1_epi32(static_cast<int>(value))) {}
+};
+
+struct AvxMask
+{
+	__m256 v;
+};
+
+static AvxFloat operator+(AvxFloat a, AvxFloat b) { return _mm256_add_ps(a.v, b.v); }
+static AvxFloat operator-(AvxFloat a, AvxFloat b) { return _mm256_sub_ps(a.v, b.v); }
+static AvxFloat operator*(AvxFloat a, AvxFloat b) { return _mm256_mul_ps(a.v, b.v); }
+static AvxFloat operator-(AvxFloat a) { return _mm256_xor_ps(a.v, _mm256_set1_ps(-0.0f)); }
+
+static AvxInt operator+(AvxInt a, AvxInt b) { return _mm256_add_epi32(a.v, b.v); }
+static AvxInt operator*(AvxInt a, AvxInt b) { return _mm256_mullo_epi32(a.v, b.v); }
+static AvxInt operator^(AvxInt a, AvxInt b) { return _mm256_xor_si256(a.v, b.v); }
+static AvxInt operator&(AvxInt a, AvxInt b) { return _mm256_and_si256(a.v, b.v); }
+static AvxInt operator>>(AvxInt a, int shift) { return _mm256_srl_epi32(a.v, _mm_cvtsi32_si128(shift)); }
+
+static AvxMask operator&(AvxMask a, AvxMask b) { return { _mm256_and_ps(a.v, b.v) }; }
+static AvxMask operator|(AvxMask a, AvxMask b) { return { _mm256_or_ps(a.v, b.v) }; }
+static AvxMask operator!(AvxMask a) { return { _mm256_xor_ps(a.v, _mm256_castsi256_ps(_mm256_set1_epi32(-1))) }; }
+
+static AvxFloat floorv(AvxFloat value) { return _mm256_floor_ps(value.v); }
+static AvxFloat absv(AvxFloat value) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), value.v); }
+static AvxFloat maxv(AvxFloat a, AvxFloat b) { return _mm256_max_ps(a.v, b.v); }
+static AvxMask greater(AvxFloat a, AvxFloat b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ) }; }
+static AvxInt toInt(AvxFloat value) { return _mm256_cvttps_epi32(value.v); }
+static AvxFloat toFloat(AvxInt value) { return _mm256_cvtepi32_ps(value.v); }
+static AvxMask isZero(AvxInt value) { return { _mm256_castsi256_ps(_mm256_cmpeq_epi32(value.v, _mm256_setzero_si256())) }; }
+static AvxFloat blend(AvxMask mask, AvxFloat a, AvxFloat b) { return _mm256_blendv_ps(b.v, a.v, mask.v); }
+
+struct AvxLanes
+{
+	using Float = AvxFloat;
+	using Int = AvxInt;
+	static constexpr int WIDTH = 8;
+
+	static Int laneOffsets() { return _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7); }
+	static void store(float* out, Float value) { _mm256_storeu_ps(out, value.v); }
+};
+
+#include "NoiseKernels.h"
+
+void generateNoiseAVX2(const NoiseSettings& settings, int dimensions, const int origin[3], const int size[3], float* out)
+{
+	if (dimensions == 2)
+		fillNoise<AvxLanes, 2>(settings, origin, size, out);
+	else
+		fillNoise<AvxLanes, 3>(settings, origin, size, out);
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,291 @@
+#pragma once
+
+// The noise algorithms, written once over a set of SIMD lanes and compiled by
+// Noise.cpp (scalar), NoiseSSE4.cpp and NoiseAVX2.cpp for their instruction set.
+// Include it after the lane types, which provide:
+//   Lanes::Float, Lanes::Int (uint32 lanes), Lanes::WIDTH, Lanes::laneOffsets()
+//   with 0 to WIDTH - 1, and Lanes::store(float*, Float)
+//   Float: + - * and unary -, constructible from float
+//   Int: + * ^ & and >> (logical), constructible from uint32_t
+//   masks: & | !
+//   floorv, absv, maxv, greater(a, b), toInt (truncating), toFloat, isZero(Int)
+//   and blend(mask, a, b), which is mask ? a : b
+// Every path must round the same way, so the kernels only use operations IEEE
+// defines exactly and evaluate them in the same order; the files must not be built
+// with FMA contraction. Nothing here may include a header: the SIMD files compile
+// it for their target only.
+
+constexpr uint32_t NOISE_PRIME_X = 501125321u;
+constexpr uint32_t NOISE_PRIME_Y = 1136930381u;
+constexpr uint32_t NOISE_PRIME_Z = 1720413743u;
+constexpr uint32_t NOISE_HASH_MULTIPLIER = 0x27d4eb2du;
+// bring each noise into roughly [-1, 1]
+constexpr float NOISE_PERLIN2_SCALE = 0.66666667f;
+constexpr float NOISE_PERLIN3_SCALE = 0.96f;
+constexpr float NOISE_SIMPLEX2_SCALE = 45.0f;
+constexpr float NOISE_SIMPLEX3_SCALE = 32.0f;
+// simplex skew and unskew factors, (sqrt(n + 1) - 1) / n and (1 - 1 / sqrt(n + 1)) / n
+constexpr float NOISE_F2 = 0.36602540f;
+constexpr float NOISE_G2 = 0.21132487f;
+constexpr float NOISE_F3 = 1.0f / 3.0f;
+constexpr float NOISE_G3 = 1.0f / 6.0f;
+
+// per octave factors, computed once per grid in scalar code so every path uses the same ones
+struct OctaveTable
+{
+	int count;
+	float frequencies[NOISE_MAX_OCTAVES];
+	float amplitudes[NOISE_MAX_OCTAVES];
+	// brings the sum of all amplitudes back to 1
+	float scale;
+};
+
+static OctaveTable makeOctaveTable(const NoiseSettings& settings)
+{
+	OctaveTable table{};
+	table.count = settings.fractal == FRACTAL_NONE ? 1 : settings.octaves < 1 ? 1 : settings.octaves > NOISE_MAX_OCTAVES ? NOISE_MAX_OCTAVES : settings.octaves;
+
+	float frequency = 1.0f;
+	float amplitude = 1.0f;
+	float total = 0.0f;
+	for (int octave = 0; octave < table.count; octave++)
+	{
+		table.frequencies[octave] = frequency;
+		table.amplitudes[octave] = amplitude;
+		total += amplitude;
+		frequency *= settings.lacunarity;
+		amplitude *= settings.gain;
+	}
+	table.scale = 1.0f / total;
+	return table;
+}
+
+// low bits pick the gradient of a lattice point
+template<typename Int>
+static Int hashLattice(Int seed, Int x, Int y, Int z)
+{
+	Int hash = seed ^ (x * Int(NOISE_PRIME_X)) ^ (y * Int(NOISE_PRIME_Y)) ^ (z * Int(NOISE_PRIME_Z));
+	hash = hash * Int(NOISE_HASH_MULTIPLIER);
+	return hash ^ (hash >> 15);
+}
+
+// dot product with one of the 8 gradients (+-1, +-2) and (+-2, +-1)
+template<typename Float, typename Int>
+static Float gradient2(Int hash, Float x, Float y)
+{
+	const auto low = isZero(hash & Int(4));
+	Float u = blend(low, x, y);
+	Float v = blend(low, y, x);
+	u = blend(isZero(hash & Int(1)), u, -u);
+	v = blend(isZero(hash & Int(2)), v, -v);
+	return u + v + v;
+}
+
+// dot product with one of the 12 cube edge directions, 4 of them twice
+template<typename Float, typename Int>
+static Float gradient3(Int hash, Float x, Float y, Float z)
+{
+	Float u = blend(isZero(hash & Int(8)), x, y);
+	Float v = blend(isZero(hash & Int(12)), y, blend(isZero((hash & Int(13)) ^ Int(12)), x, z));
+	u = blend(isZero(hash & Int(1)), u, -u);
+	v = blend(isZero(hash & Int(2)), v, -v);
+	return u + v;
+}
+
+template<typename Float>
+static Float fade(Float t)
+{
+	return t * t * t * (t * (t * Float(6.0f) - Float(15.0f)) + Float(10.0f));
+}
+
+template<typename Float>
+static Float lerp(Float a, Float b, Float t)
+{
+	return a + t * (b - a);
+}
+
+template<typename Float, typename Int>
+static Float perlin2(Int seed, Float x, Float y)
+{
+	const Float fx = floorv(x), fy = floorv(y);
+	const Int x0 = toInt(fx), y0 = toInt(fy);
+	const Int x1 = x0 + Int(1), y1 = y0 + Int(1);
+	const Float dx0 = x - fx, dy0 = y - fy;
+	const Float dx1 = dx0 - Float(1.0f), dy1 = dy0 - Float(1.0f);
+	const Float u = fade(dx0), v = fade(dy0);
+
+	const Float n00 = gradient2(hashLattice(seed, x0, y0, Int(0)), dx0, dy0);
+	const Float n10 = gradient2(hashLattice(seed, x1, y0, Int(0)), dx1, dy0);
+	const Float n01 = gradient2(hashLattice(seed, x0, y1, Int(0)), dx0, dy1);
+	const Float n11 = gradient2(hashLattice(seed, x1, y1, Int(0)), dx1, dy1);
+	return lerp(lerp(n00, n10, u), lerp(n01, n11, u), v) * Float(NOISE_PERLIN2_SCALE);
+}
+
+template<typename Float, typename Int>
+static Float perlin3(Int seed, Float x, Float y, Float z)
+{
+	const Float fx = floorv(x), fy = floorv(y), fz = floorv(z);
+	const Int x0 = toInt(fx), y0 = toInt(fy), z0 = toInt(fz);
+	const Int x1 = x0 + Int(1), y1 = y0 + Int(1), z1 = z0 + Int(1);
+	const Float dx0 = x - fx, dy0 = y - fy, dz0 = z - fz;
+	const Float dx1 = dx0 - Float(1.0f), dy1 = dy0 - Float(1.0f), dz1 = dz0 - Float(1.0f);
+	const Float u = fade(dx0), v = fade(dy0), w = fade(dz0);
+
+	const Float n000 = gradient3(hashLattice(seed, x0, y0, z0), dx0, dy0, dz0);
+	const Float n100 = gradient3(hashLattice(seed, x1, y0, z0), dx1, dy0, dz0);
+	const Float n010 = gradient3(hashLattice(seed, x0, y1, z0), dx0, dy1, dz0);
+	const Float n110 = gradient3(hashLattice(seed, x1, y1, z0), dx1, dy1, dz0);
+	const Float n001 = gradient3(hashLattice(seed, x0, y0, z1), dx0, dy0, dz1);
+	const Float n101 = gradient3(hashLattice(seed, x1, y0, z1), dx1, dy0, dz1);
+	const Float n011 = gradient3(hashLattice(seed, x0, y1, z1), dx0, dy1, dz1);
+	const Float n111 = gradient3(hashLattice(seed, x1, y1, z1), dx1, dy1, dz1);
+
+	const Float nx00 = lerp(n000, n100, u), nx10 = lerp(n010, n110, u);
+	const Float nx01 = lerp(n001, n101, u), nx11 = lerp(n011, n111, u);
+	return lerp(lerp(nx00, nx10, v), lerp(nx01, nx11, v), w) * Float(NOISE_PERLIN3_SCALE);
+}
+
+// contribution of one simplex corner, radius the squared distance where it falls to 0
+template<typename Float>
+static Float simplexFalloff(Float radius, Float distanceSquared)
+{
+	Float t = maxv(radius - distanceSquared, Float(0.0f));
+	t = t * t;
+	return t * t;
+}
+
+template<typename Float, typename Int>
+static Float simplex2(Int seed, Float x, Float y)
+{
+	const Float skew = (x + y) * Float(NOISE_F2);
+	const Float fi = floorv(x + skew), fj = floorv(y + skew);
+	const Float unskew = (fi + fj) * Float(NOISE_G2);
+	const Float x0 = x - (fi - unskew), y0 = y - (fj - unskew);
+
+	// the lower or upper triangle of the skewed square
+	const auto lower = greater(x0, y0);
+	const Float i1 = blend(lower, Float(1.0f), Float(0.0f));
+	const Float j1 = blend(lower, Float(0.0f), Float(1.0f));
+
+	const Float x1 = x0 - i1 + Float(NOISE_G2), y1 = y0 - j1 + Float(NOISE_G2);
+	const Float x2 = x0 - Float(1.0f - 2.0f * NOISE_G2), y2 = y0 - Float(1.0f - 2.0f * NOISE_G2);
+
+	const Int i = toInt(fi), j = toInt(fj);
+	const Float n0 = simplexFalloff(Float(0.5f), x0 * x0 + y0 * y0) * gradient2(hashLattice(seed, i, j, Int(0)), x0, y0);
+	const Float n1 = simplexFalloff(Float(0.5f), x1 * x1 + y1 * y1) * gradient2(hashLattice(seed, i + toInt(i1), j + toInt(j1), Int(0)), x1, y1);
+	const Float n2 = simplexFalloff(Float(0.5f), x2 * x2 + y2 * y2) * gradient2(hashLattice(seed, i + Int(1), j + Int(1), Int(0)), x2, y2);
+	return (n0 + n1 + n2) * Float(NOISE_SIMPLEX2_SCALE);
+}
+
+template<typename Float, typename Int>
+static Float simplex3(Int seed, Float x, Float y, Float z)
+{
+	const Float skew = (x + y + z) * Float(NOISE_F3);
+	const Float fi = floorv(x + skew), fj = floorv(y + skew), fk = floorv(z + skew);
+	const Float unskew = (fi + fj + fk) * Float(NOISE_G3);
+	const Float x0 = x - (fi - unskew), y0 = y - (fj - unskew), z0 = z - (fk - unskew);
+
+	// the two middle corners of the tetrahedron, from the order of x0, y0 and z0
+	const auto xy = !greater(y0, x0), yz = !greater(z0, y0), xz = !greater(z0, x0);
+	const Float one(1.0f), zero(0.0f);
+	const Float i1 = blend(xy & xz, one, zero), j1 = blend((!xy) & yz, one, zero), k1 = blend((!xz) & (!yz), one, zero);
+	const Float i2 = blend(xy | xz, one, zero), j2 = blend((!xy) | yz, one, zero), k2 = blend(!(xz & yz), one, zero);
+
+	const Float x1 = x0 - i1 + Float(NOISE_G3), y1 = y0 - j1 + Float(NOISE_G3), z1 = z0 - k1 + Float(NOISE_G3);
+	const Float x2 = x0 - i2 + Float(2.0f * NOISE_G3), y2 = y0 - j2 + Float(2.0f * NOISE_G3), z2 = z0 - k2 + Float(2.0f * NOISE_G3);
+	const Float x3 = x0 - Float(1.0f - 3.0f * NOISE_G3), y3 = y0 - Float(1.0f - 3.0f * NOISE_G3), z3 = z0 - Float(1.0f - 3.0f * NOISE_G3);
+
+	const Int i = toInt(fi), j = toInt(fj), k = toInt(fk);
+	const Float n0 = simplexFalloff(Float(0.6f), x0 * x0 + y0 * y0 + z0 * z0) * gradient3(hashLattice(seed, i, j, k), x0, y0, z0);
+	const Float n1 = simplexFalloff(Float(0.6f), x1 * x1 + y1 * y1 + z1 * z1) * gradient3(hashLattice(seed, i + toInt(i1), j + toInt(j1), k + toInt(k1)), x1, y1, z1);
+	const Float n2 = simplexFalloff(Float(0.6f), x2 * x2 + y2 * y2 + z2 * z2) * gradient3(hashLattice(seed, i + toInt(i2), j + toInt(j2), k + toInt(k2)), x2, y2, z2);
+	const Float n3 = simplexFalloff(Float(0.6f), x3 * x3 + y3 * y3 + z3 * z3) * gradient3(hashLattice(seed, i + Int(1), j + Int(1), k + Int(1)), x3, y3, z3);
+	return (n0 + n1 + n2 + n3) * Float(NOISE_SIMPLEX3_SCALE);
+}
+
+// one sample of every octave at positions already scaled by the base frequency
+template<NOISETYPE TYPE, FRACTALTYPE FRACTAL, int DIMENSIONS, typename Float, typename Int>
+static Float sampleFractal(const OctaveTable& octaves, uint32_t seed, Float x, Float y, Float z)
+{
+	Float sum(0.0f);
+	for (int octave = 0; octave < octaves.count; octave++)
+	{
+		// every octave gets its own lattice so their features do not line up
+		const Int octaveSeed(seed + static_cast<uint32_t>(octave));
+		const Float frequency(octaves.frequencies[octave]);
+
+		Float n;
+		if constexpr (DIMENSIONS == 2)
+			n = TYPE == PERLIN ? perlin2(octaveSeed, x * frequency, z * frequency) : simplex2(octaveSeed, x * frequency, z * frequency);
+		else
+			n = TYPE == PERLIN ? perlin3(octaveSeed, x * frequency, y * frequency, z * frequency) : simplex3(octaveSeed, x * frequency, y * frequency, z * frequency);
+
+		if constexpr (FRACTAL == FRACTAL_RIDGED)
+		{
+			n = Float(1.0f) - absv(n);
+			n = n * n;
+		}
+		sum = sum + n * Float(octaves.amplitudes[octave]);
+	}
+
+	sum = sum * Float(octaves.scale);
+	// ridged octaves are in [0, 1]
+	if constexpr (FRACTAL == FRACTAL_RIDGED)
+		sum = sum + sum - Float(1.0f);
+	return sum;
+}
+
+// fills the grid WIDTH samples along z at a time, a partial last run goes through a buffer
+template<typename Lanes, NOISETYPE TYPE, FRACTALTYPE FRACTAL, int DIMENSIONS>
+static void fillNoiseGrid(const NoiseSettings& settings, const int origin[3], const int size[3], float* out)
+{
+	using Float = typename Lanes::Float;
+	using Int = typename Lanes::Int;
+
+	const OctaveTable octaves = makeOctaveTable(settings);
+	const Float frequency(settings.frequency);
+	const Int offsets = Lanes::laneOffsets();
+
+	for (int x = 0; x < size[0]; x++)
+		for (int y = 0; y < size[1]; y++)
+		{
+			const Float sampleX = toFloat(Int(static_cast<uint32_t>(origin[0] + x))) * frequency;
+			const Float sampleY = toFloat(Int(static_cast<uint32_t>(origin[1] + y))) * frequency;
+			float* row = out + (static_cast<size_t>(x) * size[1] + y) * size[2];
+
+			for (int z = 0; z < size[2]; z += Lanes::WIDTH)
+			{
+				const Float sampleZ = toFloat(Int(static_cast<uint32_t>(origin[2] + z)) + offsets) * frequency;
+				const Float value = sampleFractal<TYPE, FRACTAL, DIMENSIONS, Float, Int>(octaves, settings.seed, sampleX, sampleY, sampleZ);
+
+				if (z + Lanes::WIDTH <= size[2])
+					Lanes::store(row + z, value);
+				else
+				{
+					float partial[Lanes::WIDTH];
+					Lanes::store(partial, value);
+					for (int lane = 0; z + lane < size[2]; lane++)
+						row[z + lane] = partial[lane];
+				}
+			}
+		}
+}
+
+// picks the kernel for the settings. 2D grids are passed as x, 1, z
+template<typename Lanes, int DIMENSIONS>
+static void fillNoise(const NoiseSettings& settings, const int origin[3], const int size[3], float* out)
+{
+	const bool perlin = settings.type == PERLIN;
+	switch (settings.fractal)
+	{
+	case FRACTAL_FBM:
+		return perlin ? fillNoiseGrid<Lanes, PERLIN, FRACTAL_FBM, DIMENSIONS>(settings, origin, size, out)
+			: fillNoiseGrid<Lanes, SIMPLEX, FRACTAL_FBM, DIMENSIONS>(settings, origin, size, out);
+	case FRACTAL_RIDGED:
+		return perlin ? fillNoiseGrid<Lanes, PERLIN, FRACTAL_RIDGED, DIMENSIONS>(settings, origin, size, out)
+			: fillNoiseGrid<Lanes, SIMPLEX, FRACTAL_RIDGED, DIMENSIONS>(settings, origin, size, out);
+	default:
+		return perlin ? fillNoiseGrid<Lanes, PERLIN, FRACTAL_NONE, DIMENSIONS>(settings, origin, size, out)
+			: fillNoiseGrid<Lanes, SIMPLEX, FRACTAL_NONE, DIMENSIONS>(settings, origin, size, out);
+	}
+}
\ No newline at end of file
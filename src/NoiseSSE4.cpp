@@ -0,0 +1,74 @@
+#include "Noise.h"
+#if NOISE_X86
+#include <immintrin.h>
+
+// everything below may use SSE4.1, the dispatch in Noise.cpp only calls it where supported
+#if defined(__GNUC__)
+#pragma GCC target("sse4.1")
+#endif
+
+struct SseFloat
+{
+	__m128 v;
+	SseFloat() = default;
+	SseFloat(__m128 value) : v(value) {}
+	SseFloat(float value) : v(_mm_set1_ps(value)) {}
+};
+
+struct SseInt
+{
+	__m128i v;
+	SseInt() = default;
+	SseInt(__m128i value) : v(value) {}
+	SseInt(uint32_t value) : v(_mm_set1_epi32(static_cast<int>(value))) {}
+};
+
+struct SseMask
+{
+	__m128 v;
+};
+
+static SseFloat operator+(SseFloat a, SseFloat b) { return _mm_add_ps(a.v, b.v); }
+static SseFloat operator-(SseFloat a, SseFloat b) { return _mm_sub_ps(a.v, b.v); }
+static SseFloat operator*(SseFloat a, SseFloat b) { return _mm_mul_ps(a.v, b.v); }
+static SseFloat operator-(SseFloat a) { return _mm_xor_ps(a.v, _mm_set1_ps(-0.0f)); }
+
+static SseInt operator+(SseInt a, SseInt b) { return _mm_add_epi32(a.v, b.v); }
+static SseInt operator*(SseInt a, SseInt b) { return _mm_mullo_epi32(a.v, b.v); }
+static SseInt operator^(SseInt a, SseInt b) { return _mm_xor_si128(a.v, b.v); }
+static SseInt operator&(SseInt a, SseInt b) { return _mm_and_si128(a.v, b.v); }
+static SseInt operator>>(SseInt a, int shift) { return _mm_srl_epi32(a.v, _mm_cvtsi32_si128(shift)); }
+
+static SseMask operator&(SseMask a, SseMask b) { return { _mm_and_ps(a.v, b.v) }; }
+static SseMask operator|(SseMask a, SseMask b) { return { _mm_or_ps(a.v, b.v) }; }
+static SseMask operator!(SseMask a) { return { _mm_xor_ps(a.v, _mm_castsi128_ps(_mm_set1_epi32(-1))) }; }
+
+static SseFloat floorv(SseFloat value) { return _mm_floor_ps(value.v); }
+static SseFloat absv(SseFloat value) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), value.v); }
+static SseFloat maxv(SseFloat a, SseFloat b) { return _mm_max_ps(a.v, b.v); }
+static SseMask greater(SseFloat a, SseFloat b) { return { _mm_cmpgt_ps(a.v, b.v) }; }
+static SseInt toInt(SseFloat value) { return _mm_cvttps_epi32(value.v); }
+static SseFloat toFloat(SseInt value) { return _mm_cvtepi32_ps(value.v); }
+static SseMask isZero(SseInt value) { return { _mm_castsi128_ps(_mm_cmpeq_epi32(value.v, _mm_setzero_si128())) }; }
+static SseFloat blend(SseMask mask, SseFloat a, SseFloat b) { return _mm_blendv_ps(b.v, a.v, mask.v); }
+
+struct SseLanes
+{
+	using Float = SseFloat;
+	using Int = SseInt;
+	static constexpr int WIDTH = 4;
+
+	static Int laneOffsets() { return _mm_setr_epi32(0, 1, 2, 3); }
+	static void store(float* out, Float value) { _mm_storeu_ps(out, value.v); }
+};
+
+#include "NoiseKernels.h"
+
+void generateNoiseSSE4(const NoiseSettings& settings, int dimensions, const int origin[3], const int size[3], float* out)
+{
+	if (dimensions == 2)
+		fillNoise<SseLanes, 2>(settings, origin, size, out);
+	else
+		fillNoise<SseLanes, 3>(settings, origin, size, out);
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,613 @@
+#include "RegionFile.h"
+#include "ChunkCodec.h"
+#include <bit>
+#include <cstring>
+#include <iomanip>
+#include <stdexcept>
+#include <string>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static_assert(std::endian::native == std::endian::little, "region files are stored little endian");
+static_assert(std::has_single_bit(static_cast<unsigned>(REGIONSIZE)), "chunk positions split into region and local with a shift and a mask");
+
+// arithmetic shifts round negative chunk positions down too
+constexpr int REGIONSHIFT = std::countr_zero(static_cast<unsigned>(REGIONSIZE));
+
+struct RegionHeader
+{
+	uint32_t magic;
+	uint16_t version;
+	uint16_t chunkSize;
+	uint16_t chunkHeight;
+	uint16_t regionSize;
+};
+
+// in front of every chunk's encoding
+struct StoredChunkHeader
+{
+	int32_t x;
+	int32_t z;
+	uint64_t checksum; // of the encoding
+};
+
+// FNV-1a, only has to tell a torn or misplaced chunk from the one written
+static uint64_t checksumChunk(const uint8_t* bytes, size_t size)
+{
+	uint64_t hash = 0xcbf29ce484222325ull;
+	for (size_t i = 0; i < size; i++)
+		hash = (hash ^ bytes[i]) * 0x100000001b3ull;
+	return hash;
+}
+
+// fills in the header bytes starts with, the encoding follows it
+static void writeChunkHeader(glm::ivec2 position, std::vector<uint8_t>& bytes)
+{
+	const StoredChunkHeader header = { position.x, position.y, checksumChunk(bytes.data() + sizeof(header), bytes.size() - sizeof(header)) };
+	memcpy(bytes.data(), &header, sizeof(header));
+}
+
+// false unless bytes hold the chunk at position as it was written, then skips the header
+static bool checkChunkHeader(glm::ivec2 position, const uint8_t*& bytes, size_t& size)
+{
+	StoredChunkHeader header;
+	if (size < sizeof(header)) return false;
+	memcpy(&header, bytes, sizeof(header));
+	bytes += sizeof(header);
+	size -= sizeof(header);
+	return header.x == position.x && header.z == position.y && header.checksum == checksumChunk(bytes, size);
+}
+
+RegionFile::RegionFile(const std::filesystem::path& path, int chunkSize, int chunkHeight)
+{
+#ifdef _WIN32
+	HANDLE file = CreateFileW(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		throw std::runtime_error("Failed to open region file " + path.string() + "!");
+	mFile = file;
+#else
+	mFile = open(path.c_str(), O_RDWR | O_CREAT, 0644);
+	if (mFile < 0)
+		throw std::runtime_error("Failed to open region file " + path.string() + "!");
+#endif
+
+	try
+	{
+		readTable(path, chunkSize, chunkHeight);
+	}
+	catch (...)
+	{
+		closeFile();
+		throw;
+	}
+}
+
+RegionFile::~RegionFile()
+{
+	closeFile();
+}
+
+bool RegionFile::contains(glm::ivec2 local) const
+{
+	std::shared_lock<std::shared_mutex> lock(mMutex);
+	return mTable[tableIndex(local)].sector != 0;
+}
+
+bool RegionFile::read(glm::ivec2 local, const std::function<bool(const uint8_t*, size_t)>& decode) const
+{
+	std::shared_lock<std::shared_mutex> lock(mMutex);
+	const Location& entry = mTable[tableIndex(local)];
+	if (entry.sector == 0) return false;
+	return decode(mMapping + getDataOffset(entry), entry.size);
+}
+
+void RegionFile::write(glm::ivec2 local, const uint8_t* bytes, size_t size)
+{
+	uint32_t order;
+	const Location location = reserve(local, static_cast<uint32_t>(size), order);
+	writeAt(getDataOffset(location), bytes, size);
+	const Location previous = commit(local, location, order);
+	// a later write of the chunk may have committed first, the table gets whichever is current
+	Location current;
+	uint32_t version;
+	locate(local, current, version);
+	writeAt(getTableOffset(local), &current, sizeof(current));
+	release(previous);
+}
+
+size_t RegionFile::getFileSize() const
+{
+	std::shared_lock<std::shared_mutex> lock(mMutex);
+	return mUsedSectors.size() * REGION_SECTOR_SIZE;
+}
+
+void RegionFile::readTable(const std::filesystem::path& path, int chunkSize, int chunkHeight)
+{
+#ifdef _WIN32
+	LARGE_INTEGER fileSize;
+	GetFileSizeEx(mFile, &fileSize);
+	const uint64_t size = static_cast<uint64_t>(fileSize.QuadPart);
+#else
+	struct stat status;
+	fstat(mFile, &status);
+	const uint64_t size = static_cast<uint64_t>(status.st_size);
+#endif
+
+	const RegionHeader expected = { REGION_MAGIC, REGION_VERSION, static_cast<uint16_t>(chunkSize), static_cast<uint16_t>(chunkHeight), REGIONSIZE };
+	if (size == 0)
+	{
+		// a new region, the table starts out zeroed
+		resize(REGION_DATA_SECTOR);
+		writeAt(0, &expected, sizeof(expected));
+	}
+	else if (size % REGION_SECTOR_SIZE != 0 || size < REGION_DATA_SECTOR * REGION_SECTOR_SIZE)
+		throw std::runtime_error("Failed to open region file " + path.string() + ", it is truncated!");
+	else
+	{
+		mUsedSectors.assign(size / REGION_SECTOR_SIZE, false);
+		map();
+	}
+
+	RegionHeader header;
+	memcpy(&header, mMapping, sizeof(header));
+	if (memcmp(&header, &expected, sizeof(header)) != 0)
+		throw std::runtime_error("Failed to open region file " + path.string() + ", it is not a region of this version and chunk shape!");
+
+	memcpy(mTable.data(), mMapping + REGION_TABLE_SECTOR * REGION_SECTOR_SIZE, sizeof(mTable));
+	markSectors(0, REGION_DATA_SECTOR, true);
+	for (Location& entry : mTable)
+	{
+		// chunks pointing outside the file or into the table are dropped, and regenerated
+		const uint32_t sectors = getSectorCount(entry.size);
+		if (entry.sector < REGION_DATA_SECTOR || entry.sector + sectors > mUsedSectors.size())
+			entry = {};
+		else
+			markSectors(entry.sector, sectors, true);
+	}
+}
+
+void RegionFile::closeFile()
+{
+	unmap();
+#ifdef _WIN32
+	CloseHandle(mFile);
+#else
+	close(mFile);
+#endif
+}
+
+FileHandle RegionFile::getHandle() const
+{
+	return mFile;
+}
+
+void RegionFile::sync()
+{
+	// released after their table entries were written, which this sync puts on the disk
+	std::vector<Location> released;
+	{
+		std::unique_lock<std::shared_mutex> lock(mMutex);
+		released.swap(mReleased);
+	}
+
+#ifdef _WIN32
+	if (!FlushFileBuffers(mFile))
+		throw std::runtime_error("Failed to sync region file!");
+#else
+	if (fsync(mFile) != 0)
+		throw std::runtime_error("Failed to sync region file!");
+#endif
+
+	std::unique_lock<std::shared_mutex> lock(mMutex);
+	for (const Location& location : released)
+		markSectors(location.sector, getSectorCount(location.size), false);
+}
+
+bool RegionFile::locate(glm::ivec2 local, Location& location, uint32_t& version) const
+{
+	std::shared_lock<std::shared_mutex> lock(mMutex);
+	location = mTable[tableIndex(local)];
+	version = mVersions[tableIndex(local)];
+	return location.sector != 0;
+}
+
+bool RegionFile::isCurrent(glm::ivec2 local, uint32_t version) const
+{
+	std::shared_lock<std::shared_mutex> lock(mMutex);
+	return mVersions[tableIndex(local)] == version;
+}
+
+RegionFile::Location RegionFile::reserve(glm::ivec2 local, uint32_t size, uint32_t& order)
+{
+	std::unique_lock<std::shared_mutex> lock(mMutex);
+	order = ++mReserved[tableIndex(local)];
+	return { allocateSectors(getSectorCount(size)), size };
+}
+
+RegionFile::Location RegionFile::commit(glm::ivec2 local, const Location& location, uint32_t order)
+{
+	std::unique_lock<std::shared_mutex> lock(mMutex);
+	// wraps around, but never with that many writes of one chunk in flight
+	if (static_cast<int32_t>(order - mCommitted[tableIndex(local)]) <= 0) return location;
+	mCommitted[tableIndex(local)] = order;
+
+	const Location previous = mTable[tableIndex(local)];
+	mTable[tableIndex(local)] = location;
+	mVersions[tableIndex(local)]++;
+	return previous;
+}
+
+void RegionFile::release(const Location& location)
+{
+	if (location.sector == 0) return;
+	// a crash before the next sync may leave the table on the disk pointing here still
+	std::unique_lock<std::shared_mutex> lock(mMutex);
+	mReleased.push_back(location);
+}
+
+uint64_t RegionFile::getTableOffset(glm::ivec2 local)
+{
+	return REGION_TABLE_SECTOR * REGION_SECTOR_SIZE + tableIndex(local) * sizeof(Location);
+}
+
+uint64_t RegionFile::getDataOffset(const Location& location)
+{
+	return static_cast<uint64_t>(location.sector) * REGION_SECTOR_SIZE;
+}
+
+uint32_t RegionFile::getSectorCount(uint32_t size)
+{
+	return (size + REGION_SECTOR_SIZE - 1) / REGION_SECTOR_SIZE;
+}
+
+int RegionFile::tableIndex(glm::ivec2 local)
+{
+	return local.x * REGIONSIZE + local.y;
+}
+
+uint32_t RegionFile::allocateSectors(uint32_t count)
+{
+	// first fit, chunks are a sector or two so the gaps they leave are reused quickly
+	uint32_t run = 0;
+	for (uint32_t sector = REGION_DATA_SECTOR; sector < mUsedSectors.size(); sector++)
+	{
+		run = mUsedSectors[sector] ? 0 : run + 1;
+		if (run == count)
+		{
+			markSectors(sector + 1 - count, count, true);
+			return sector + 1 - count;
+		}
+	}
+
+	// the free run at the end, if any, grows into the new sectors
+	const uint32_t first = static_cast<uint32_t>(mUsedSectors.size()) - run;
+	const uint32_t needed = first + count;
+	resize((needed + REGION_GROWTH_SECTORS - 1) / REGION_GROWTH_SECTORS * REGION_GROWTH_SECTORS);
+	markSectors(first, count, true);
+	return first;
+}
+
+void RegionFile::markSectors(uint32_t first, uint32_t count, bool used)
+{
+	for (uint32_t sector = first; sector < first + count; sector++)
+		mUsedSectors[sector] = used;
+}
+
+void RegionFile::resize(uint32_t sectors)
+{
+	// the mapping has to go before the file changes size, readers are locked out meanwhile
+	unmap();
+	const uint64_t size = static_cast<uint64_t>(sectors) * REGION_SECTOR_SIZE;
+#ifdef _WIN32
+	LARGE_INTEGER end;
+	end.QuadPart = static_cast<LONGLONG>(size);
+	if (!SetFilePointerEx(mFile, end, nullptr, FILE_BEGIN) || !SetEndOfFile(mFile))
+		throw std::runtime_error("Failed to grow region file!");
+#else
+	if (ftruncate(mFile, static_cast<off_t>(size)) != 0)
+		throw std::runtime_error("Failed to grow region file!");
+#endif
+	mUsedSectors.resize(sectors, false);
+	map();
+}
+
+void RegionFile::writeAt(uint64_t offset, const void* bytes, size_t size)
+{
+	const char* data = static_cast<const char*>(bytes);
+	while (size > 0)
+	{
+#ifdef _WIN32
+		OVERLAPPED overlapped{};
+		overlapped.Offset = static_cast<DWORD>(offset);
+		overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+		DWORD written = 0;
+		if (!WriteFile(mFile, data, static_cast<DWORD>(size), &written, &overlapped))
+			throw std::runtime_error("Failed to write region file!");
+#else
+		const ssize_t written = pwrite(mFile, data, size, static_cast<off_t>(offset));
+		if (written <= 0)
+			throw std::runtime_error("Failed to write region file!");
+#endif
+		data += written;
+		offset += written;
+		size -= written;
+	}
+}
+
+void RegionFile::map()
+{
+	mMappedSize = mUsedSectors.size() * REGION_SECTOR_SIZE;
+#ifdef _WIN32
+	HANDLE mapping = CreateFileMappingW(mFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mapping == nullptr)
+		throw std::runtime_error("Failed to map region file!");
+	// the view keeps the mapping object alive
+	mMapping = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, mMappedSize));
+	CloseHandle(mapping);
+	if (mMapping == nullptr)
+		throw std::runtime_error("Failed to map region file!");
+#else
+	void* mapping = mmap(nullptr, mMappedSize, PROT_READ, MAP_SHARED, mFile, 0);
+	if (mapping == MAP_FAILED)
+		throw std::runtime_error("Failed to map region file!");
+	mMapping = static_cast<const uint8_t*>(mapping);
+#endif
+}
+
+void RegionFile::unmap()
+{
+	if (!mMapping) return;
+#ifdef _WIN32
+	UnmapViewOfFile(mMapping);
+#else
+	munmap(const_cast<uint8_t*>(mMapping), mMappedSize);
+#endif
+	mMapping = nullptr;
+	mMappedSize = 0;
+}
+
+RegionStorage::RegionStorage(std::filesystem::path directory, AsyncIO& io)
+	:mDirectory(std::move(directory)), mIO(io)
+{
+}
+
+// counts a task as running for waitIdle while it lives
+class ActiveTask
+{
+public:
+	ActiveTask(std::atomic<uint32_t>& active)
+		:mActive(active)
+	{
+		mActive.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	~ActiveTask()
+	{
+		mActive.fetch_sub(1, std::memory_order_release);
+		mActive.notify_all();
+	}
+
+	ActiveTask(const ActiveTask&) = delete;
+	ActiveTask& operator=(const ActiveTask&) = delete;
+private:
+	std::atomic<uint32_t>& mActive;
+};
+
+template<typename Dims>
+bool RegionStorage::loadChunk(glm::ivec2 position, BasicChunkData<Dims>& data)
+{
+	RegionFile* region = getRegion(position >> REGIONSHIFT, false, Dims::SIZE, Dims::HEIGHT);
+	if (!region) return false;
+
+	size_t size = 0;
+	bool corrupt = false;
+	const bool loaded = region->read(position & (REGIONSIZE - 1), [&](const uint8_t* bytes, size_t byteCount)
+	{
+		size = byteCount;
+		corrupt = !checkChunkHeader(position, bytes, byteCount);
+		return !corrupt && decodeChunk(bytes, byteCount, data);
+	});
+	if (corrupt)
+		mChunksCorrupt.fetch_add(1, std::memory_order_relaxed);
+	if (!loaded) return false;
+
+	mChunksLoaded.fetch_add(1, std::memory_order_relaxed);
+	mBytesLoaded.fetch_add(size, std::memory_order_relaxed);
+	return true;
+}
+
+template<typename Dims>
+void RegionStorage::saveChunk(glm::ivec2 position, const BasicChunkData<Dims>& data)
+{
+	thread_local std::vector<uint8_t> bytes;
+	bytes.assign(sizeof(StoredChunkHeader), 0);
+	encodeChunk(data, bytes);
+	writeChunkHeader(position, bytes);
+
+	getRegion(position >> REGIONSHIFT, true, Dims::SIZE, Dims::HEIGHT)->write(position & (REGIONSIZE - 1), bytes.data(), bytes.size());
+	mChunksSaved.fetch_add(1, std::memory_order_relaxed);
+	mBytesSaved.fetch_add(bytes.size(), std::memory_order_relaxed);
+}
+
+template<typename Dims>
+Task<bool> RegionStorage::readChunk(glm::ivec2 position, BasicChunkData<Dims>& data)
+{
+	ActiveTask active(mActive);
+	RegionFile* region = getRegion(position >> REGIONSHIFT, false, Dims::SIZE, Dims::HEIGHT);
+	if (!region) co_return false;
+
+	const glm::ivec2 local = position & (REGIONSIZE - 1);
+	std::vector<uint8_t> bytes;
+	while (true)
+	{
+		RegionFile::Location location;
+		uint32_t version;
+		if (!region->locate(local, location, version)) co_return false;
+
+		bytes.resize(location.size);
+		const int64_t read = co_await mIO.read(region->getHandle(), RegionFile::getDataOffset(location), bytes.data(), location.size);
+		if (read != location.size) co_return false;
+		// written again meanwhile, its old sectors may already hold another chunk
+		if (!region->isCurrent(local, version)) continue;
+
+		const uint8_t* encoding = bytes.data();
+		size_t size = bytes.size();
+		if (!checkChunkHeader(position, encoding, size))
+		{
+			mChunksCorrupt.fetch_add(1, std::memory_order_relaxed);
+			co_return false;
+		}
+		if (!decodeChunk(encoding, size, data)) co_return false;
+		mChunksLoaded.fetch_add(1, std::memory_order_relaxed);
+		mBytesLoaded.fetch_add(bytes.size(), std::memory_order_relaxed);
+		co_return true;
+	}
+}
+
+template<typename Dims>
+Task<void> RegionStorage::writeChunk(glm::ivec2 position, const BasicChunkData<Dims>& data)
+{
+	std::vector<uint8_t> bytes;
+	encodeChunk(data, bytes);
+	co_await writeEncoded<Dims>(position, std::move(bytes));
+}
+
+template<typename Dims>
+Task<void> RegionStorage::writeEncoded(glm::ivec2 position, std::vector<uint8_t> bytes)
+{
+	ActiveTask active(mActive);
+	bytes.insert(bytes.begin(), sizeof(StoredChunkHeader), 0);
+	writeChunkHeader(position, bytes);
+
+	RegionFile* region = getRegion(position >> REGIONSHIFT, true, Dims::SIZE, Dims::HEIGHT);
+	const glm::ivec2 local = position & (REGIONSIZE - 1);
+	uint32_t order;
+	const RegionFile::Location location = region->reserve(local, static_cast<uint32_t>(bytes.size()), order);
+	// awaited outside the conditions, GCC 12 destroys awaited temporaries in them too early
+	const int64_t written = co_await mIO.write(region->getHandle(), RegionFile::getDataOffset(location), bytes.data(), location.size);
+	if (written != location.size)
+	{
+		region->release(location);
+		throw std::runtime_error("Failed to write region file!");
+	}
+
+	// our own location if a write of the chunk that started later committed first
+	const RegionFile::Location previous = region->commit(local, location, order);
+	// another write of the chunk may commit meanwhile and its table write land first,
+	// whichever finishes last writes the entry that is current then
+	RegionFile::Location current;
+	uint32_t version;
+	do
+	{
+		region->locate(local, current, version);
+		const int64_t tableWritten = co_await mIO.write(region->getHandle(), RegionFile::getTableOffset(local), &current, sizeof(current));
+		if (tableWritten != sizeof(current))
+			throw std::runtime_error("Failed to write region file!");
+	} while (!region->isCurrent(local, version));
+	region->release(previous);
+
+	mChunksSaved.fetch_add(1, std::memory_order_relaxed);
+	mBytesSaved.fetch_add(bytes.size(), std::memory_order_relaxed);
+}
+
+void RegionStorage::waitIdle() const
+{
+	for (uint32_t active = mActive.load(std::memory_order_acquire); active != 0; active = mActive.load(std::memory_order_acquire))
+		mActive.wait(active, std::memory_order_acquire);
+}
+
+void RegionStorage::sync()
+{
+	// regions are never closed, so the pointers outlive the lock
+	std::vector<RegionFile*> regions;
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		for (const auto& [key, region] : mRegions)
+			if (region) regions.push_back(region.get());
+	}
+	for (RegionFile* region : regions)
+		region->sync();
+}
+
+const std::filesystem::path& RegionStorage::getDirectory() const
+{
+	return mDirectory;
+}
+
+RegionStorageStats RegionStorage::getStats() const
+{
+	RegionStorageStats stats;
+	stats.chunksLoaded = mChunksLoaded.load(std::memory_order_relaxed);
+	stats.chunksSaved = mChunksSaved.load(std::memory_order_relaxed);
+	stats.bytesLoaded = mBytesLoaded.load(std::memory_order_relaxed);
+	stats.bytesSaved = mBytesSaved.load(std::memory_order_relaxed);
+	stats.chunksCorrupt = mChunksCorrupt.load(std::memory_order_relaxed);
+	stats.io = mIO.getStats();
+
+	std::lock_guard<std::mutex> lock(mMutex);
+	for (const auto& [key, region] : mRegions)
+		if (region) stats.regionsOpen++;
+	return stats;
+}
+
+void RegionStorage::reportStats(std::ostream& out) const
+{
+	const RegionStorageStats stats = getStats();
+	out << "Region storage " << mDirectory.string() << ": " << stats.regionsOpen << " regions open, "
+		<< stats.chunksLoaded << " chunks loaded, " << stats.chunksSaved << " saved, " << stats.chunksCorrupt << " corrupt, " << std::fixed << std::setprecision(0)
+		<< (stats.chunksLoaded ? static_cast<double>(stats.bytesLoaded) / stats.chunksLoaded : 0.0) << " bytes per chunk loaded, "
+		<< (stats.chunksSaved ? static_cast<double>(stats.bytesSaved) / stats.chunksSaved : 0.0) << " per chunk saved, "
+		<< (mIO.getBackend() == IO_URING ? "io_uring " : "I/O threads ") << stats.io.requests << " requests in " << stats.io.submissions << " submissions" << std::endl;
+}
+
+RegionFile* RegionStorage::getRegion(glm::ivec2 region, bool create, int chunkSize, int chunkHeight)
+{
+	const uint64_t key = static_cast<uint64_t>(static_cast<uint32_t>(region.x)) << 32 | static_cast<uint32_t>(region.y);
+	const std::filesystem::path path = mDirectory / ("r." + std::to_string(region.x) + "." + std::to_string(region.y) + ".region");
+
+	std::lock_guard<std::mutex> lock(mMutex);
+	auto it = mRegions.find(key);
+	if (it == mRegions.end())
+	{
+		// a missing file is remembered, so loading a new world does not look for it every chunk
+		std::unique_ptr<RegionFile> file;
+		if (std::filesystem::exists(path))
+			file = std::make_unique<RegionFile>(path, chunkSize, chunkHeight);
+		it = mRegions.emplace(key, std::move(file)).first;
+	}
+	if (!it->second && create)
+	{
+		std::filesystem::create_directories(mDirectory);
+		it->second = std::make_unique<RegionFile>(path, chunkSize, chunkHeight);
+	}
+	return it->second.get();
+}
+
+template bool RegionStorage::loadChunk<ChunkDimensions<16, 64>>(glm::ivec2, BasicChunkData<ChunkDimensions<16, 64>>&);
+template bool RegionStorage::loadChunk<ChunkDimensions<16, 256>>(glm::ivec2, BasicChunkData<ChunkDimensions<16, 256>>&);
+template bool RegionStorage::loadChunk<ChunkDimensions<32, 64>>(glm::ivec2, BasicChunkData<ChunkDimensions<32, 64>>&);
+template bool RegionStorage::loadChunk<ChunkDimensions<32, 384>>(glm::ivec2, BasicChunkData<ChunkDimensions<32, 384>>&);
+template void RegionStorage::saveChunk<ChunkDimensions<16, 64>>(glm::ivec2, const BasicChunkData<ChunkDimensions<16, 64>>&);
+template void RegionStorage::saveChunk<ChunkDimensions<16, 256>>(glm::ivec2, const BasicChunkData<ChunkDimensions<16, 256>>&);
+template void RegionStorage::saveChunk<ChunkDimensions<32, 64>>(glm::ivec2, const BasicChunkData<ChunkDimensions<32, 64>>&);
+template void RegionStorage::saveChunk<ChunkDimensions<32, 384>>(glm::ivec2, const BasicChunkData<ChunkDimensions<32, 384>>&);
+template Task<bool> RegionStorage::readChunk<ChunkDimensions<16, 64>>(glm::ivec2, BasicChunkData<ChunkDimensions<16, 64>>&);
+template Task<bool> RegionStorage::readChunk<ChunkDimensions<16, 256>>(glm::ivec2, BasicChunkData<ChunkDimensions<16, 256>>&);
+template Task<bool> RegionStorage::readChunk<ChunkDimensions<32, 64>>(glm::ivec2, BasicChunkData<ChunkDimensions<32, 64>>&);
+template Task<bool> RegionStorage::readChunk<ChunkDimensions<32, 384>>(glm::ivec2, BasicChunkData<ChunkDimensions<32, 384>>&);
+template Task<void> RegionStorage::writeChunk<ChunkDimensions<16, 64>>(glm::ivec2, const BasicChunkData<ChunkDimensions<16, 64>>&);
+template Task<void> RegionStorage::writeChunk<ChunkDimensions<16, 256>>(glm::ivec2, const BasicChunkData<ChunkDimensions<16, 256>>&);
+template Task<void> RegionStorage::writeChunk<ChunkDimensions<32, 64>>(glm::ivec2, const BasicChunkData<ChunkDimensions<32, 64>>&);
+template Task<void> RegionStorage::writeChunk<ChunkDimensions<32, 384>>(glm::ivec2, const BasicChunkData<ChunkDimensions<32, 384>>&);
+template Task<void> RegionStorage::writeEncoded<ChunkDimensions<16, 64>>(glm::ivec2, std::vector<uint8_t>);
+template Task<void> RegionStorage::writeEncoded<ChunkDimensions<16, 256>>(glm::ivec2, std::vector<uint8_t>);
+template Task<void> RegionStorage::writeEncoded<ChunkDimensions<32, 64>>(glm::ivec2, std::vector<uint8_t>);
+template Task<void> RegionStorage::writeEncoded<ChunkDimensions<32, 384>>(glm::ivec2, std::vector<uint8_t>);
\ No newline at end of file
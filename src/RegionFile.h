@@ -0,0 +1,183 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+#include <glm/glm.hpp>
+#include "World.h"
+#include "AsyncIO.h"
+#include "Task.h"
+
+// chunks along x and z stored in one region file
+constexpr int REGIONSIZE = 32;
+constexpr int REGIONCHUNKS = REGIONSIZE * REGIONSIZE;
+// chunks are stored on whole sectors so rewriting one rarely has to move it
+constexpr uint32_t REGION_SECTOR_SIZE = 4096;
+// a header sector, then the offset table
+constexpr uint32_t REGION_TABLE_SECTOR = 1;
+constexpr uint32_t REGION_DATA_SECTOR = REGION_TABLE_SECTOR + (REGIONCHUNKS * 8 + REGION_SECTOR_SIZE - 1) / REGION_SECTOR_SIZE;
+// the file grows by this many sectors at a time, so it is remapped rarely
+constexpr uint32_t REGION_GROWTH_SECTORS = 64;
+constexpr uint32_t REGION_MAGIC = 0x4E474552; // "REGN"
+constexpr uint16_t REGION_VERSION = 2;
+
+// One file of REGIONSIZE * REGIONSIZE chunks: a header sector, an offset table with
+// the first sector and byte length of every chunk, then the chunks' encodings (see
+// ChunkCodec.h) on whole sectors. The file is mapped read-only, so reading a chunk
+// is a table lookup and a decode straight from the mapping. Writes go to sectors not
+// in use before the table is pointed at them, so a chunk interrupted mid-write keeps
+// its previous version, and the sectors a chunk moves off are only reused after the
+// next sync, once the table pointing away from them is on the disk. Thread-safe,
+// reads run in parallel and block only on writes.
+class RegionFile
+{
+public:
+	// opens or creates the file, throws if it holds chunks of other dimensions
+	RegionFile(const std::filesystem::path& path, int chunkSize, int chunkHeight);
+	~RegionFile();
+
+	RegionFile(const RegionFile&) = delete;
+	RegionFile& operator=(const RegionFile&) = delete;
+
+	// an offset table entry, as stored in the file
+	struct Location
+	{
+		uint32_t sector = 0; // 0 when the chunk is not stored
+		uint32_t size = 0;   // in bytes
+	};
+
+	// local is the chunk position inside the region, each coordinate in [0, REGIONSIZE)
+	bool contains(glm::ivec2 local) const;
+	// calls decode with the chunk's bytes, which stay mapped until it returns; false
+	// if the chunk is not stored, otherwise what decode returns
+	bool read(glm::ivec2 local, const std::function<bool(const uint8_t*, size_t)>& decode) const;
+	void write(glm::ivec2 local, const uint8_t* bytes, size_t size);
+	size_t getFileSize() const;
+	FileHandle getHandle() const;
+	// blocks until everything written to the file is on the disk, then frees the
+	// sectors released before it
+	void sync();
+
+	// The steps of write, for writing through an AsyncIO instead. Data goes to the
+	// reserved location first, then commit points the chunk at it and returns where
+	// it was, and once the table entry at getTableOffset has been written as well
+	// that previous location is released, to be reused after the next sync. Writes of the same chunk that overlap may
+	// finish in any order, so reserve hands out the order they started in and commit
+	// ignores a write that a later one has committed over, returning its own location.
+	// false if the chunk is not stored; version changes whenever the chunk moves
+	bool locate(glm::ivec2 local, Location& location, uint32_t& version) const;
+	bool isCurrent(glm::ivec2 local, uint32_t version) const;
+	Location reserve(glm::ivec2 local, uint32_t size, uint32_t& order);
+	Location commit(glm::ivec2 local, const Location& location, uint32_t order);
+	void release(const Location& location);
+	static uint64_t getTableOffset(glm::ivec2 local);
+	static uint64_t getDataOffset(const Location& location);
+private:
+	// checks the header and reads the offset table, or writes both to a new file
+	void readTable(const std::filesystem::path& path, int chunkSize, int chunkHeight);
+	void closeFile();
+	static uint32_t getSectorCount(uint32_t size);
+	static int tableIndex(glm::ivec2 local);
+	// first run of count free sectors, growing the file if there is none
+	uint32_t allocateSectors(uint32_t count);
+	void markSectors(uint32_t first, uint32_t count, bool used);
+	void resize(uint32_t sectors);
+	void writeAt(uint64_t offset, const void* bytes, size_t size);
+	void map();
+	void unmap();
+private:
+	mutable std::shared_mutex mMutex;
+#ifdef _WIN32
+	FileHandle mFile = nullptr;
+#else
+	FileHandle mFile = -1;
+#endif
+	const uint8_t* mMapping = nullptr;
+	size_t mMappedSize = 0;
+	std::array<Location, REGIONCHUNKS> mTable{};
+	std::array<uint32_t, REGIONCHUNKS> mVersions{};
+	// the order of the chunk's last reserve and of the write its table entry is from
+	std::array<uint32_t, REGIONCHUNKS> mReserved{};
+	std::array<uint32_t, REGIONCHUNKS> mCommitted{};
+	// one per sector of the file
+	std::vector<bool> mUsedSectors;
+	// released since the last sync began, still in use until it is done
+	std::vector<Location> mReleased;
+};
+
+struct RegionStorageStats
+{
+	uint64_t chunksLoaded = 0;
+	uint64_t chunksSaved = 0;
+	uint64_t bytesLoaded = 0;
+	uint64_t bytesSaved = 0;
+	// stored chunks that failed their checksum or belonged elsewhere, loaded as not stored
+	uint64_t chunksCorrupt = 0;
+	uint32_t regionsOpen = 0;
+	AsyncIOStats io;
+};
+
+// The region files of one world, opened on first use and kept open. Chunk position
+// (x, z) is in region (x, z) / REGIONSIZE, rounded down. Chunks are loaded and saved
+// either right away, reading from the mapping, or as tasks that read and write
+// through io. Every chunk is stored behind its position and a checksum of its
+// encoding, so one torn by a crash, or whose table entry reached the disk before
+// its data, is not loaded. Thread-safe.
+class RegionStorage
+{
+public:
+	RegionStorage(std::filesystem::path directory, AsyncIO& io);
+
+	RegionStorage(const RegionStorage&) = delete;
+	RegionStorage& operator=(const RegionStorage&) = delete;
+
+	// false, leaving data untouched, unless the chunk was saved and decodes; may be
+	// partly overwritten if it fails to decode
+	template<typename Dims>
+	bool loadChunk(glm::ivec2 position, BasicChunkData<Dims>& data);
+	template<typename Dims>
+	void saveChunk(glm::ivec2 position, const BasicChunkData<Dims>& data);
+	// the same as tasks: reading decodes on whichever thread the read resumes on, and
+	// writing encodes data when first awaited, before it suspends, so data only has
+	// to stay unchanged until then. A failed read is a chunk not stored, a failed
+	// write throws
+	template<typename Dims>
+	Task<bool> readChunk(glm::ivec2 position, BasicChunkData<Dims>& data);
+	template<typename Dims>
+	Task<void> writeChunk(glm::ivec2 position, const BasicChunkData<Dims>& data);
+	// writeChunk for a chunk encoded with encodeChunk already
+	template<typename Dims>
+	Task<void> writeEncoded(glm::ivec2 position, std::vector<uint8_t> bytes);
+	// blocks until no readChunk or writeChunk task is running
+	void waitIdle() const;
+	// blocks until every chunk saved so far is on the disk, not just handed to the OS
+	void sync();
+
+	const std::filesystem::path& getDirectory() const;
+	RegionStorageStats getStats() const;
+	void reportStats(std::ostream& out) const;
+private:
+	// nullptr if the region has no file yet and create is false
+	RegionFile* getRegion(glm::ivec2 region, bool create, int chunkSize, int chunkHeight);
+private:
+	std::filesystem::path mDirectory;
+	AsyncIO& mIO;
+	mutable std::mutex mMutex;
+	// keyed by packed region coordinates, nullptr for regions known to have no file
+	std::unordered_map<uint64_t, std::unique_ptr<RegionFile>> mRegions;
+
+	std::atomic<uint64_t> mChunksLoaded{ 0 };
+	std::atomic<uint64_t> mChunksSaved{ 0 };
+	std::atomic<uint64_t> mBytesLoaded{ 0 };
+	std::atomic<uint64_t> mBytesSaved{ 0 };
+	std::atomic<uint64_t> mChunksCorrupt{ 0 };
+	// readChunk and writeChunk tasks running
+	std::atomic<uint32_t> mActive{ 0 };
+};
\ No newline at end of file
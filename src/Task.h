@@ -0,0 +1,159 @@
+#pragma once
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <utility>
+
+// A coroutine producing a T. It is lazy: nothing runs until it is co_awaited, and
+// when it finishes it resumes its awaiter directly, on whichever thread finished
+// it. Exceptions are rethrown to the awaiter.
+template<typename T = void>
+class Task
+{
+public:
+	struct promise_type;
+	using Handle = std::coroutine_handle<promise_type>;
+
+	struct PromiseBase
+	{
+		std::coroutine_handle<> continuation;
+		std::exception_ptr error;
+
+		std::suspend_always initial_suspend() noexcept
+		{
+			return {};
+		}
+
+		// resumes the awaiter by symmetric transfer, so long chains do not grow the stack
+		auto final_suspend() noexcept
+		{
+			struct FinalAwaiter
+			{
+				bool await_ready() noexcept
+				{
+					return false;
+				}
+
+				std::coroutine_handle<> await_suspend(Handle handle) noexcept
+				{
+					return handle.promise().continuation;
+				}
+
+				void await_resume() noexcept
+				{
+				}
+			};
+			return FinalAwaiter{};
+		}
+
+		void unhandled_exception()
+		{
+			error = std::current_exception();
+		}
+	};
+
+	struct promise_type : PromiseBase
+	{
+		std::optional<T> value;
+
+		Task get_return_object()
+		{
+			return Task(Handle::from_promise(*this));
+		}
+
+		void return_value(T result)
+		{
+			value = std::move(result);
+		}
+	};
+
+	Task(Task&& other) noexcept
+		:mHandle(std::exchange(other.mHandle, nullptr))
+	{
+	}
+
+	~Task()
+	{
+		if (mHandle) mHandle.destroy();
+	}
+
+	Task(const Task&) = delete;
+	Task& operator=(const Task&) = delete;
+
+	bool await_ready() const noexcept
+	{
+		return false;
+	}
+
+	std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiter) noexcept
+	{
+		mHandle.promise().continuation = awaiter;
+		return mHandle;
+	}
+
+	T await_resume()
+	{
+		if (mHandle.promise().error)
+			std::rethrow_exception(mHandle.promise().error);
+		return std::move(*mHandle.promise().value);
+	}
+private:
+	explicit Task(Handle handle)
+		:mHandle(handle)
+	{
+	}
+private:
+	Handle mHandle;
+};
+
+template<>
+struct Task<void>::promise_type : Task<void>::PromiseBase
+{
+	Task get_return_object()
+	{
+		return Task(Handle::from_promise(*this));
+	}
+
+	void return_void()
+	{
+	}
+};
+
+template<>
+inline void Task<void>::await_resume()
+{
+	if (mHandle.promise().error)
+		std::rethrow_exception(mHandle.promise().error);
+}
+
+// The return type of coroutines nobody awaits. It starts running right away and
+// frees itself when done, so it must catch what it throws.
+struct DetachedTask
+{
+	struct promise_type
+	{
+		DetachedTask get_return_object()
+		{
+			return {};
+		}
+
+		std::suspend_never initial_suspend() noexcept
+		{
+			return {};
+		}
+
+		std::suspend_never final_suspend() noexcept
+		{
+			return {};
+		}
+
+		void return_void()
+		{
+		}
+
+		void unhandled_exception()
+		{
+			std::terminate();
+		}
+	};
+};
\ No newline at end of file
@@ -0,0 +1,421 @@
+#include "Tests.h"
+#include "World.h"
+#include "WorldGenerator.h"
+#include "RegionFile.h"
+#include "AsyncIO.h"
+#include "EditLog.h"
+#include "ChunkCache.h"
+#include "Epoch.h"
+#include "JobSystem.h"
+#include "Task.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+// chunks checked per round trip, in a square along x and z, generated with the
+// GENERATION_MARGIN ring they need to complete generation
+constexpr int TEST_CHUNK_GRID = 4;
+constexpr int TEST_CHUNKS = TEST_CHUNK_GRID * TEST_CHUNK_GRID;
+constexpr int TEST_GENERATED_GRID = TEST_CHUNK_GRID + 2 * GENERATION_MARGIN;
+constexpr uint32_t TEST_SEED = 7;
+constexpr int TEST_LOG_EDITS = 1 << 14;
+// reader threads and the guards each holds at once, and objects the writer publishes and retires
+constexpr int TEST_EPOCH_READERS = 4;
+constexpr int TEST_EPOCH_GUARDS = 8;
+constexpr int TEST_EPOCH_OBJECTS = 1 << 15;
+
+// the generated chunks of a test, the ring around them only runs the stages its
+// neighbours read, as the ChunkManager guarantees
+class TestChunks
+{
+public:
+	TestChunks(const WorldGenerator& generator)
+		:mChunks(std::make_unique<ChunkData[]>(TEST_GENERATED_GRID * TEST_GENERATED_GRID))
+	{
+		constexpr int GRID = TEST_GENERATED_GRID;
+		int ringStages = 0;
+		for (const GenerationStageInfo& info : GENERATIONSTAGEINFO)
+			if (info.neighbourRadius > 0)
+				ringStages = std::max(ringStages, info.neighbourStages);
+
+		for (int stage = 0; stage < GENERATIONSTAGES; stage++)
+		{
+			const int radius = GENERATIONSTAGEINFO[stage].neighbourRadius;
+			for (int x = 0; x < GRID; x++)
+			{
+				for (int z = 0; z < GRID; z++)
+				{
+					const bool inner = x >= GENERATION_MARGIN && x < GRID - GENERATION_MARGIN && z >= GENERATION_MARGIN && z < GRID - GENERATION_MARGIN;
+					if (!inner && stage >= ringStages) continue;
+
+					GenerationNeighbours<WorldDimensions> neighbours{};
+					for (int dx = -radius; dx <= radius; dx++)
+						for (int dz = -radius; dz <= radius; dz++)
+							neighbours[getGenerationNeighbourIndex(dx, dz)] = &mChunks[(x + dx) * GRID + z + dz];
+
+					const glm::ivec2 position(x - GENERATION_MARGIN, z - GENERATION_MARGIN);
+					generator.runStage(static_cast<GENERATIONSTAGE>(stage), position, mChunks[x * GRID + z], neighbours);
+				}
+			}
+		}
+	}
+
+	ChunkData& operator[](int i)
+	{
+		return mChunks[(i / TEST_CHUNK_GRID + GENERATION_MARGIN) * TEST_GENERATED_GRID + i % TEST_CHUNK_GRID + GENERATION_MARGIN];
+	}
+	static glm::ivec2 position(int i)
+	{
+		return glm::ivec2(i / TEST_CHUNK_GRID, i % TEST_CHUNK_GRID);
+	}
+private:
+	std::unique_ptr<ChunkData[]> mChunks;
+};
+
+// whether b holds exactly what a does, blocks, surface heights and biomes
+static bool isSameChunk(const ChunkData& a, const ChunkData& b)
+{
+	std::array<uint8_t, SECTIONVOLUME> voxelsA, voxelsB;
+	for (int section = 0; section < WorldDimensions::SECTIONCOUNT; section++)
+	{
+		a.getSection(section).getVoxels(voxelsA.data());
+		b.getSection(section).getVoxels(voxelsB.data());
+		if (voxelsA != voxelsB) return false;
+	}
+	for (int x = 0; x < CHUNKSIZE; x++)
+		for (int z = 0; z < CHUNKSIZE; z++)
+			if (a.getSurface(x, z) != b.getSurface(x, z) || a.getBiome(x, z) != b.getBiome(x, z))
+				return false;
+	return true;
+}
+
+static BlockEdit randomTestEdit(std::mt19937& random)
+{
+	const uint32_t value = random();
+	const glm::ivec3 position(value % CHUNKSIZE, value / CHUNKSIZE % CHUNKHEIGHT, random() % CHUNKSIZE);
+	return { TestChunks::position(random() % TEST_CHUNKS), position, static_cast<uint8_t>(random() % (STONE + 1)) };
+}
+
+// a scratch directory in the temp directory, removed again when the test is done
+class TestDirectory
+{
+public:
+	TestDirectory(const char* name)
+		:mPath(std::filesystem::temp_directory_path() / name)
+	{
+		std::filesystem::remove_all(mPath);
+	}
+	~TestDirectory()
+	{
+		std::error_code error;
+		std::filesystem::remove_all(mPath, error);
+	}
+
+	const std::filesystem::path& path() const { return mPath; }
+private:
+	std::filesystem::path mPath;
+};
+
+// counts itself in done once read and decoded, the caller waits for all of them
+static DetachedTask readTestChunk(RegionStorage& storage, glm::ivec2 position, ChunkData& data, std::atomic<uint32_t>& found, std::atomic<uint32_t>& done)
+{
+	const bool stored = co_await storage.readChunk(position, data);
+	if (stored)
+		found.fetch_add(1, std::memory_order_relaxed);
+	done.fetch_add(1, std::memory_order_release);
+	done.notify_one();
+}
+
+static void testRegions(const WorldGenerator& generator)
+{
+	TestChunks chunks(generator);
+	TestDirectory directory("region-test");
+	{
+		AsyncIO io;
+		RegionStorage storage(directory.path(), io);
+		for (int i = 0; i < TEST_CHUNKS; i++)
+			storage.saveChunk(TestChunks::position(i), chunks[i]);
+		storage.sync();
+
+		// saved again after edits, the chunks move to other sectors and free the old ones
+		std::mt19937 random(TEST_SEED);
+		for (int i = 0; i < TEST_CHUNKS * 64; i++)
+		{
+			const BlockEdit edit = randomTestEdit(random);
+			chunks[edit.chunk.x * TEST_CHUNK_GRID + edit.chunk.y].setBlock(edit.position, edit.type);
+		}
+		for (int i = 0; i < TEST_CHUNKS; i += 2)
+			storage.saveChunk(TestChunks::position(i), chunks[i]);
+		storage.sync();
+		for (int i = 1; i < TEST_CHUNKS; i += 2)
+			storage.saveChunk(TestChunks::position(i), chunks[i]);
+		storage.sync();
+		if (storage.getStats().chunksCorrupt != 0)
+			throw std::runtime_error("a saved chunk failed its checksum");
+	}
+
+	ChunkData loaded;
+	AsyncIO io;
+	RegionStorage storage(directory.path(), io);
+	for (int i = 0; i < TEST_CHUNKS; i++)
+		if (!storage.loadChunk(TestChunks::position(i), loaded) || !isSameChunk(chunks[i], loaded))
+			throw std::runtime_error("chunk " + std::to_string(i) + " changed in a save and load round trip");
+	if (storage.loadChunk({ TEST_CHUNK_GRID, 0 }, loaded))
+		throw std::runtime_error("a chunk never saved was found");
+
+	JobSystem jobs;
+	jobs.start();
+	AsyncIO asyncIO(&jobs);
+	RegionStorage asyncStorage(directory.path(), asyncIO);
+	std::unique_ptr<ChunkData[]> read = std::make_unique<ChunkData[]>(TEST_CHUNKS);
+	std::atomic<uint32_t> found = 0, done = 0;
+	for (int i = 0; i < TEST_CHUNKS; i++)
+		readTestChunk(asyncStorage, TestChunks::position(i), read[i], found, done);
+	for (uint32_t count = done.load(std::memory_order_acquire); count != TEST_CHUNKS; count = done.load(std::memory_order_acquire))
+		done.wait(count, std::memory_order_acquire);
+	if (found != TEST_CHUNKS)
+		throw std::runtime_error(std::to_string(TEST_CHUNKS - found) + " chunks not found reading asynchronously");
+	for (int i = 0; i < TEST_CHUNKS; i++)
+		if (!isSameChunk(chunks[i], read[i]))
+			throw std::runtime_error("chunk " + std::to_string(i) + " changed in an asynchronous read");
+	if (storage.getStats().chunksCorrupt + asyncStorage.getStats().chunksCorrupt != 0)
+		throw std::runtime_error("a loaded chunk failed its checksum");
+	jobs.stop();
+}
+
+static void testCache(const WorldGenerator& generator)
+{
+	TestChunks chunks(generator);
+	JobSystem jobs;
+	jobs.start();
+	ChunkCache cache(jobs);
+	for (int i = 0; i < TEST_CHUNKS; i++)
+		cache.store(TestChunks::position(i), chunks[i]);
+	while (jobs.getPendingCount() > 0)
+	{
+		jobs.runCompletions();
+		std::this_thread::yield();
+	}
+	jobs.runCompletions();
+
+	std::vector<uint8_t> bytes;
+	ChunkData decoded;
+	for (int i = 0; i < TEST_CHUNKS; i++)
+	{
+		if (!cache.take(TestChunks::position(i), bytes))
+			throw std::runtime_error("chunk " + std::to_string(i) + " was not cached");
+		cache.decode(bytes, decoded);
+		if (!isSameChunk(chunks[i], decoded))
+			throw std::runtime_error("chunk " + std::to_string(i) + " changed in the cache");
+	}
+	if (cache.take(TestChunks::position(0), bytes))
+		throw std::runtime_error("a chunk was still cached after it was taken");
+
+	// cut short, as a bad entry would be, it must not decode
+	bytes.resize(bytes.size() / 2);
+	bool threw = false;
+	try
+	{
+		cache.decode(bytes, decoded);
+	}
+	catch (const std::runtime_error&)
+	{
+		threw = true;
+	}
+	if (!threw || cache.getStats().corrupt != 1)
+		throw std::runtime_error("a truncated cache entry decoded");
+	jobs.stop();
+}
+
+static void testJobs()
+{
+	// the completion of a job whose work threw still runs, and gets the exception
+	JobSystem jobs;
+	jobs.start();
+	int completed = 0, failed = 0;
+	for (int i = 0; i < 8; i++)
+		jobs.submit([i]
+		{
+			if (i % 2) throw std::runtime_error("job failed");
+		}, [&](std::exception_ptr error)
+		{
+			completed++;
+			if (error) failed++;
+		});
+	while (jobs.getPendingCount() > 0)
+	{
+		jobs.runCompletions();
+		std::this_thread::yield();
+	}
+	jobs.stop();
+	if (completed != 8 || failed != 4)
+		throw std::runtime_error(std::to_string(completed) + " completions ran, " + std::to_string(failed) + " with an error, of 8 and 4");
+}
+
+static void testEditLog(const WorldGenerator& generator)
+{
+	TestChunks chunks(generator);
+	TestDirectory directory("editlog-test");
+	// what the chunks hold after every edit, sharing the saved chunks' sections until edited
+	std::unique_ptr<ChunkData[]> expected = std::make_unique<ChunkData[]>(TEST_CHUNKS);
+	{
+		AsyncIO io;
+		RegionStorage storage(directory.path(), io);
+		for (int i = 0; i < TEST_CHUNKS; i++)
+		{
+			storage.saveChunk(TestChunks::position(i), chunks[i]);
+			expected[i].share(chunks[i]);
+		}
+		storage.sync();
+
+		EditLog log(directory.path());
+		std::mt19937 random(TEST_SEED);
+		for (int i = 0; i < TEST_LOG_EDITS; i++)
+		{
+			const BlockEdit edit = randomTestEdit(random);
+			expected[edit.chunk.x * TEST_CHUNK_GRID + edit.chunk.y].setBlock(edit.position, edit.type);
+			log.append(edit);
+		}
+		log.close();
+	}
+	for (const auto& entry : std::filesystem::directory_iterator(directory.path()))
+		if (entry.path().extension() == ".log")
+		{
+			// a group a crash interrupted, its header made it to the disk and half its edits
+			const uint32_t torn[4] = { EDITLOG_MAGIC, 64, 0, 0 };
+			std::ofstream file(entry.path(), std::ios::binary | std::ios::app);
+			file.write(reinterpret_cast<const char*>(torn), sizeof(torn));
+			file.write(std::string(32 * 12, '\x5A').data(), 32 * 12);
+		}
+
+	std::vector<std::vector<BlockEdit>> recovered(TEST_CHUNKS);
+	EditLog log(directory.path());
+	const uint64_t replayed = log.replay([&](const BlockEdit& edit)
+	{
+		recovered[edit.chunk.x * TEST_CHUNK_GRID + edit.chunk.y].push_back(edit);
+	});
+	log.close();
+	if (replayed != TEST_LOG_EDITS)
+		throw std::runtime_error(std::to_string(replayed) + " edits replayed of " + std::to_string(TEST_LOG_EDITS));
+
+	ChunkData loaded;
+	AsyncIO io;
+	RegionStorage storage(directory.path(), io);
+	for (int i = 0; i < TEST_CHUNKS; i++)
+	{
+		if (!storage.loadChunk(TestChunks::position(i), loaded))
+			throw std::runtime_error("saved chunk " + std::to_string(i) + " is missing");
+		for (const BlockEdit& edit : recovered[i])
+			loaded.setBlock(edit.position, edit.type);
+		if (!isSameChunk(expected[i], loaded))
+			throw std::runtime_error("chunk " + std::to_string(i) + " differs from the chunk as edited after replay");
+	}
+}
+
+static void testEpoch()
+{
+	// never freed, the deleter only marks them dead so a reader seeing one is caught
+	// instead of reading freed memory
+	struct Published
+	{
+		std::atomic<bool> alive{ true };
+	};
+	std::unique_ptr<Published[]> objects = std::make_unique<Published[]>(TEST_EPOCH_OBJECTS);
+	std::atomic<Published*> current = &objects[0];
+	std::atomic<bool> writing = true;
+	std::atomic<uint64_t> deadReads = 0, reads = 0;
+
+	// more guards than one block of slots holds, pinned at once
+	EpochDomain domain;
+	{
+		std::vector<EpochGuard> guards;
+		for (int i = 0; i <= EPOCH_SLOTS; i++)
+			guards.push_back(domain.pin());
+		if (domain.getStats().slots <= EPOCH_SLOTS)
+			throw std::runtime_error("the guard slots did not grow past one block");
+	}
+
+	std::vector<std::thread> readers;
+	for (int reader = 0; reader < TEST_EPOCH_READERS; reader++)
+	{
+		readers.emplace_back([&]
+		{
+			std::vector<std::pair<EpochGuard, Published*>> held;
+			while (writing.load(std::memory_order_relaxed))
+			{
+				held.clear();
+				for (int i = 0; i < TEST_EPOCH_GUARDS; i++)
+				{
+					EpochGuard guard = domain.pin();
+					held.push_back({ std::move(guard), current.load(std::memory_order_acquire) });
+				}
+				// every object loaded is still alive while its guard is, however much the
+				// writer retired and collected in the meantime
+				std::this_thread::yield();
+				for (auto& [guard, object] : held)
+					if (!object->alive.load(std::memory_order_acquire))
+						deadReads.fetch_add(1, std::memory_order_relaxed);
+				reads.fetch_add(held.size(), std::memory_order_relaxed);
+			}
+		});
+	}
+
+	for (int i = 1; i < TEST_EPOCH_OBJECTS; i++)
+	{
+		Published* old = current.exchange(&objects[i], std::memory_order_acq_rel);
+		domain.retire(old, [](void* object) { static_cast<Published*>(object)->alive.store(false, std::memory_order_release); });
+		if (i % 16 == 0)
+		{
+			domain.collect();
+			std::this_thread::yield();
+		}
+	}
+	writing = false;
+	for (std::thread& reader : readers)
+		reader.join();
+	domain.collect();
+
+	const EpochStats stats = domain.getStats();
+	if (deadReads != 0)
+		throw std::runtime_error(std::to_string(deadReads) + " of " + std::to_string(reads) + " reads saw a reclaimed object");
+	if (stats.pinned != 0 || stats.waiting != 0 || stats.reclaimed != stats.retired)
+		throw std::runtime_error(std::to_string(stats.retired - stats.reclaimed) + " retired objects were never reclaimed");
+}
+
+int runTests(std::ostream& out)
+{
+	const WorldGenerator generator(TEST_SEED);
+	const std::array<std::pair<const char*, std::function<void()>>, 5> tests = { {
+		{ "jobs", [] { testJobs(); } },
+		{ "regions", [&] { testRegions(generator); } },
+		{ "cache", [&] { testCache(generator); } },
+		{ "edit log", [&] { testEditLog(generator); } },
+		{ "epoch", [] { testEpoch(); } },
+	} };
+
+	int failed = 0;
+	for (const auto& [name, test] : tests)
+	{
+		try
+		{
+			test();
+			out << "passed " << name << "\n";
+		}
+		catch (const std::exception& e)
+		{
+			out << "FAILED " << name << ": " << e.what() << "\n";
+			failed++;
+		}
+	}
+	out << tests.size() - failed << " of " << tests.size() << " tests passed" << std::endl;
+	return failed;
+}
\ No newline at end of file
@@ -0,0 +1,16 @@
+#pragma once
+#include <ostream>
+
+// Round trip checks of what the game saves, caches and reclaims, run from the command
+// line with --test as the tests project does after every build. Each one writes a line
+// to out, the first mismatch fails it. Returns how many failed.
+//  regions: chunks saved, moved off their sectors by a second save, synced and loaded
+//    back through a storage that maps the files afresh, synchronously and asynchronously
+//  jobs: completions run and are handed the exception of jobs whose work threw
+//  cache: chunks stored into a ChunkCache, taken and decoded again, a truncated one
+//    fails to
+//  edit log: edits appended and committed, a torn group after them, replayed into the
+//    saved chunks on reopening
+//  epoch: threads pinning more guards than a slot block holds and reading published
+//    objects while the writer retires and collects them, none may be freed while seen
+int runTests(std::ostream& out);
\ No newline at end of file
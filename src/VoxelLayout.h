@@ -0,0 +1,78 @@
+#pragma once
+#include <cstdint>
+#include <glm/glm.hpp>
+
+// Voxel orders for a cube of SIZE blocks per axis, SIZE a power of two. index maps
+// block coordinates to a storage position and coords maps it back. CONTIGUOUSAXIS is
+// the axis along which SIZE neighbouring blocks are SIZE consecutive positions,
+// -1 if there is none.
+
+// x outermost, z innermost: rows along z are contiguous, the mesher's padded copy order
+template<uint32_t SIZE>
+struct LinearLayout
+{
+	static constexpr int CONTIGUOUSAXIS = 2;
+
+	static constexpr uint32_t index(uint32_t x, uint32_t y, uint32_t z)
+	{
+		return (x * SIZE + y) * SIZE + z;
+	}
+	static glm::ivec3 coords(uint32_t i)
+	{
+		return glm::ivec3(i / (SIZE * SIZE), i / SIZE % SIZE, i % SIZE);
+	}
+};
+
+// y innermost: columns are contiguous, the order of column masks, heightmaps and skylight
+template<uint32_t SIZE>
+struct ColumnLayout
+{
+	static constexpr int CONTIGUOUSAXIS = 1;
+
+	static constexpr uint32_t index(uint32_t x, uint32_t y, uint32_t z)
+	{
+		return (x * SIZE + z) * SIZE + y;
+	}
+	static glm::ivec3 coords(uint32_t i)
+	{
+		return glm::ivec3(i / (SIZE * SIZE), i % SIZE, i / SIZE % SIZE);
+	}
+};
+
+// Z-order curve: the bits of x, y and z interleaved, so every aligned 2^n cube is one
+// contiguous tile and all six neighbours of a block tend to share its cache lines
+template<uint32_t SIZE>
+struct MortonLayout
+{
+	static_assert(SIZE <= 1024, "Morton indices are limited to 10 bits per axis");
+	static constexpr int CONTIGUOUSAXIS = -1;
+
+	static constexpr uint32_t index(uint32_t x, uint32_t y, uint32_t z)
+	{
+		return spread(x) << 2 | spread(y) << 1 | spread(z);
+	}
+	static glm::ivec3 coords(uint32_t i)
+	{
+		return glm::ivec3(compact(i >> 2), compact(i >> 1), compact(i));
+	}
+private:
+	// moves bit n of v to bit 3n
+	static constexpr uint32_t spread(uint32_t v)
+	{
+		v &= 0x3FF;
+		v = (v | v << 16) & 0x030000FF;
+		v = (v | v << 8) & 0x0300F00F;
+		v = (v | v << 4) & 0x030C30C3;
+		v = (v | v << 2) & 0x09249249;
+		return v;
+	}
+	static constexpr uint32_t compact(uint32_t v)
+	{
+		v &= 0x09249249;
+		v = (v ^ (v >> 2)) & 0x030C30C3;
+		v = (v ^ (v >> 4)) & 0x0300F00F;
+		v = (v ^ (v >> 8)) & 0xFF0000FF;
+		v = (v ^ (v >> 16)) & 0x000003FF;
+		return v;
+	}
+};
\ No newline at end of file
@@ -1,186 +1,1088 @@
 #include "World.h"
 #include "GraphicsEngine.h"
+#include "Mesher.h"
 #include <array>
+#include <chrono>
+#include <iomanip>
+#include <cstring>
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <mutex>
+#include <unordered_map>
 #include <glm/glm.hpp>
 
-Chunk::Chunk(glm::ivec2 aWorldPos)
+// summed over every chunk shape, buildMesh runs on any worker
+struct MeshTotals
+{
+    std::atomic<uint64_t> wholeMeshes{ 0 };
+    std::atomic<uint64_t> partialMeshes{ 0 };
+    std::atomic<uint64_t> quads{ 0 };
+    std::atomic<uint64_t> faces{ 0 };
+    std::atomic<uint64_t> allocations{ 0 };
+    std::atomic<uint64_t> bytesCopied{ 0 };
+    std::atomic<uint64_t> wholeNs{ 0 };
+    std::atomic<uint64_t> partialNs{ 0 };
+};
+static MeshTotals sMeshTotals;
+
+template<typename Dims>
+BasicChunk<Dims>::BasicChunk(glm::ivec2 aWorldPos)
     :mWorldPosition(aWorldPos)
 {
     
 }
 
 
-Chunk::~Chunk()
+template<typename Dims>
+BasicChunk<Dims>::~BasicChunk()
 {
-    
+    mInput = MeshInput{};
+    unpublish();
 }
 
-void Chunk::generateMesh()
+template<typename Dims>
+void BasicChunk<Dims>::prepareMesh(MESHINGMODE mode)
 {
-    uint8_t* data = mData.getData();
+    if (!mMeshed || mode != mMeshingMode)
+        mDirtyRegions = ALLREGIONS;
+    mMeshingMode = mode;
+
+    // pinned before the loads, a version retired after them stays until the mesh is built
+    mInput.guard = EpochDomain::get().pin();
+    publish();
+    mInput.data = getPublished();
+    for (int side = 0; side < BORDERMESHES; side++)
+    {
+        if (mNeighbours[side])
+            mNeighbours[side]->publish();
+        mInput.neighbours[side] = mNeighbours[side] ? mNeighbours[side]->getPublished() : nullptr;
+    }
+
+    mInput.regions = mDirtyRegions;
+    mInput.sections = mDirtySections;
+    mDirtyRegions = 0;
+    mDirtySections.reset();
+}
+
+template<typename Dims>
+void BasicChunk<Dims>::buildMesh()
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    if (!mInput.guard.isPinned())
+        prepareMesh();
+
+    const std::bitset<Dims::SECTIONCOUNT>& sections = mInput.sections;
+    const bool rebuild = sections.count() * 100 > Dims::SECTIONCOUNT * REMESH_REBUILD_PERCENT;
+    const uint32_t regions = rebuild ? ALLREGIONS : mInput.regions;
 
-    std::vector<uint16_t> Indices = {
-        0,1,2, 2,3,0
-    };
+    // only the bands holding marked sections are read again, unless a region is rebuilt whole
+    constexpr uint32_t ALLBANDS = ChunkMesher<Dims>::ALLBANDS;
+    constexpr int BANDSECTIONCOUNT = Dims::SECTIONSXZ * Dims::SECTIONSXZ * BANDSECTIONS;
+    uint32_t bands = regions ? ALLBANDS : 0;
+    for (int section = 0; section < Dims::SECTIONCOUNT; section++)
+        if (sections[section])
+            bands |= 1u << (section / BANDSECTIONCOUNT);
 
-    int forwardIndices = 0;
+    MeshScratch<Dims>& scratch = MeshScratch<Dims>::get();
+    MeshStats stats;
+    stats.bytesCopied += fillPaddedData(scratch, bands);
+    scratch.mesher.prepare(bands);
 
-    for(int x = 0; x < CHUNKSIZE; x++)
-        for (int y = 0; y < CHUNKHEIGHT; y++)
-        for (int z = 0; z < CHUNKSIZE; z++)
+    for (int region = 0; region < MESHREGIONS; region++)
+    {
+        if (!(regions & (1u << region)))
         {
-            
-            BLOCKTYPE bType = (BLOCKTYPE)data[static_cast<int>(x * CHUNKHEIGHT * CHUNKSIZE + y * CHUNKSIZE + z)];
-            if (bType == AIR) continue;
-            // add entire cubes for now
-            mMeshVertices.reserve(mMeshVertices.size() + 24);
-
-            uint8_t frontTexture = getBlockTextureIndex(bType, BLOCKFACE::FRONT);
-            uint8_t backTexture = getBlockTextureIndex(bType, BLOCKFACE::BACK);
-            uint8_t leftTexture = getBlockTextureIndex(bType, BLOCKFACE::LEFT);
-            uint8_t rightTexture = getBlockTextureIndex(bType, BLOCKFACE::RIGHT);
-            uint8_t topTexture = getBlockTextureIndex(bType, BLOCKFACE::TOP);
-            uint8_t bottomTexture = getBlockTextureIndex(bType, BLOCKFACE::BOTTOM);
-
-            
-
-            if (mData.isFaceVisible({ x, y, z }, FRONT))
-            {
-                mMeshVertices.push_back(Vertex{ glm::vec3(x, y + 1.0f, z), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec2((frontTexture % 10) * 0.1f, (frontTexture / 10) * 0.1f + 0.1f) });
-                mMeshVertices.push_back(Vertex{ glm::vec3(x, y, z), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec2((frontTexture % 10) * 0.1f, (frontTexture / 10) * 0.1f) });
-                mMeshVertices.push_back(Vertex{ glm::vec3(x + 1.0f,  y, z), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec2((frontTexture % 10) * 0.1f + 0.1f, (frontTexture / 10) * 0.1f) });
-                mMeshVertices.push_back(Vertex{ glm::vec3(x + 1.0f,  y + 1.0f, z), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec2((frontTexture % 10) * 0.1f + 0.1f, (frontTexture / 10) * 0.1f + 0.1f) });
-
-                for (const uint16_t& index : Indices)
-                    mMeshIndices.push_back(index + forwardIndices);
-                forwardIndices += 4;
-            }
+            bool marked = false;
+            for (int section = 0; section < Dims::SECTIONCOUNT && !marked; section++)
+                marked = sections[section] && ChunkMesher<Dims>::regionHasSection(region, section);
+            if (!marked || updateRegion(scratch, region, sections, stats)) continue;
 
-            if (mData.isFaceVisible({ x,y,z }, BACK))
+            // the edits outgrew the buffer, the rebuild reads every band
+            if (bands != ALLBANDS)
             {
-                mMeshVertices.push_back(Vertex{ glm::vec3(x + 1.0f,  y + 1.0f, z + 1.0f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec2((backTexture % 10) * 0.1f,        (backTexture / 10) * 0.1f + 0.1f) });
-                mMeshVertices.push_back(Vertex{ glm::vec3(x + 1.0f,  y,        z + 1.0f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec2((backTexture % 10) * 0.1f,        (backTexture / 10) * 0.1f) });
-                mMeshVertices.push_back(Vertex{ glm::vec3(x,         y,        z + 1.0f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec2((backTexture % 10) * 0.1f + 0.1f, (backTexture / 10) * 0.1f) });
-                mMeshVertices.push_back(Vertex{ glm::vec3(x,         y + 1.0f, z + 1.0f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec2((backTexture % 10) * 0.1f + 0.1f,        (backTexture / 10) * 0.1f + 0.1f) });
-
-                for (const uint16_t& index : Indices)
-                    mMeshIndices.push_back(index + forwardIndices);
-                forwardIndices += 4;
+                stats.bytesCopied += fillPaddedData(scratch, ALLBANDS & ~bands);
+                scratch.mesher.prepare(ALLBANDS & ~bands);
+                bands = ALLBANDS;
             }
+        }
+        stats += buildRegion(scratch, region);
+    }
+    stats.allocations += scratch.takeAllocations();
+    mInput = MeshInput{};
 
-            if (mData.isFaceVisible({ x,y,z }, LEFT))
-            {
-                mMeshVertices.push_back(Vertex{ glm::vec3(x,  y,        z + 1.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec2((leftTexture % 10) * 0.1f,        (leftTexture / 10) * 0.1f) });
-                mMeshVertices.push_back(Vertex{ glm::vec3(x,  y,        z),        glm::vec3(1.0f, 0.0f, 0.0f), glm::vec2((leftTexture % 10) * 0.1f + 0.1f, (leftTexture / 10) * 0.1f) });
-                mMeshVertices.push_back(Vertex{ glm::vec3(x,  y + 1.0f, z),        glm::vec3(1.0f, 0.0f, 0.0f), glm::vec2((leftTexture % 10) * 0.1f + 0.1f, (leftTexture / 10) * 0.1f + 0.1f) });
-                mMeshVertices.push_back(Vertex{ glm::vec3(x,  y + 1.0f, z + 1.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec2((leftTexture % 10) * 0.1f,        (leftTexture / 10) * 0.1f + 0.1f) });
-
-                for (const uint16_t& index : Indices)
-                    mMeshIndices.push_back(index + forwardIndices);
-                forwardIndices += 4;
-            }
+    const uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - start).count();
+    if (regions == ALLREGIONS)
+    {
+        sMeshTotals.wholeMeshes.fetch_add(1, std::memory_order_relaxed);
+        sMeshTotals.quads.fetch_add(stats.quadCount, std::memory_order_relaxed);
+        sMeshTotals.faces.fetch_add(stats.faceCount, std::memory_order_relaxed);
+        sMeshTotals.wholeNs.fetch_add(ns, std::memory_order_relaxed);
+    }
+    else
+    {
+        sMeshTotals.partialMeshes.fetch_add(1, std::memory_order_relaxed);
+        sMeshTotals.partialNs.fetch_add(ns, std::memory_order_relaxed);
+    }
+    sMeshTotals.allocations.fetch_add(stats.allocations, std::memory_order_relaxed);
+    sMeshTotals.bytesCopied.fetch_add(stats.bytesCopied, std::memory_order_relaxed);
+}
 
-            if (mData.isFaceVisible({ x,y,z }, RIGHT))
-            {
-                mMeshVertices.push_back(Vertex{ glm::vec3(x + 1.0f,  y,        z + 1.0f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec2((rightTexture % 10) * 0.1f,        (rightTexture / 10) * 0.1f) });
-                mMeshVertices.push_back(Vertex{ glm::vec3(x + 1.0f,  y,        z),        glm::vec3(0.0f, 1.0f, 0.0f), glm::vec2((rightTexture % 10) * 0.1f + 0.1f,        (rightTexture / 10) * 0.1f) });
-                mMeshVertices.push_back(Vertex{ glm::vec3(x + 1.0f,  y + 1.0f, z),        glm::vec3(0.0f, 1.0f, 0.0f), glm::vec2((rightTexture % 10) * 0.1f + 0.1f, (rightTexture / 10) * 0.1f + 0.1f) });
-                mMeshVertices.push_back(Vertex{ glm::vec3(x + 1.0f,  y + 1.0f, z + 1.0f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec2((rightTexture % 10) * 0.1f, (rightTexture / 10) * 0.1f + 0.1f) });
-
-                for (const uint16_t& index : Indices)
-                    mMeshIndices.push_back(index + forwardIndices);
-                forwardIndices += 4;
-            }
+template<typename Dims>
+ChunkMeshStats BasicChunk<Dims>::getMeshStats()
+{
+    ChunkMeshStats stats;
+    stats.wholeMeshes = sMeshTotals.wholeMeshes.load(std::memory_order_relaxed);
+    stats.partialMeshes = sMeshTotals.partialMeshes.load(std::memory_order_relaxed);
+    stats.quads = sMeshTotals.quads.load(std::memory_order_relaxed);
+    stats.faces = sMeshTotals.faces.load(std::memory_order_relaxed);
+    stats.allocations = sMeshTotals.allocations.load(std::memory_order_relaxed);
+    stats.bytesCopied = sMeshTotals.bytesCopied.load(std::memory_order_relaxed);
+    stats.wholeMs = sMeshTotals.wholeNs.load(std::memory_order_relaxed) / 1e6;
+    stats.partialMs = sMeshTotals.partialNs.load(std::memory_order_relaxed) / 1e6;
+    return stats;
+}
 
-            if (mData.isFaceVisible({ x,y,z }, TOP))
-            {
-                mMeshVertices.push_back(Vertex{ glm::vec3(x,        y, z),        glm::vec3(0.0f, 1.0f, 0.0f), glm::vec2((topTexture % 10) * 0.1f,        (topTexture / 10) * 0.1f + 0.1f) });
-                mMeshVertices.push_back(Vertex{ glm::vec3(x,        y, z + 1.0f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec2((topTexture % 10) * 0.1f,        (topTexture / 10) * 0.1f) });
-                mMeshVertices.push_back(Vertex{ glm::vec3(x + 1.0f, y, z + 1.0f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec2((topTexture % 10) * 0.1f + 0.1f, (topTexture / 10) * 0.1f) });
-                mMeshVertices.push_back(Vertex{ glm::vec3(x + 1.0f, y, z),        glm::vec3(0.0f, 1.0f, 0.0f), glm::vec2((topTexture % 10) * 0.1f + 0.1f,        (topTexture / 10) * 0.1f + 0.1f) });
-
-                for (const uint16_t& index : Indices)
-                    mMeshIndices.push_back(index + forwardIndices);
-                forwardIndices += 4;
-            }
-            if (mData.isFaceVisible({ x,y,z }, BOTTOM))
-            {
-                mMeshVertices.push_back(Vertex{ glm::vec3(x,        y + 1.0f, z),         glm::vec3(0.0f, 1.0f, 0.0f), glm::vec2((bottomTexture % 10) * 0.1f,        (bottomTexture / 10) * 0.1f + 0.1f) });
-                mMeshVertices.push_back(Vertex{ glm::vec3(x,        y + 1.0f, z + 1.0f),  glm::vec3(0.0f, 1.0f, 0.0f), glm::vec2((bottomTexture % 10) * 0.1f,        (bottomTexture / 10) * 0.1f) });
-                mMeshVertices.push_back(Vertex{ glm::vec3(x + 1.0f, y + 1.0f, z + 1.0f),  glm::vec3(0.0f, 1.0f, 0.0f), glm::vec2((bottomTexture % 10) * 0.1f + 0.1f, (bottomTexture / 10) * 0.1f) });
-                mMeshVertices.push_back(Vertex{ glm::vec3(x + 1.0f, y + 1.0f, z),         glm::vec3(0.0f, 1.0f, 0.0f), glm::vec2((bottomTexture % 10) * 0.1f + 0.1f,        (bottomTexture / 10) * 0.1f + 0.1f) });
-
-                for (const uint16_t& index : Indices)
-                    mMeshIndices.push_back(index + forwardIndices);
-                forwardIndices += 4;
-            }
+template<typename Dims>
+void BasicChunk<Dims>::reportMeshStats(std::ostream& out)
+{
+    const ChunkMeshStats stats = getMeshStats();
+    out << "Chunk meshing: " << stats.wholeMeshes << " chunks meshed whole in " << std::fixed << std::setprecision(3)
+        << (stats.wholeMeshes ? stats.wholeMs / stats.wholeMeshes : 0.0) << " ms each, " << stats.partialMeshes << " partly rebuilt in "
+        << (stats.partialMeshes ? stats.partialMs / stats.partialMeshes : 0.0) << " ms each, " << std::setprecision(1)
+        << (stats.wholeMeshes ? static_cast<double>(stats.quads) / stats.wholeMeshes : 0.0) << " quads per chunk where per-face meshing draws "
+        << (stats.wholeMeshes ? static_cast<double>(stats.faces) / stats.wholeMeshes : 0.0) << ", "
+        << stats.allocations << " allocations, " << stats.bytesCopied / 1024 << " KiB copied" << std::endl;
+}
+
+template<typename Dims>
+void BasicChunk<Dims>::uploadMesh()
+{
+    for (int region = 0; region < MESHREGIONS; region++)
+        uploadRegion(region);
+    mMeshed = true;
+}
+
+template<typename Dims>
+void BasicChunk<Dims>::generateMesh(MESHINGMODE mode)
+{
+    prepareMesh(mode);
+    buildMesh();
+    uploadMesh();
+}
+
+template<typename Dims>
+void BasicChunk<Dims>::publish()
+{
+    const ChunkVersion<Dims>* previous = mPublished.load(std::memory_order_relaxed);
+    if (previous && mUnpublished.none()) return;
+
+    // sharing bumps the reference count of the sections' storage, the next setBlock of
+    // each copies it
+    ChunkVersion<Dims>* version = new ChunkVersion<Dims>();
+    version->version = ++mVersion;
+    version->data.share(mData);
+    for (int section = 0; section < Dims::SECTIONCOUNT; section++)
+        version->sectionVersions[section] = !previous || mUnpublished[section] ? version->version : previous->sectionVersions[section];
+    mUnpublished.reset();
+
+    // release, the version is complete before a reader can load it
+    mPublished.store(version, std::memory_order_release);
+    if (previous)
+        EpochDomain::get().retire(previous);
+}
+
+template<typename Dims>
+const ChunkVersion<Dims>* BasicChunk<Dims>::getPublished() const
+{
+    return mPublished.load(std::memory_order_acquire);
+}
+
+template<typename Dims>
+void BasicChunk<Dims>::unpublish()
+{
+    if (const ChunkVersion<Dims>* previous = mPublished.exchange(nullptr, std::memory_order_acq_rel))
+        EpochDomain::get().retire(previous);
+    mUnpublished.reset();
+}
+
+template<typename Dims>
+void BasicChunk<Dims>::setNeighbour(BLOCKFACE side, BasicChunk* neighbour)
+{
+    if (mNeighbours[side] == neighbour) return;
+    mNeighbours[side] = neighbour;
+
+    // only the faces on the shared border can change
+    mDirtyRegions |= 1u << side;
+}
+
+template<typename Dims>
+BasicChunk<Dims>* BasicChunk<Dims>::getNeighbour(BLOCKFACE side) const
+{
+    return mNeighbours[side];
+}
+
+template<typename Dims>
+uint32_t BasicChunk<Dims>::setBlock(glm::ivec3 blockPos, uint8_t block)
+{
+    if (blockPos.x < 0 || blockPos.x >= Dims::SIZE || blockPos.y < 0 || blockPos.y >= Dims::HEIGHT || blockPos.z < 0 || blockPos.z >= Dims::SIZE)
+        return 0;
+    if (mData.getBlock(blockPos) == block) return 0;
+    mData.setBlock(blockPos, block);
+    mUnpublished.set(Dims::sectionIndex(blockPos.x / SECTIONSIZE, blockPos.y / SECTIONSIZE, blockPos.z / SECTIONSIZE));
+
+    uint32_t neighbours = 0;
+    forEachAffectedSection(blockPos, [&](glm::ivec2 offset, int section)
+    {
+        if (offset == glm::ivec2(0))
+        {
+            markSection(section);
+            return;
         }
-    GraphicsEngine::createVertexBuffer(mMeshVertices, mVertexBuffer, mVertexBufferMemory);
-    GraphicsEngine::createIndexBuffer(mMeshIndices, mIndexBuffer, mIndexBufferMemory);
 
-    
+        const BLOCKFACE side = offset.x > 0 ? RIGHT : offset.x < 0 ? LEFT : offset.y > 0 ? BACK : FRONT;
+        if (!mNeighbours[side]) return;
+        mNeighbours[side]->markSection(section);
+        neighbours |= 1u << side;
+    });
+    return neighbours;
 }
 
-void Chunk::Render(VkCommandBuffer commandBuffer)
+template<typename Dims>
+void BasicChunk<Dims>::markSection(int section)
 {
-    VkBuffer vertexBuffers[] = { mVertexBuffer };
+    mDirtySections.set(section);
+}
+
+template<typename Dims>
+bool BasicChunk<Dims>::needsMesh() const
+{
+    return !mMeshed || mDirtyRegions != 0 || mDirtySections.any();
+}
+
+template<typename Dims>
+void BasicChunk<Dims>::Render(VkCommandBuffer commandBuffer, VkPipelineLayout pipelineLayout)
+{
+    ChunkPushConstants constants{};
+    constants.origin = glm::vec3(mWorldPosition.x * Dims::SIZE, 0.0f, mWorldPosition.y * Dims::SIZE);
+    vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(ChunkPushConstants), &constants);
+
     VkDeviceSize offsets[] = { 0 };
-    vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets);
-    vkCmdBindIndexBuffer(commandBuffer, mIndexBuffer, 0, VK_INDEX_TYPE_UINT16);
 
-    vkCmdDrawIndexed(commandBuffer, static_cast<uint32_t>(mMeshIndices.size()), 1, 0, 0, 0);
+    for (const ChunkMesh& mesh : mMeshes)
+    {
+        if (mesh.quadCount == 0) continue;
+
+        vkCmdBindVertexBuffers(commandBuffer, 0, 1, &mesh.vertexBuffer.buffer, offsets);
+        GraphicsEngine::bindQuadIndexBuffer(commandBuffer, mesh.quadCount);
+
+        vkCmdDrawIndexed(commandBuffer, mesh.quadCount * 6, 1, 0, 0, 0);
+    }
 }
 
-glm::ivec2 Chunk::getPosition() const
+template<typename Dims>
+glm::ivec2 BasicChunk<Dims>::getPosition() const
 {
     return mWorldPosition;
 }
 
-void Chunk::destroyChunk()
+template<typename Dims>
+BasicChunkData<Dims>& BasicChunk<Dims>::getData()
 {
-    VkDevice device = GraphicsEngine::getDevice();
+    return mData;
+}
 
-    vkFreeMemory(device, mIndexBufferMemory, nullptr);
-    vkDestroyBuffer(device, mIndexBuffer, nullptr);
-    vkFreeMemory(device, mVertexBufferMemory, nullptr);
-    vkDestroyBuffer(device, mVertexBuffer, nullptr);
+template<typename Dims>
+const BasicChunkData<Dims>& BasicChunk<Dims>::getData() const
+{
+    return mData;
 }
 
-ChunkData::ChunkData()
+template<typename Dims>
+void BasicChunk<Dims>::reset(glm::ivec2 aWorldPos)
 {
-    pData = new uint8_t[CHUNKSIZE * CHUNKHEIGHT * CHUNKSIZE];
-    allocateChunkData();
+    destroyChunk();
+    mNeighbours.fill(nullptr);
+    mDirtyRegions = ALLREGIONS;
+    mDirtySections.reset();
+    mVersion = 0;
+    mWorldPosition = aWorldPos;
 }
 
-ChunkData::~ChunkData()
+template<typename Dims>
+void BasicChunk<Dims>::destroyChunk()
 {
-    delete[] pData;
+    for (ChunkMesh& mesh : mMeshes)
+        destroyMesh(mesh);
+    for (PendingMesh& pending : mPending)
+    {
+        GraphicsEngine::releaseStagingBuffer(pending.staging);
+        pending = PendingMesh{};
+    }
+    mMeshed = false;
+    // a prepared mesh whose job never ran
+    mInput = MeshInput{};
+    unpublish();
 }
 
-bool ChunkData::allocateChunkData()
+template<typename Dims>
+uint32_t BasicChunk<Dims>::fillPaddedData(MeshScratch<Dims>& scratch, uint32_t bands)
 {
-    for (size_t x = 0; x < CHUNKSIZE; x++)
-        for (size_t y = 0; y < CHUNKHEIGHT; y++)
-            for (size_t z = 0; z < CHUNKSIZE; z++)
-            {
-                if(y == 0)
-                    pData[x * CHUNKHEIGHT * CHUNKSIZE + y * CHUNKSIZE + z] = static_cast<uint8_t>(BLOCKTYPE::GRASS);
-                else if(y > 0 && y < 5)
-                    pData[x * CHUNKHEIGHT * CHUNKSIZE + y * CHUNKSIZE + z] = static_cast<uint8_t>(BLOCKTYPE::DIRT);
-                else
-                    pData[x * CHUNKHEIGHT * CHUNKSIZE + y * CHUNKSIZE + z] = static_cast<uint8_t>(BLOCKTYPE::STONE);
-            }
-            
+    std::array<const BasicChunkData<Dims>*, BORDERMESHES> neighbours;
+    for (int side = 0; side < BORDERMESHES; side++)
+        neighbours[side] = mInput.neighbours[side] ? &mInput.neighbours[side]->data : nullptr;
+
+    uint32_t bytesCopied = 0;
+    for (int band = 0; band < static_cast<int>(scratch.bands.size()); band++)
+        if (bands & (1u << band))
+            bytesCopied += scratch.bands[band].fill(mInput.data->data, neighbours, band);
+
+    return bytesCopied;
+}
+
+// empties the pending mesh but keeps the memory of its lists
+static void clearPending(PendingMesh& pending)
+{
+    GraphicsEngine::releaseStagingBuffer(pending.staging);
+    pending.quadCount = 0;
+    pending.ready = false;
+    pending.partial = false;
+    pending.copies.clear();
+    pending.clears.clear();
+}
 
+template<typename Dims>
+MeshStats BasicChunk<Dims>::buildRegion(MeshScratch<Dims>& scratch, int region)
+{
+    ChunkMesher<Dims>& mesher = scratch.mesher;
+    PendingMesh& pending = mPending[region];
+    std::array<MeshSpan, Dims::SECTIONCOUNT>& spans = mPendingSpans[region];
+    clearPending(pending);
+    pending.ready = true;
+
+    // one section after the other, so each one's quads can be replaced on their own
+    MeshStats stats;
+    uint32_t quadCount = 0;
+    if (mMeshingMode == PERFACE)
+    {
+        // the face masks give the exact size up front, so write straight into staging memory
+        for (int section = 0; section < Dims::SECTIONCOUNT; section++)
+        {
+            const uint32_t faces = ChunkMesher<Dims>::regionHasSection(region, section) ? mesher.countFaces(region, section) : 0;
+            spans[section] = MeshSpan{ quadCount, faces, faces };
+            quadCount += faces;
+        }
+        if (quadCount == 0) return stats;
+
+        pending.staging = GraphicsEngine::createStagingBuffer(quadCount * 4 * sizeof(ChunkVertex));
+        ChunkVertex* out = static_cast<ChunkVertex*>(pending.staging.data);
+        for (int section = 0; section < Dims::SECTIONCOUNT; section++)
+            if (spans[section].quadCount)
+                stats += mesher.buildMesh(PERFACE, region, section, out + spans[section].first * 4);
+    }
+    else
+    {
+        // greedy quad counts are only known afterwards, mesh into scratch and copy once
+        for (int section = 0; section < Dims::SECTIONCOUNT; section++)
+        {
+            MeshStats built;
+            if (ChunkMesher<Dims>::regionHasSection(region, section))
+                built = mesher.buildMesh(GREEDY, region, section, scratch.vertices.data() + quadCount * 4);
+            spans[section] = MeshSpan{ quadCount, built.quadCount, built.quadCount };
+            quadCount += built.quadCount;
+            stats += built;
+        }
+        if (quadCount == 0) return stats;
+
+        pending.staging = GraphicsEngine::createStagingBuffer(stats.vertexBytes());
+        memcpy(pending.staging.data, scratch.vertices.data(), stats.vertexBytes());
+        stats.bytesCopied += stats.vertexBytes();
+    }
+
+    pending.quadCount = quadCount;
+    return stats;
+}
+
+template<typename Dims>
+bool BasicChunk<Dims>::updateRegion(MeshScratch<Dims>& scratch, int region, const std::bitset<Dims::SECTIONCOUNT>& sections, MeshStats& stats)
+{
+    constexpr VkDeviceSize QUADBYTES = 4 * sizeof(ChunkVertex);
+    const ChunkMesh& mesh = mMeshes[region];
+    const uint32_t capacity = static_cast<uint32_t>(mesh.vertexBuffer.capacity / QUADBYTES);
+    PendingMesh& pending = mPending[region];
+    std::array<MeshSpan, Dims::SECTIONCOUNT>& spans = mPendingSpans[region];
+    clearPending(pending);
+    spans = mSpans[region];
+
+    // the sections' new quads go to scratch one after the other, then to staging in one copy
+    uint32_t drawCount = mesh.quadCount;
+    MeshStats built;
+    for (int section = 0; section < Dims::SECTIONCOUNT; section++)
+    {
+        if (!sections[section] || !ChunkMesher<Dims>::regionHasSection(region, section)) continue;
+
+        const uint32_t staged = built.quadCount;
+        const uint32_t quadCount = scratch.mesher.buildMesh(mMeshingMode, region, section, scratch.vertices.data() + staged * 4).quadCount;
+        MeshSpan& span = spans[section];
+        if (quadCount > span.capacity)
+        {
+            // moved to the end of what is drawn, leaving its old quads degenerate
+            if (drawCount + quadCount > capacity) return false;
+            if (span.quadCount)
+                pending.clears.push_back({ span.first * QUADBYTES, span.quadCount * QUADBYTES });
+            span = MeshSpan{ drawCount, quadCount, 0 };
+            drawCount += quadCount;
+        }
+
+        if (quadCount)
+            pending.copies.push_back({ staged * QUADBYTES, span.first * QUADBYTES, quadCount * QUADBYTES });
+        if (span.quadCount > quadCount)
+            pending.clears.push_back({ (span.first + quadCount) * QUADBYTES, (span.quadCount - quadCount) * QUADBYTES });
+        span.quadCount = quadCount;
+        built.quadCount += quadCount;
+    }
+
+    // degenerate quads are drawn too, once they outnumber the others the region is rebuilt
+    uint32_t live = 0;
+    for (const MeshSpan& span : spans)
+        live += span.quadCount;
+    if (drawCount > 2 * live) return false;
+
+    if (built.quadCount)
+    {
+        pending.staging = GraphicsEngine::createStagingBuffer(built.vertexBytes());
+        memcpy(pending.staging.data, scratch.vertices.data(), built.vertexBytes());
+        built.bytesCopied += built.vertexBytes();
+    }
+    pending.quadCount = drawCount;
+    pending.partial = true;
+    pending.ready = true;
+    stats += built;
     return true;
 }
 
-uint8_t* ChunkData::getData()
+template<typename Dims>
+void BasicChunk<Dims>::uploadRegion(int region)
+{
+    PendingMesh& pending = mPending[region];
+    if (!pending.ready) return;
+
+    ChunkMesh& mesh = mMeshes[region];
+    if (pending.partial)
+        GraphicsEngine::updateVertexBuffer(pending.staging, mesh.vertexBuffer, pending.copies, pending.clears);
+    else
+    {
+        destroyMesh(mesh);
+        if (pending.staging.buffer != VK_NULL_HANDLE)
+            GraphicsEngine::uploadVertexBuffer(pending.staging, mesh.vertexBuffer);
+    }
+    mesh.quadCount = pending.quadCount;
+    mSpans[region] = mPendingSpans[region];
+
+    clearPending(pending);
+}
+
+template<typename Dims>
+void BasicChunk<Dims>::destroyMesh(ChunkMesh& mesh)
+{
+    GraphicsEngine::releaseVertexBuffer(mesh.vertexBuffer);
+    mesh.quadCount = 0;
+}
+
+static constexpr uint32_t getPaletteWords(uint32_t indexBits)
+{
+    return ((1u << indexBits) + 7) / 8;
+}
+
+static constexpr uint32_t getIndexWords(uint32_t indexBits)
+{
+    return SECTIONVOLUME * indexBits / 64;
+}
+
+// packs SECTIONVOLUME values, each looked up in remap, at a width known at compile time
+template<uint32_t INDEXBITS>
+static void packIndices(const uint8_t* values, const uint8_t* remap, uint64_t* indices)
+{
+    constexpr uint32_t PERWORD = 64 / INDEXBITS;
+    for (uint32_t word = 0; word < getIndexWords(INDEXBITS); word++)
+    {
+        uint64_t packed = 0;
+        for (uint32_t j = 0; j < PERWORD; j++)
+            packed |= static_cast<uint64_t>(remap[values[word * PERWORD + j]]) << (j * INDEXBITS);
+        indices[word] = packed;
+    }
+}
+
+static void packIndices(uint32_t indexBits, const uint8_t* values, const uint8_t* remap, uint64_t* indices)
+{
+    switch (indexBits)
+    {
+    case 1: packIndices<1>(values, remap, indices); break;
+    case 2: packIndices<2>(values, remap, indices); break;
+    case 4: packIndices<4>(values, remap, indices); break;
+    default: packIndices<8>(values, remap, indices); break;
+    }
+}
+
+static constexpr std::array<uint8_t, 256> IDENTITYREMAP = []
+{
+    std::array<uint8_t, 256> remap{};
+    for (int i = 0; i < 256; i++)
+        remap[i] = static_cast<uint8_t>(i);
+    return remap;
+}();
+
+// palette and indices, after the reference count word
+static constexpr uint32_t getStorageWords(uint32_t indexBits)
+{
+    return getPaletteWords(indexBits) + getIndexWords(indexBits);
+}
+
+// index storage for 1, 2, 4 and 8 bit wide indices
+static std::array<BlockPool, 4> sSectionPools = { {
+    BlockPool((1 + getStorageWords(1)) * sizeof(uint64_t)),
+    BlockPool((1 + getStorageWords(2)) * sizeof(uint64_t)),
+    BlockPool((1 + getStorageWords(4)) * sizeof(uint64_t)),
+    BlockPool((1 + getStorageWords(8)) * sizeof(uint64_t)),
+} };
+// handed out by all of sSectionPools together, and the most at once
+static std::atomic<size_t> sSectionLiveBytes{ 0 };
+static std::atomic<size_t> sSectionPeakBytes{ 0 };
+static std::atomic<uint64_t> sCopiesOnWrite{ 0 };
+// entries a section store holds before the first sweep, it sweeps again once it doubled
+static constexpr size_t SECTIONSTORE_MIN_SWEEP = 1024;
+
+template<typename Layout>
+struct BasicChunkSection<Layout>::Store
+{
+    std::mutex mutex;
+    std::unordered_multimap<uint64_t, StoreEntry> entries;
+    size_t sweepSize = SECTIONSTORE_MIN_SWEEP;
+    uint64_t interned = 0;
+    uint64_t hits = 0;
+
+    ~Store()
+    {
+        for (const auto& [hash, entry] : entries)
+            releaseStorage(entry.storage, entry.indexBits);
+    }
+};
+
+static uint64_t mixWord(uint64_t hash, uint64_t word)
+{
+    hash = (hash ^ word) * 0x9E3779B97F4A7C15ull;
+    return hash ^ (hash >> 32);
+}
+
+// hash of a section's storage words for its store, not cryptographic: the store
+// compares the words of every candidate. Four lanes over the indices, whose count is a
+// multiple of four, so the multiplies do not wait on each other
+static uint64_t hashStorage(const uint64_t* words, uint32_t paletteWords, uint32_t indexWords, uint64_t seed)
+{
+    std::array<uint64_t, 4> lanes = { seed, seed + 1, seed + 2, seed + 3 };
+    for (uint32_t i = 0; i < paletteWords; i++)
+        lanes[0] = mixWord(lanes[0], words[i]);
+
+    const uint64_t* indices = words + paletteWords;
+    for (uint32_t i = 0; i < indexWords; i += 4)
+        for (int lane = 0; lane < 4; lane++)
+            lanes[lane] = mixWord(lanes[lane], indices[i + lane]);
+
+    uint64_t hash = lanes[0];
+    for (int lane = 1; lane < 4; lane++)
+        hash = mixWord(hash, lanes[lane]);
+    return hash;
+}
+
+template<typename Layout>
+BasicChunkSection<Layout>::~BasicChunkSection()
+{
+    releaseStorage(mStorage, mIndexBits);
+}
+
+template<typename Layout>
+SECTIONTYPE BasicChunkSection<Layout>::getType() const
+{
+    return mType;
+}
+
+template<typename Layout>
+uint8_t BasicChunkSection<Layout>::getUniformBlock() const
+{
+    return mBlock;
+}
+
+template<typename Layout>
+uint8_t BasicChunkSection<Layout>::getBlock(int x, int y, int z) const
+{
+    if (mType != MIXED) return mBlock;
+    return getEntry(Layout::index(x, y, z));
+}
+
+template<typename Layout>
+void BasicChunkSection<Layout>::getRow(int x, int y, uint8_t* out) const
+{
+    if (mType != MIXED)
+        memset(out, mBlock, SECTIONSIZE);
+    else if constexpr (Layout::CONTIGUOUSAXIS == 2)
+        decodeRun(Layout::index(x, y, 0), out);
+    else
+        for (int z = 0; z < SECTIONSIZE; z++)
+            out[z] = getEntry(Layout::index(x, y, z));
+}
+
+template<typename Layout>
+void BasicChunkSection<Layout>::getColumn(int x, int z, uint8_t* out) const
+{
+    if (mType != MIXED)
+        memset(out, mBlock, SECTIONSIZE);
+    else if constexpr (Layout::CONTIGUOUSAXIS == 1)
+        decodeRun(Layout::index(x, 0, z), out);
+    else
+        for (int y = 0; y < SECTIONSIZE; y++)
+            out[y] = getEntry(Layout::index(x, y, z));
+}
+
+template<typename Layout>
+void BasicChunkSection<Layout>::getVoxels(uint8_t* out) const
+{
+    if (mType != MIXED)
+    {
+        memset(out, mBlock, SECTIONVOLUME);
+        return;
+    }
+    for (uint32_t i = 0; i < SECTIONVOLUME; i += SECTIONSIZE)
+        decodeRun(i, out + i);
+}
+
+template<typename Layout>
+void BasicChunkSection<Layout>::getPaletteIndices(uint8_t* out) const
+{
+    const uint64_t* indices = getIndices();
+    const uint32_t perWord = 64 / mIndexBits;
+    const uint64_t mask = (1ull << mIndexBits) - 1;
+    for (uint32_t word = 0; word < getIndexWords(mIndexBits); word++)
+        for (uint32_t j = 0; j < perWord; j++)
+            out[word * perWord + j] = static_cast<uint8_t>(indices[word] >> (j * mIndexBits) & mask);
+}
+
+template<typename Layout>
+uint8_t BasicChunkSection<Layout>::getPaletteEntry(uint32_t index) const
+{
+    return getPalette()[index];
+}
+
+template<typename Layout>
+uint32_t BasicChunkSection<Layout>::getIndexBits() const
+{
+    return mIndexBits;
+}
+
+template<typename Layout>
+uint32_t BasicChunkSection<Layout>::getPaletteSize() const
+{
+    return mPaletteSize;
+}
+
+template<typename Layout>
+void BasicChunkSection<Layout>::fill(uint8_t block)
+{
+    releaseStorage(mStorage, mIndexBits);
+    mStorage = nullptr;
+    mType = block == AIR ? EMPTY : UNIFORM;
+    mBlock = block;
+    mIndexBits = 0;
+    mPaletteSize = 0;
+}
+
+template<typename Layout>
+void BasicChunkSection<Layout>::assign(const uint8_t* voxels)
+{
+    // palette index per block type, in order of appearance
+    std::array<uint8_t, 256> remap;
+    std::array<uint8_t, 256> palette;
+    std::array<bool, 256> seen{};
+    uint32_t paletteSize = 0;
+    for (int i = 0; i < SECTIONVOLUME; i++)
+        if (!seen[voxels[i]])
+        {
+            seen[voxels[i]] = true;
+            remap[voxels[i]] = static_cast<uint8_t>(paletteSize);
+            palette[paletteSize++] = voxels[i];
+        }
+
+    if (paletteSize == 1)
+    {
+        fill(voxels[0]);
+        return;
+    }
+
+    uint32_t indexBits = 1;
+    while ((1u << indexBits) < paletteSize)
+        indexBits *= 2;
+
+    if (mType != MIXED || mIndexBits != indexBits || isShared())
+    {
+        releaseStorage(mStorage, mIndexBits);
+        mStorage = allocateStorage(indexBits);
+    }
+    mType = MIXED;
+    mBlock = AIR;
+    mIndexBits = static_cast<uint8_t>(indexBits);
+    mPaletteSize = static_cast<uint16_t>(paletteSize);
+    memcpy(getPalette(), palette.data(), paletteSize);
+
+    // the input is already in Layout order, packing is a straight pass
+    packIndices(indexBits, voxels, remap.data(), getIndices());
+}
+
+template<typename Layout>
+void BasicChunkSection<Layout>::assignPalette(const uint8_t* palette, uint32_t paletteSize, const uint8_t* indices)
+{
+    if (paletteSize == 1)
+    {
+        fill(palette[0]);
+        return;
+    }
+
+    uint32_t indexBits = 1;
+    while ((1u << indexBits) < paletteSize)
+        indexBits *= 2;
+
+    if (mType != MIXED || mIndexBits != indexBits || isShared())
+    {
+        releaseStorage(mStorage, mIndexBits);
+        mStorage = allocateStorage(indexBits);
+    }
+    mType = MIXED;
+    mBlock = AIR;
+    mIndexBits = static_cast<uint8_t>(indexBits);
+    mPaletteSize = static_cast<uint16_t>(paletteSize);
+    memcpy(getPalette(), palette, paletteSize);
+    packIndices(indexBits, indices, IDENTITYREMAP.data(), getIndices());
+}
+
+template<typename Layout>
+void BasicChunkSection<Layout>::setBlock(int x, int y, int z, uint8_t block)
+{
+    if (mType != MIXED)
+    {
+        if (block == mBlock) return;
+
+        // start with the current block as entry 0, which every index already points at
+        const uint8_t previous = mBlock;
+        mStorage = allocateStorage(1);
+        mType = MIXED;
+        mIndexBits = 1;
+        mPaletteSize = 1;
+        getPalette()[0] = previous;
+    }
+    else
+        unshare();
+
+    const uint64_t entry = findOrAddPaletteEntry(block);
+    const uint32_t i = Layout::index(x, y, z);
+    const uint32_t perWord = 64 / mIndexBits;
+    const uint32_t shift = i % perWord * mIndexBits;
+    const uint64_t mask = (1ull << mIndexBits) - 1;
+
+    uint64_t& word = getIndices()[i / perWord];
+    word = (word & ~(mask << shift)) | (entry << shift);
+}
+
+template<typename Layout>
+void BasicChunkSection<Layout>::share(const BasicChunkSection& other)
+{
+    if (this == &other) return;
+
+    if (other.mStorage)
+        std::atomic_ref<uint64_t>(other.mStorage[-1]).fetch_add(1, std::memory_order_relaxed);
+    releaseStorage(mStorage, mIndexBits);
+    mType = other.mType;
+    mBlock = other.mBlock;
+    mIndexBits = other.mIndexBits;
+    mPaletteSize = other.mPaletteSize;
+    mStorage = other.mStorage;
+}
+
+template<typename Layout>
+bool BasicChunkSection<Layout>::isShared() const
 {
-    return pData;
+    // acquire pairs with the release of the last other section, so its reads are done before we write
+    return mStorage && std::atomic_ref<uint64_t>(mStorage[-1]).load(std::memory_order_acquire) > 1;
 }
 
-bool ChunkData::isFaceVisible(glm::ivec3 blockPos, BLOCKFACE face)
+template<typename Layout>
+size_t BasicChunkSection<Layout>::getMemoryUsage() const
+{
+    return sizeof(BasicChunkSection) + (mStorage ? (1 + getStorageWords(mIndexBits)) * sizeof(uint64_t) : 0);
+}
+
+template<typename Layout>
+PoolStats BasicChunkSection<Layout>::getPoolStats()
+{
+    PoolStats stats;
+    for (const BlockPool& pool : sSectionPools)
+        stats += pool.getStats();
+    stats.peakBytes = sSectionPeakBytes.load(std::memory_order_relaxed);
+    return stats;
+}
+
+template<typename Layout>
+uint64_t BasicChunkSection<Layout>::getCopyOnWriteCount()
+{
+    return sCopiesOnWrite.load(std::memory_order_relaxed);
+}
+
+template<typename Layout>
+void BasicChunkSection<Layout>::intern()
+{
+    if (mType != MIXED) return;
+
+    const uint32_t words = getStorageWords(mIndexBits);
+    const uint64_t hash = hashStorage(mStorage, getPaletteWords(mIndexBits), getIndexWords(mIndexBits), mIndexBits | static_cast<uint64_t>(mPaletteSize) << 8);
+
+    Store& store = getStore();
+    std::lock_guard<std::mutex> lock(store.mutex);
+    store.interned++;
+    auto [first, last] = store.entries.equal_range(hash);
+    for (auto it = first; it != last; it++)
+    {
+        const StoreEntry& entry = it->second;
+        if (entry.storage == mStorage) return;
+        if (entry.indexBits != mIndexBits || entry.paletteSize != mPaletteSize || memcmp(entry.storage, mStorage, words * sizeof(uint64_t)) != 0)
+            continue;
+
+        // nothing writes storage that is shared, and the store's reference keeps it shared
+        std::atomic_ref<uint64_t>(entry.storage[-1]).fetch_add(1, std::memory_order_relaxed);
+        releaseStorage(mStorage, mIndexBits);
+        mStorage = entry.storage;
+        store.hits++;
+        return;
+    }
+
+    std::atomic_ref<uint64_t>(mStorage[-1]).fetch_add(1, std::memory_order_relaxed);
+    store.entries.emplace(hash, StoreEntry{ mStorage, mIndexBits, mPaletteSize });
+    if (store.entries.size() >= store.sweepSize)
+    {
+        sweepStore(store);
+        store.sweepSize = std::max(SECTIONSTORE_MIN_SWEEP, store.entries.size() * 2);
+    }
+}
+
+template<typename Layout>
+SectionStoreStats BasicChunkSection<Layout>::getStoreStats()
+{
+    Store& store = getStore();
+    std::lock_guard<std::mutex> lock(store.mutex);
+
+    SectionStoreStats stats;
+    stats.interned = store.interned;
+    stats.hits = store.hits;
+    for (const auto& [hash, entry] : store.entries)
+    {
+        // the store's own reference does not count, entries without others wait for a sweep
+        const uint64_t references = std::atomic_ref<uint64_t>(entry.storage[-1]).load(std::memory_order_relaxed) - 1;
+        if (references == 0) continue;
+
+        const size_t bytes = sSectionPools[std::countr_zero(static_cast<uint32_t>(entry.indexBits))].getBlockSize();
+        stats.unique++;
+        stats.references += references;
+        stats.uniqueBytes += bytes;
+        stats.referencedBytes += references * bytes;
+    }
+    // a node per entry with its link and cached hash, and a pointer per bucket
+    stats.storeBytes = store.entries.size() * (sizeof(typename decltype(store.entries)::value_type) + 2 * sizeof(void*)) + store.entries.bucket_count() * sizeof(void*);
+    return stats;
+}
+
+template<typename Layout>
+typename BasicChunkSection<Layout>::Store& BasicChunkSection<Layout>::getStore()
+{
+    // constructed after the pools, so destroyed before them
+    static Store store;
+    return store;
+}
+
+template<typename Layout>
+void BasicChunkSection<Layout>::sweepStore(Store& store)
+{
+    std::erase_if(store.entries, [](const auto& item)
+    {
+        const StoreEntry& entry = item.second;
+        // no section holds it, so none can share it again before it is gone
+        if (std::atomic_ref<uint64_t>(entry.storage[-1]).load(std::memory_order_acquire) > 1) return false;
+        releaseStorage(entry.storage, entry.indexBits);
+        return true;
+    });
+}
+
+template<typename Layout>
+uint64_t* BasicChunkSection<Layout>::allocateStorage(uint32_t indexBits)
+{
+    BlockPool& pool = sSectionPools[std::countr_zero(indexBits)];
+    uint64_t* block = static_cast<uint64_t*>(pool.allocate());
+    block[0] = 1;
+
+    const size_t live = sSectionLiveBytes.fetch_add(pool.getBlockSize(), std::memory_order_relaxed) + pool.getBlockSize();
+    size_t peak = sSectionPeakBytes.load(std::memory_order_relaxed);
+    while (live > peak && !sSectionPeakBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {}
+    memset(block + 1, 0, getStorageWords(indexBits) * sizeof(uint64_t));
+    return block + 1;
+}
+
+template<typename Layout>
+void BasicChunkSection<Layout>::releaseStorage(uint64_t* storage, uint32_t indexBits)
+{
+    if (storage && std::atomic_ref<uint64_t>(storage[-1]).fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+        BlockPool& pool = sSectionPools[std::countr_zero(indexBits)];
+        sSectionLiveBytes.fetch_sub(pool.getBlockSize(), std::memory_order_relaxed);
+        pool.free(storage - 1);
+    }
+}
+
+template<typename Layout>
+void BasicChunkSection<Layout>::unshare()
+{
+    if (!isShared()) return;
+
+    uint64_t* storage = allocateStorage(mIndexBits);
+    memcpy(storage, mStorage, getStorageWords(mIndexBits) * sizeof(uint64_t));
+    releaseStorage(mStorage, mIndexBits);
+    mStorage = storage;
+    sCopiesOnWrite.fetch_add(1, std::memory_order_relaxed);
+}
+
+template<typename Layout>
+uint8_t* BasicChunkSection<Layout>::getPalette() const
+{
+    return reinterpret_cast<uint8_t*>(mStorage);
+}
+
+template<typename Layout>
+uint64_t* BasicChunkSection<Layout>::getIndices() const
+{
+    return mStorage + getPaletteWords(mIndexBits);
+}
+
+template<typename Layout>
+uint8_t BasicChunkSection<Layout>::getEntry(uint32_t i) const
+{
+    const uint32_t perWord = 64 / mIndexBits;
+    const uint64_t mask = (1ull << mIndexBits) - 1;
+    return getPalette()[(getIndices()[i / perWord] >> (i % perWord * mIndexBits)) & mask];
+}
+
+template<typename Layout>
+void BasicChunkSection<Layout>::decodeRun(uint32_t i, uint8_t* out) const
+{
+    // SECTIONSIZE indices are one word at up to 4 bits and two at 8, so the run
+    // decodes with shifts and a single load per word
+    const uint8_t* palette = getPalette();
+    const uint32_t firstBit = i * mIndexBits;
+    const uint64_t* words = getIndices() + firstBit / 64;
+    const uint64_t mask = (1ull << mIndexBits) - 1;
+
+    uint64_t word = *words >> (firstBit % 64);
+    for (int j = 0; j < SECTIONSIZE; j++)
+    {
+        out[j] = palette[word & mask];
+        word >>= mIndexBits;
+        if ((j + 1) * mIndexBits % 64 == 0 && j + 1 < SECTIONSIZE)
+            word = *++words;
+    }
+}
+
+template<typename Layout>
+uint32_t BasicChunkSection<Layout>::findOrAddPaletteEntry(uint8_t block)
+{
+    const uint8_t* palette = getPalette();
+    for (uint32_t i = 0; i < mPaletteSize; i++)
+        if (palette[i] == block)
+            return i;
+
+    if (mPaletteSize == (1u << mIndexBits))
+        resize(mIndexBits * 2);
+
+    getPalette()[mPaletteSize] = block;
+    return mPaletteSize++;
+}
+
+template<typename Layout>
+void BasicChunkSection<Layout>::resize(uint32_t indexBits)
+{
+    uint64_t* storage = allocateStorage(indexBits);
+    memcpy(storage, getPalette(), mPaletteSize);
+
+    const uint64_t* oldIndices = getIndices();
+    uint64_t* newIndices = storage + getPaletteWords(indexBits);
+    const uint32_t oldPerWord = 64 / mIndexBits;
+    const uint32_t newPerWord = 64 / indexBits;
+    const uint64_t oldMask = (1ull << mIndexBits) - 1;
+
+    for (uint32_t i = 0; i < SECTIONVOLUME; i++)
+    {
+        const uint64_t entry = (oldIndices[i / oldPerWord] >> (i % oldPerWord * mIndexBits)) & oldMask;
+        newIndices[i / newPerWord] |= entry << (i % newPerWord * indexBits);
+    }
+
+    releaseStorage(mStorage, mIndexBits);
+    mStorage = storage;
+    mIndexBits = static_cast<uint8_t>(indexBits);
+}
+
+template class BasicChunkSection<LinearLayout<SECTIONSIZE>>;
+template class BasicChunkSection<ColumnLayout<SECTIONSIZE>>;
+template class BasicChunkSection<MortonLayout<SECTIONSIZE>>;
+
+template<typename Dims>
+const ChunkSection& BasicChunkData<Dims>::getSection(int section) const
+{
+    return mSections[section];
+}
+
+template<typename Dims>
+const ChunkSection& BasicChunkData<Dims>::getSection(int sectionX, int sectionY, int sectionZ) const
+{
+    return mSections[Dims::sectionIndex(sectionX, sectionY, sectionZ)];
+}
+
+template<typename Dims>
+ChunkSection& BasicChunkData<Dims>::getSection(int sectionX, int sectionY, int sectionZ)
+{
+    return mSections[Dims::sectionIndex(sectionX, sectionY, sectionZ)];
+}
+
+template<typename Dims>
+uint8_t BasicChunkData<Dims>::getBlock(glm::ivec3 blockPos) const
+{
+    if (blockPos.x < 0 || blockPos.x >= Dims::SIZE || blockPos.y < 0 || blockPos.y >= Dims::HEIGHT || blockPos.z < 0 || blockPos.z >= Dims::SIZE)
+        return AIR;
+    return getSection(blockPos.x / SECTIONSIZE, blockPos.y / SECTIONSIZE, blockPos.z / SECTIONSIZE)
+        .getBlock(blockPos.x % SECTIONSIZE, blockPos.y % SECTIONSIZE, blockPos.z % SECTIONSIZE);
+}
+
+template<typename Dims>
+void BasicChunkData<Dims>::setBlock(glm::ivec3 blockPos, uint8_t block)
+{
+    if (blockPos.x < 0 || blockPos.x >= Dims::SIZE || blockPos.y < 0 || blockPos.y >= Dims::HEIGHT || blockPos.z < 0 || blockPos.z >= Dims::SIZE)
+        return;
+    getSection(blockPos.x / SECTIONSIZE, blockPos.y / SECTIONSIZE, blockPos.z / SECTIONSIZE)
+        .setBlock(blockPos.x % SECTIONSIZE, blockPos.y % SECTIONSIZE, blockPos.z % SECTIONSIZE, block);
+}
+
+template<typename Dims>
+size_t BasicChunkData<Dims>::getMemoryUsage() const
+{
+    size_t bytes = sizeof(mSurface) + sizeof(mBiomes);
+    for (const ChunkSection& section : mSections)
+        bytes += section.getMemoryUsage();
+    return bytes;
+}
+
+template<typename Dims>
+bool BasicChunkData<Dims>::isFaceVisible(glm::ivec3 blockPos, BLOCKFACE face)
 {
 
     // FRONT = Z-
@@ -189,38 +1091,60 @@ bool ChunkData::isFaceVisible(glm::ivec3 blockPos, BLOCKFACE face)
     // RIGHT = X+
     // BOTTOM = Y+
     // TOP = Y-
-    int idx = 0;
-    switch (face)
-    {
-    case FRONT:
-        idx = getBlockIndex({ blockPos.x, blockPos.y, blockPos.z - 1 });
-        break;
-    case BACK:
-        idx = getBlockIndex({ blockPos.x, blockPos.y, blockPos.z + 1 });
-        break;
-    case LEFT:
-        idx = getBlockIndex({ blockPos.x - 1, blockPos.y, blockPos.z });
-        break;
-    case RIGHT:
-        idx = getBlockIndex({ blockPos.x + 1, blockPos.y, blockPos.z });
-        break;
-    case BOTTOM:
-        idx = getBlockIndex({ blockPos.x, blockPos.y + 1, blockPos.z });
-        break;
-    case TOP:
-        idx = getBlockIndex({ blockPos.x, blockPos.y - 1, blockPos.z });
-        break;
-    }
-    if (idx < 0 || idx >= CHUNKHEIGHT * CHUNKSIZE * CHUNKSIZE) return true; // if out of array bounds
-    
-    if (pData[idx] == AIR) return true;
-
-    return false;
+    static const glm::ivec3 offsets[6] = { { 0, 0, -1 }, { 0, 0, 1 }, { 1, 0, 0 }, { -1, 0, 0 }, { 0, -1, 0 }, { 0, 1, 0 } };
+    // out of bounds counts as air
+    return !isBlockOpaque(getBlock(blockPos + offsets[face]));
 }
 
-int ChunkData::getBlockIndex(glm::ivec3 blockCoords)
+template<typename Dims>
+int BasicChunkData<Dims>::getBlockIndex(glm::ivec3 blockCoords)
 {
-    if (blockCoords.x >= CHUNKSIZE || blockCoords.x < 0 || blockCoords.y >= CHUNKHEIGHT || blockCoords.y < 0 || blockCoords.z >= CHUNKSIZE || blockCoords.z < 0)
+    if (blockCoords.x >= Dims::SIZE || blockCoords.x < 0 || blockCoords.y >= Dims::HEIGHT || blockCoords.y < 0 || blockCoords.z >= Dims::SIZE || blockCoords.z < 0)
         return -1;
-    return blockCoords.x * CHUNKHEIGHT * CHUNKSIZE + blockCoords.y * CHUNKSIZE + blockCoords.z;
+    const int section = Dims::sectionIndex(blockCoords.x / SECTIONSIZE, blockCoords.y / SECTIONSIZE, blockCoords.z / SECTIONSIZE);
+    return section * SECTIONVOLUME + SectionLayout::index(blockCoords.x % SECTIONSIZE, blockCoords.y % SECTIONSIZE, blockCoords.z % SECTIONSIZE);
+}
+
+template<typename Dims>
+int BasicChunkData<Dims>::getSurface(int x, int z) const
+{
+    return mSurface[x * Dims::SIZE + z];
+}
+
+template<typename Dims>
+uint8_t BasicChunkData<Dims>::getBiome(int x, int z) const
+{
+    return mBiomes[x * Dims::SIZE + z];
 }
+
+template<typename Dims>
+void BasicChunkData<Dims>::setColumn(int x, int z, int surface, uint8_t biome)
+{
+    mSurface[x * Dims::SIZE + z] = static_cast<int16_t>(surface);
+    mBiomes[x * Dims::SIZE + z] = biome;
+}
+
+template<typename Dims>
+void BasicChunkData<Dims>::share(const BasicChunkData& other)
+{
+    for (int i = 0; i < Dims::SECTIONCOUNT; i++)
+        mSections[i].share(other.mSections[i]);
+    mSurface = other.mSurface;
+    mBiomes = other.mBiomes;
+}
+
+template<typename Dims>
+void BasicChunkData<Dims>::deduplicate()
+{
+    for (ChunkSection& section : mSections)
+        section.intern();
+}
+
+template class BasicChunkData<ChunkDimensions<16, 64>>;
+template class BasicChunkData<ChunkDimensions<16, 256>>;
+template class BasicChunkData<ChunkDimensions<32, 64>>;
+template class BasicChunkData<ChunkDimensions<32, 384>>;
+template class BasicChunk<ChunkDimensions<16, 64>>;
+template class BasicChunk<ChunkDimensions<16, 256>>;
+template class BasicChunk<ChunkDimensions<32, 64>>;
+template class BasicChunk<ChunkDimensions<32, 384>>;
\ No newline at end of file
@@ -1,85 +1,460 @@
 #pragma once
 #include <vulkan/vulkan.h>
 #include <vector>
+#include <array>
+#include <atomic>
+#include <bitset>
+#include <memory>
+#include <ostream>
 #include <glm/glm.hpp>
 #include "structs.h"
+#include "MemoryPool.h"
+#include "VoxelLayout.h"
+#include "BlockRegistry.h"
+#include "Epoch.h"
 
-constexpr unsigned short int CHUNKSIZE = 16;
-constexpr unsigned short int CHUNKHEIGHT = 64;
+// chunks are stored as a grid of cubic sections
+constexpr unsigned short int SECTIONSIZE = 16;
+constexpr int SECTIONVOLUME = SECTIONSIZE * SECTIONSIZE * SECTIONSIZE;
+// voxel order inside a section, see VoxelLayout.h
+using SectionLayout = LinearLayout<SECTIONSIZE>;
+// whether the ChunkManager interns the sections of the chunks it generates and reads,
+// see BasicChunkSection::intern. Worth it for worlds whose sections repeat; the noise
+// terrain's MIXED sections almost never do and the store costs more than it saves,
+// see --benchmark-dedup
+constexpr bool SECTION_DEDUPLICATION = false;
 
-enum BLOCKTYPE {
-	AIR, GRASS, DIRT, STONE
+// Width and height of a chunk, in blocks. ChunkData, Chunk and the mesher are
+// templates on this so every shape gets its own code with constant loop bounds
+// and strides; the shapes in use are instantiated in World.cpp and Mesher.cpp.
+template<int SIZE_, int HEIGHT_>
+struct ChunkDimensions
+{
+	static constexpr int SIZE = SIZE_;
+	static constexpr int HEIGHT = HEIGHT_;
+	// sections along x and z, and along y
+	static constexpr int SECTIONSXZ = SIZE / SECTIONSIZE;
+	static constexpr int SECTIONSY = HEIGHT / SECTIONSIZE;
+	static constexpr int SECTIONCOUNT = SECTIONSXZ * SECTIONSXZ * SECTIONSY;
+	// worst case is a checkerboard: half the blocks solid with all six faces visible
+	static constexpr uint32_t MAXQUADS = SIZE * HEIGHT * SIZE / 2 * 6;
+
+	static_assert(SIZE % SECTIONSIZE == 0 && HEIGHT % SECTIONSIZE == 0, "chunks must split into whole sections");
+	static_assert(SIZE < 256 && HEIGHT < 65536, "block corners must fit ChunkVertex");
+
+	// layer by layer, so the sections of a band are contiguous
+	static constexpr int sectionIndex(int sectionX, int sectionY, int sectionZ)
+	{
+		return (sectionY * SECTIONSXZ + sectionX) * SECTIONSXZ + sectionZ;
+	}
+	// the section coordinates of a sectionIndex
+	static glm::ivec3 sectionPosition(int section)
+	{
+		return glm::ivec3(section / SECTIONSXZ % SECTIONSXZ, section / (SECTIONSXZ * SECTIONSXZ), section % SECTIONSXZ);
+	}
 };
-enum BLOCKFACE {
-	FRONT, BACK, RIGHT, LEFT, TOP, BOTTOM
+
+// the shape the game streams and renders
+using WorldDimensions = ChunkDimensions<16, 64>;
+constexpr unsigned short int CHUNKSIZE = WorldDimensions::SIZE;
+constexpr unsigned short int CHUNKHEIGHT = WorldDimensions::HEIGHT;
+
+enum MESHINGMODE {
+	PERFACE, // one quad per visible block face
+	GREEDY   // coplanar faces with the same texture merged into larger quads
 };
 
+enum SECTIONTYPE {
+	EMPTY,   // all air, nothing stored
+	UNIFORM, // a single non-air block type, nothing stored
+	MIXED    // palette and bit-packed indices
+};
+
+// the content-addressed store of MIXED section storage, see BasicChunkSection::intern
+struct SectionStoreStats
+{
+	// intern calls on MIXED sections, and those that found an identical section's storage
+	uint64_t interned = 0;
+	uint64_t hits = 0;
+	// distinct storage blocks in the store, the sections sharing them (snapshots and
+	// published versions included) and their bytes, once and as if every section had its own
+	uint64_t unique = 0;
+	uint64_t references = 0;
+	size_t uniqueBytes = 0;
+	size_t referencedBytes = 0;
+	// the store's own table, roughly
+	size_t storeBytes = 0;
+};
 
-static uint8_t getBlockTextureIndex(BLOCKTYPE bType, BLOCKFACE bFace)
+// SECTIONSIZE cube of a chunk. MIXED sections store a palette of the block types
+// present and one index into it per voxel, packed 1, 2, 4 or 8 bits wide so an
+// index never straddles a 64-bit word. The width grows as blocks are added.
+// Sections can share their storage, see share: the first change to a shared
+// section copies it, so snapshots cost nothing until the world is edited. Identical
+// sections of different chunks share it too once interned.
+// Layout orders the voxels, instantiated in World.cpp for the layouts in VoxelLayout.h.
+template<typename Layout>
+class BasicChunkSection
 {
-	switch (bType)
+public:
+	BasicChunkSection() = default;
+	~BasicChunkSection();
+
+	BasicChunkSection(const BasicChunkSection&) = delete;
+	BasicChunkSection& operator=(const BasicChunkSection&) = delete;
+
+	SECTIONTYPE getType() const;
+	// the block filling an EMPTY or UNIFORM section
+	uint8_t getUniformBlock() const;
+	uint8_t getBlock(int x, int y, int z) const;
+	// decode the SECTIONSIZE blocks along z of row (x, y) or along y of column (x, z)
+	// into out, fastest along Layout's contiguous axis
+	void getRow(int x, int y, uint8_t* out) const;
+	void getColumn(int x, int z, uint8_t* out) const;
+	// decode all SECTIONVOLUME voxels into out in Layout order, the inverse of assign
+	void getVoxels(uint8_t* out) const;
+	// MIXED only: the palette index of all SECTIONVOLUME voxels in Layout order, and
+	// the block of a palette entry. The palette may hold blocks no voxel uses anymore
+	void getPaletteIndices(uint8_t* out) const;
+	uint8_t getPaletteEntry(uint32_t index) const;
+	// bits per voxel index, 0 unless MIXED
+	uint32_t getIndexBits() const;
+	uint32_t getPaletteSize() const;
+
+	void fill(uint8_t block);
+	// packs SECTIONVOLUME voxels given in Layout order, a single block type becomes EMPTY or UNIFORM
+	void assign(const uint8_t* voxels);
+	// the same from palette indices into palette, which must not list a block twice;
+	// a palette of one block becomes EMPTY or UNIFORM
+	void assignPalette(const uint8_t* palette, uint32_t paletteSize, const uint8_t* indices);
+	void setBlock(int x, int y, int z, uint8_t block);
+	// makes this section the same as other, sharing its storage until either changes.
+	// Other may be read meanwhile but not changed
+	void share(const BasicChunkSection& other);
+	// MIXED only: shares the storage of an identical section interned before, looked up
+	// by a hash of the palette and indices, or interns this one's. The store keeps a
+	// reference, so interned storage is always shared and the first change copies it.
+	// Thread-safe across sections, the section itself must not be read meanwhile
+	void intern();
+	bool isShared() const;
+	size_t getMemoryUsage() const;
+
+	// storage of every MIXED section, one block pool per index width
+	static PoolStats getPoolStats();
+	// shared storage copied because a section sharing it was changed
+	static uint64_t getCopyOnWriteCount();
+	// of this Layout's store, walks it
+	static SectionStoreStats getStoreStats();
+private:
+	struct StoreEntry
 	{
-	case GRASS:
-		switch (bFace)
-		{
-		case TOP:
-			return 0;
-		case BOTTOM:
-			return 2;
-		default:
-			return 1;
-		}
-		break;
-	case DIRT:
-		return 2;
-		break;
-	case STONE:
-		return 3;
-	default:
-		return 99;
-	}
-}
-class ChunkData
+		uint64_t* storage;
+		uint8_t indexBits;
+		uint16_t paletteSize;
+	};
+	// interned storage by content hash, one store per Layout as the same words are
+	// different voxels in another order
+	struct Store;
+	static Store& getStore();
+	// drops the entries only the store references anymore, store mutex held
+	static void sweepStore(Store& store);
+	// zeroed palette and index storage for indexBits wide indices from the pools,
+	// preceded by the count of sections sharing it
+	static uint64_t* allocateStorage(uint32_t indexBits);
+	// frees the storage once no other section shares it
+	static void releaseStorage(uint64_t* storage, uint32_t indexBits);
+	// gives the section storage of its own before it is changed
+	void unshare();
+	uint8_t* getPalette() const;
+	uint64_t* getIndices() const;
+	uint8_t getEntry(uint32_t i) const;
+	// SECTIONSIZE consecutive voxels starting at i, a multiple of SECTIONSIZE
+	void decodeRun(uint32_t i, uint8_t* out) const;
+	uint32_t findOrAddPaletteEntry(uint8_t block);
+	// repacks the indices at a new width, keeping the palette
+	void resize(uint32_t indexBits);
+private:
+	SECTIONTYPE mType = EMPTY;
+	uint8_t mBlock = AIR;
+	uint8_t mIndexBits = 0;
+	uint16_t mPaletteSize = 0;
+	// palette (1 << mIndexBits entries, padded to whole words) followed by the indices
+	uint64_t* mStorage = nullptr;
+};
+
+extern template class BasicChunkSection<LinearLayout<SECTIONSIZE>>;
+extern template class BasicChunkSection<ColumnLayout<SECTIONSIZE>>;
+extern template class BasicChunkSection<MortonLayout<SECTIONSIZE>>;
+
+using ChunkSection = BasicChunkSection<SectionLayout>;
+
+template<typename Dims>
+class BasicChunkData
 {
 public:
-	ChunkData();
-	~ChunkData();
+	BasicChunkData() = default;
 
-	ChunkData(const ChunkData&) = delete;
-	ChunkData& operator=(const ChunkData&) = delete;
+	BasicChunkData(const BasicChunkData&) = delete;
+	BasicChunkData& operator=(const BasicChunkData&) = delete;
 
-	bool allocateChunkData();
-	uint8_t* getData();
+	// indexed by Dims::sectionIndex
+	const ChunkSection& getSection(int section) const;
+	const ChunkSection& getSection(int sectionX, int sectionY, int sectionZ) const;
+	ChunkSection& getSection(int sectionX, int sectionY, int sectionZ);
+	// AIR outside the chunk
+	uint8_t getBlock(glm::ivec3 blockPos) const;
+	// ignored outside the chunk
+	void setBlock(glm::ivec3 blockPos, uint8_t block);
 	bool isFaceVisible(glm::ivec3 blockPos, BLOCKFACE face);
+	// section * SECTIONVOLUME plus the SectionLayout index inside it, -1 outside the chunk
 	int getBlockIndex(glm::ivec3 blockCoords);
+	size_t getMemoryUsage() const;
+
+	// depth of the surface block and the biome of block column (x, z), written by
+	// the world generator's first stage and read by later ones, also the neighbours'
+	int getSurface(int x, int z) const;
+	uint8_t getBiome(int x, int z) const;
+	void setColumn(int x, int z, int surface, uint8_t biome);
+	// a copy-on-write copy of other, see BasicChunkSection::share
+	void share(const BasicChunkData& other);
+	// interns every MIXED section, see BasicChunkSection::intern
+	void deduplicate();
 private:
-	uint8_t* pData;
+	std::array<ChunkSection, Dims::SECTIONCOUNT> mSections;
+	// indexed x * Dims::SIZE + z
+	std::array<int16_t, Dims::SIZE * Dims::SIZE> mSurface{};
+	std::array<uint8_t, Dims::SIZE * Dims::SIZE> mBiomes{};
+};
+
+// An immutable version of a chunk's data, published by BasicChunk::publish for other
+// threads to read. Its sections share their storage with the chunk's, so publishing
+// copies no voxels: the chunk copies a section when it next changes it instead, and
+// only the changed sections get new storage in the next version. Load it under a
+// guard of EpochDomain::get(), which keeps it alive after a newer one replaced it.
+template<typename Dims>
+struct ChunkVersion
+{
+	// counts the chunk's versions from 1
+	uint64_t version = 0;
+	// the version that last changed each section, by Dims::sectionIndex
+	std::array<uint64_t, Dims::SECTIONCOUNT> sectionVersions{};
+	BasicChunkData<Dims> data;
+};
+
+// the four horizontal chunk borders (FRONT, BACK, RIGHT, LEFT) are meshed on
+// their own so a neighbour loading or unloading only remeshes the border facing it
+constexpr int BORDERMESHES = 4;
+constexpr int INTERIORMESH = BORDERMESHES;
+constexpr int MESHREGIONS = BORDERMESHES + 1;
+constexpr uint32_t ALLREGIONS = (1u << MESHREGIONS) - 1;
+// once more than this share of a chunk's sections is marked, its regions are rebuilt
+// whole: past about half, replacing the sections one by one takes longer
+constexpr int REMESH_REBUILD_PERCENT = 50;
+
+constexpr uint32_t MAXCHUNKQUADS = WorldDimensions::MAXQUADS;
+
+// what BasicChunk::buildMesh built, summed over every chunk of any shape
+struct ChunkMeshStats
+{
+	// chunks meshed whole, and borders or marked sections rebuilt on their own
+	uint64_t wholeMeshes = 0;
+	uint64_t partialMeshes = 0;
+	// of the whole meshes: the quads built and the faces per-face meshing would draw
+	uint64_t quads = 0;
+	uint64_t faces = 0;
+	uint64_t allocations = 0;
+	uint64_t bytesCopied = 0;
+	// time spent building, in milliseconds
+	double wholeMs = 0.0;
+	double partialMs = 0.0;
 };
 
-class Chunk
+template<typename Dims> struct PaddedChunk;
+template<typename Dims> struct MeshScratch;
+struct MeshStats;
+template<typename Dims> class ChunkMesher;
+
+// GPU side of one mesh region, the CPU copy is dropped once uploaded
+struct ChunkMesh
+{
+	uint32_t quadCount = 0;
+	PooledBuffer vertexBuffer;
+};
+
+// where the quads of one section lie in its region's vertex buffer, in quads. An edit
+// rebuilds them in place while they fit the span, else at the end of the buffer
+struct MeshSpan
+{
+	uint32_t first = 0;
+	uint32_t capacity = 0;
+	uint32_t quadCount = 0;
+};
+
+// a freshly built region waiting in host memory for the render thread to upload it
+struct PendingMesh
+{
+	StagingBuffer staging; // empty when the region has no quads
+	uint32_t quadCount = 0;
+	bool ready = false;
+	// an update of the uploaded buffer instead of a new one: copies take the quads of
+	// the rebuilt sections from staging, clears zero quads no section uses anymore,
+	// which leaves them degenerate
+	bool partial = false;
+	std::vector<VkBufferCopy> copies;
+	std::vector<BufferRange> clears;
+};
+
+template<typename Dims>
+class BasicChunk
 {
 public:
-	Chunk(glm::ivec2 aWorldPos);
-	Chunk() = default;
+	BasicChunk(glm::ivec2 aWorldPos);
+	BasicChunk() = default;
 
-	~Chunk();
+	~BasicChunk();
 
-	Chunk(const Chunk&) = delete;
-	Chunk& operator=(const Chunk&) = delete;
+	BasicChunk(const BasicChunk&) = delete;
+	BasicChunk& operator=(const BasicChunk&) = delete;
 
-	void generateMesh();
-	void Render(VkCommandBuffer commandBuffer);
+	// prepareMesh publishes the chunk's and the linked neighbours' data, pins those
+	// versions and takes the regions and sections marked so far, on the render thread.
+	// buildMesh then meshes them on any thread while the render thread goes on editing
+	// and marking the chunk, it only touches CPU and staging memory and the pinned
+	// versions; uploadMesh has to run on the render thread again. Regions are rebuilt
+	// whole the first time, when a neighbour comes or goes and when edits marked more
+	// than REMESH_REBUILD_PERCENT of the sections, otherwise only the marked sections
+	// are, and uploaded into the region's buffer in place
+	void prepareMesh(MESHINGMODE mode = GREEDY);
+	// prepares a GREEDY mesh first if prepareMesh was not called
+	void buildMesh();
+	void uploadMesh();
+	// prepareMesh, buildMesh and uploadMesh in one go
+	void generateMesh(MESHINGMODE mode = GREEDY);
+	// makes the sections changed since the last version visible to readers, the first
+	// version has all of them. Render thread only, and a no-op without changes
+	void publish();
+	// the newest published version, nullptr before the first. Any thread, under a guard
+	// of EpochDomain::get() pinned before the call
+	const ChunkVersion<Dims>* getPublished() const;
+	// links a neighbour and marks the border facing it for the next buildMesh
+	void setNeighbour(BLOCKFACE side, BasicChunk* neighbour);
+	BasicChunk* getNeighbour(BLOCKFACE side) const;
+	// sets a block of the data and marks the sections whose faces it may change for the
+	// next buildMesh, in the linked neighbours too, and the section for the next publish.
+	// Returns a bit per BLOCKFACE of the neighbours marked, nothing is marked if the
+	// block was there already
+	uint32_t setBlock(glm::ivec3 blockPos, uint8_t block);
+	// marks a section, by Dims::sectionIndex, for the next buildMesh
+	void markSection(int section);
+	// whether buildMesh has regions or sections to (re)build
+	bool needsMesh() const;
+	void Render(VkCommandBuffer commandBuffer, VkPipelineLayout pipelineLayout);
 	glm::ivec2 getPosition() const;
+	// the render thread's working copy. Changes through it after the first publish are
+	// not published, those go through setBlock
+	BasicChunkData<Dims>& getData();
+	const BasicChunkData<Dims>& getData() const;
+	// releases the meshes and the published version and readies the chunk, and its
+	// ChunkData, for another position
+	void reset(glm::ivec2 aWorldPos);
 	void destroyChunk();
+
+	// calls visit(offset, section) for every section whose faces a change of the block
+	// at blockPos may show or hide: the block's own and those it touches across a
+	// face, in this chunk (offset 0) or in the horizontal neighbour at chunk offset (x, z)
+	template<typename Visit>
+	static void forEachAffectedSection(glm::ivec3 blockPos, Visit&& visit);
+
+	// of every buildMesh so far, on any thread
+	static ChunkMeshStats getMeshStats();
+	static void reportMeshStats(std::ostream& out);
 private:
-	std::vector<Vertex> mMeshVertices;
-	std::vector<uint16_t> mMeshIndices;
+	// what prepareMesh took for buildMesh, pinned while the guard is
+	struct MeshInput
+	{
+		EpochGuard guard;
+		const ChunkVersion<Dims>* data = nullptr;
+		// indexed by BLOCKFACE, nullptr where no neighbour was linked
+		std::array<const ChunkVersion<Dims>*, BORDERMESHES> neighbours{};
+		uint32_t regions = 0;
+		std::bitset<Dims::SECTIONCOUNT> sections;
+	};
+
+	// retires the published version
+	void unpublish();
+	// the bands given by bit, from the pinned versions
+	uint32_t fillPaddedData(MeshScratch<Dims>& scratch, uint32_t bands);
+	// lays the region's sections out one after the other in a new buffer
+	MeshStats buildRegion(MeshScratch<Dims>& scratch, int region);
+	// rebuilds the marked sections of an uploaded region into its buffer, false when
+	// they do not fit it and the region has to be rebuilt whole
+	bool updateRegion(MeshScratch<Dims>& scratch, int region, const std::bitset<Dims::SECTIONCOUNT>& sections, MeshStats& stats);
+	void uploadRegion(int region);
+	void destroyMesh(ChunkMesh& mesh);
+private:
+	std::array<ChunkMesh, MESHREGIONS> mMeshes;
+	std::array<PendingMesh, MESHREGIONS> mPending;
+	MESHINGMODE mMeshingMode = GREEDY;
+	bool mMeshed = false;
+	// bit per region that the next prepareMesh takes to rebuild, and per section to
+	// rebuild in the other regions
+	uint32_t mDirtyRegions = ALLREGIONS;
+	std::bitset<Dims::SECTIONCOUNT> mDirtySections;
+	MeshInput mInput;
+	// the sections' spans in the uploaded meshes, and in the pending ones
+	std::array<std::array<MeshSpan, Dims::SECTIONCOUNT>, MESHREGIONS> mSpans{};
+	std::array<std::array<MeshSpan, Dims::SECTIONCOUNT>, MESHREGIONS> mPendingSpans{};
+
+	// horizontal neighbours indexed by BLOCKFACE, nullptr when not loaded
+	std::array<BasicChunk*, BORDERMESHES> mNeighbours{};
 	glm::ivec2 mWorldPosition;
-	ChunkData mData;
-
-	VkBuffer mVertexBuffer;
-	VkDeviceMemory mVertexBufferMemory;
-	
-	VkBuffer mIndexBuffer;
-	VkDeviceMemory mIndexBufferMemory;
-};
\ No newline at end of file
+	BasicChunkData<Dims> mData;
+
+	// written by the render thread only, loaded by any
+	std::atomic<const ChunkVersion<Dims>*> mPublished{ nullptr };
+	uint64_t mVersion = 0;
+	// sections changed since the published version
+	std::bitset<Dims::SECTIONCOUNT> mUnpublished;
+};
+
+template<typename Dims>
+template<typename Visit>
+void BasicChunk<Dims>::forEachAffectedSection(glm::ivec3 blockPos, Visit&& visit)
+{
+	const glm::ivec3 section = blockPos / static_cast<int>(SECTIONSIZE);
+	visit(glm::ivec2(0), Dims::sectionIndex(section.x, section.y, section.z));
+
+	// a block on the face of its section borders the section beyond that face
+	const int sectionCounts[3] = { Dims::SECTIONSXZ, Dims::SECTIONSY, Dims::SECTIONSXZ };
+	for (int axis = 0; axis < 3; axis++)
+	{
+		const int local = blockPos[axis] % SECTIONSIZE;
+		const int step = local == 0 ? -1 : local == SECTIONSIZE - 1 ? 1 : 0;
+		if (step == 0) continue;
+
+		glm::ivec3 next = section;
+		next[axis] += step;
+		glm::ivec2 offset(0);
+		if (next[axis] < 0 || next[axis] >= sectionCounts[axis])
+		{
+			// nothing above or below the world
+			if (axis == 1) continue;
+			next[axis] -= step * sectionCounts[axis];
+			offset[axis / 2] = step;
+		}
+		visit(offset, Dims::sectionIndex(next.x, next.y, next.z));
+	}
+}
+
+// the world's shape and the alternatives kept compiling for benchmarks
+extern template class BasicChunkData<ChunkDimensions<16, 64>>;
+extern template class BasicChunkData<ChunkDimensions<16, 256>>;
+extern template class BasicChunkData<ChunkDimensions<32, 64>>;
+extern template class BasicChunkData<ChunkDimensions<32, 384>>;
+extern template class BasicChunk<ChunkDimensions<16, 64>>;
+extern template class BasicChunk<ChunkDimensions<16, 256>>;
+extern template class BasicChunk<ChunkDimensions<32, 64>>;
+extern template class BasicChunk<ChunkDimensions<32, 384>>;
+
+using ChunkData = BasicChunkData<WorldDimensions>;
+using Chunk = BasicChunk<WorldDimensions>;
\ No newline at end of file
@@ -0,0 +1,317 @@
+#include "WorldGenerator.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <vector>
+
+// Depths are fractions of the chunk height below its top, y grows downwards
+constexpr float WORLD_BASE_DEPTH = 0.55f;
+// surface height variation of each biome
+constexpr float WORLD_PLAINS_RELIEF = 0.05f;
+constexpr float WORLD_HILLS_RELIEF = 0.15f;
+constexpr float WORLD_MOUNTAIN_RELIEF = 0.4f;
+// mountain tops shallower than this are bare rock
+constexpr float WORLD_ROCK_DEPTH = 0.3f;
+// blocks kept clear above the highest peak and kept solid below the deepest valley
+constexpr int WORLD_MIN_DEPTH = 2;
+constexpr int WORLD_MIN_FLOOR = 8;
+constexpr int WORLD_DIRT_DEPTH = 3;
+// noise magnitude both cave fields must stay under for a block to be carved
+constexpr float WORLD_CAVE_WIDTH = 0.08f;
+// boulder sites tried per 16x16 blocks of chunk area, and the share of them kept per BIOME
+constexpr int WORLD_BOULDER_ATTEMPTS = 3;
+constexpr std::array<float, 3> WORLD_BOULDER_CHANCE = { 0.05f, 0.3f, 0.5f };
+constexpr float WORLD_BOULDER_MIN_RADIUS = 1.5f;
+constexpr float WORLD_BOULDER_MAX_RADIUS = 3.0f;
+static_assert(WORLD_BOULDER_MAX_RADIUS < SECTIONSIZE * GENERATION_MARGIN, "boulders may only reach into the neighbours decoration waits for");
+
+// avalanche hash of a chunk and an index, for placing features per chunk
+static uint32_t hashSite(uint32_t seed, glm::ivec2 chunk, int site)
+{
+	uint32_t hash = seed ^ static_cast<uint32_t>(chunk.x) * 0x8da6b343u ^ static_cast<uint32_t>(chunk.y) * 0xd8163841u ^ static_cast<uint32_t>(site) * 0xcb1ab31fu;
+	hash ^= hash >> 16;
+	hash *= 0x7feb352du;
+	hash ^= hash >> 15;
+	hash *= 0x846ca68bu;
+	hash ^= hash >> 16;
+	return hash;
+}
+
+static float smoothstep(float edge0, float edge1, float x)
+{
+	const float t = std::clamp((x - edge0) / (edge1 - edge0), 0.0f, 1.0f);
+	return t * t * (3.0f - 2.0f * t);
+}
+
+template<typename Dims>
+static uint8_t getColumnBlock(int y, int surface, uint8_t biome)
+{
+	constexpr int ROCKDEPTH = static_cast<int>(Dims::HEIGHT * WORLD_ROCK_DEPTH);
+
+	if (y < surface)
+		return AIR;
+	if (biome == BIOME_MOUNTAINS && surface < ROCKDEPTH)
+		return STONE;
+	if (y == surface)
+		return GRASS;
+	return y <= surface + WORLD_DIRT_DEPTH ? DIRT : STONE;
+}
+
+WorldGenerator::WorldGenerator(uint32_t seed)
+	:mSeed(seed)
+{
+	// every field gets its own seed so their features do not line up
+	mBiomeNoise.seed = seed;
+	mBiomeNoise.fractal = FRACTAL_FBM;
+	mBiomeNoise.frequency = 0.003f;
+	mBiomeNoise.octaves = 3;
+
+	mHillNoise.seed = seed + 0x9e3779b9u;
+	mHillNoise.fractal = FRACTAL_FBM;
+	mHillNoise.frequency = 0.012f;
+	mHillNoise.octaves = 5;
+
+	mMountainNoise.seed = seed + 2 * 0x9e3779b9u;
+	mMountainNoise.fractal = FRACTAL_RIDGED;
+	mMountainNoise.frequency = 0.008f;
+	mMountainNoise.octaves = 5;
+
+	mCaveNoiseA.seed = seed + 3 * 0x9e3779b9u;
+	mCaveNoiseA.type = PERLIN;
+	mCaveNoiseA.frequency = 0.04f;
+
+	mCaveNoiseB = mCaveNoiseA;
+	mCaveNoiseB.seed = seed + 4 * 0x9e3779b9u;
+}
+
+template<typename Dims>
+void WorldGenerator::runStage(GENERATIONSTAGE stage, glm::ivec2 position, BasicChunkData<Dims>& data, const GenerationNeighbours<Dims>& neighbours) const
+{
+	const auto start = std::chrono::steady_clock::now();
+	switch (stage)
+	{
+	case STAGE_HEIGHTMAP:
+		generateHeightmap(position, data);
+		break;
+	case STAGE_TERRAIN:
+		generateTerrain(data);
+		break;
+	case STAGE_CAVES:
+		carveCaves(position, data);
+		break;
+	case STAGE_DECORATION:
+		decorate(position, data, neighbours);
+		break;
+	default:
+		break;
+	}
+
+	const uint64_t nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+	StageTimer& timer = mTimers[stage];
+	timer.runs.fetch_add(1, std::memory_order_relaxed);
+	timer.nanoseconds.fetch_add(nanoseconds, std::memory_order_relaxed);
+	uint64_t max = timer.maxNanoseconds.load(std::memory_order_relaxed);
+	while (nanoseconds > max && !timer.maxNanoseconds.compare_exchange_weak(max, nanoseconds, std::memory_order_relaxed)) {}
+}
+
+uint32_t WorldGenerator::getSeed() const
+{
+	return mSeed;
+}
+
+GenerationStageStats WorldGenerator::getStageStats(GENERATIONSTAGE stage) const
+{
+	const StageTimer& timer = mTimers[stage];
+	GenerationStageStats stats;
+	stats.runs = timer.runs.load(std::memory_order_relaxed);
+	stats.totalMs = timer.nanoseconds.load(std::memory_order_relaxed) / 1e6;
+	stats.maxMs = timer.maxNanoseconds.load(std::memory_order_relaxed) / 1e6;
+	return stats;
+}
+
+void WorldGenerator::reportStats(std::ostream& out) const
+{
+	out << "World generation, seed " << mSeed << ", noise " << getSimdLevelName(getNoiseSimdLevel()) << ":\n";
+	for (int stage = 0; stage < GENERATIONSTAGES; stage++)
+	{
+		const GenerationStageStats stats = getStageStats(static_cast<GENERATIONSTAGE>(stage));
+		out << "  " << std::left << std::setw(12) << GENERATIONSTAGEINFO[stage].name << std::right
+			<< std::setw(6) << stats.runs << " chunks, " << std::fixed << std::setprecision(3)
+			<< (stats.runs ? stats.totalMs / stats.runs : 0.0) << " ms average, " << stats.maxMs << " ms max\n";
+	}
+	out << std::flush;
+}
+
+template<typename Dims>
+void WorldGenerator::generateHeightmap(glm::ivec2 position, BasicChunkData<Dims>& data) const
+{
+	constexpr int COLUMNS = Dims::SIZE * Dims::SIZE;
+	std::array<float, COLUMNS> biomes, hills, mountains;
+	const glm::ivec2 origin = position * Dims::SIZE;
+	generateNoise2D(mBiomeNoise, origin, { Dims::SIZE, Dims::SIZE }, biomes.data());
+	generateNoise2D(mHillNoise, origin, { Dims::SIZE, Dims::SIZE }, hills.data());
+	generateNoise2D(mMountainNoise, origin, { Dims::SIZE, Dims::SIZE }, mountains.data());
+
+	for (int i = 0; i < COLUMNS; i++)
+	{
+		// the relief follows the biome noise smoothly, so biome borders have no cliffs
+		const float hillWeight = smoothstep(-0.4f, 0.1f, biomes[i]);
+		const float mountainWeight = smoothstep(0.1f, 0.5f, biomes[i]);
+		const float elevation = (WORLD_PLAINS_RELIEF + WORLD_HILLS_RELIEF * hillWeight) * hills[i]
+			+ WORLD_MOUNTAIN_RELIEF * mountainWeight * (mountains[i] * 0.5f + 0.5f);
+
+		const int surface = std::clamp(static_cast<int>(std::floor(Dims::HEIGHT * (WORLD_BASE_DEPTH - elevation))), WORLD_MIN_DEPTH, Dims::HEIGHT - WORLD_MIN_FLOOR);
+		const uint8_t biome = biomes[i] < -0.15f ? BIOME_PLAINS : biomes[i] < 0.3f ? BIOME_HILLS : BIOME_MOUNTAINS;
+		data.setColumn(i / Dims::SIZE, i % Dims::SIZE, surface, biome);
+	}
+}
+
+template<typename Dims>
+void WorldGenerator::generateTerrain(BasicChunkData<Dims>& data) const
+{
+	std::array<uint8_t, SECTIONVOLUME> voxels;
+	for (int sectionX = 0; sectionX < Dims::SECTIONSXZ; sectionX++)
+		for (int sectionZ = 0; sectionZ < Dims::SECTIONSXZ; sectionZ++)
+		{
+			const int baseX = sectionX * SECTIONSIZE;
+			const int baseZ = sectionZ * SECTIONSIZE;
+
+			int minSurface = Dims::HEIGHT;
+			int maxSurface = 0;
+			for (int x = 0; x < SECTIONSIZE; x++)
+				for (int z = 0; z < SECTIONSIZE; z++)
+				{
+					minSurface = std::min(minSurface, data.getSurface(baseX + x, baseZ + z));
+					maxSurface = std::max(maxSurface, data.getSurface(baseX + x, baseZ + z));
+				}
+
+			// sections wholly above or below the surface stay EMPTY or UNIFORM
+			for (int sectionY = 0; sectionY < Dims::SECTIONSY; sectionY++)
+			{
+				ChunkSection& section = data.getSection(sectionX, sectionY, sectionZ);
+				const int baseY = sectionY * SECTIONSIZE;
+				if (baseY + SECTIONSIZE <= minSurface)
+				{
+					section.fill(AIR);
+					continue;
+				}
+				if (baseY > maxSurface + WORLD_DIRT_DEPTH)
+				{
+					section.fill(STONE);
+					continue;
+				}
+
+				for (int x = 0; x < SECTIONSIZE; x++)
+					for (int z = 0; z < SECTIONSIZE; z++)
+					{
+						const int surface = data.getSurface(baseX + x, baseZ + z);
+						const uint8_t biome = data.getBiome(baseX + x, baseZ + z);
+						for (int y = 0; y < SECTIONSIZE; y++)
+							voxels[SectionLayout::index(x, y, z)] = getColumnBlock<Dims>(baseY + y, surface, biome);
+					}
+				section.assign(voxels.data());
+			}
+		}
+}
+
+template<typename Dims>
+void WorldGenerator::carveCaves(glm::ivec2 position, BasicChunkData<Dims>& data) const
+{
+	// from just below the shallowest surface down to the bottom layer, which stays solid
+	int top = Dims::HEIGHT;
+	for (int x = 0; x < Dims::SIZE; x++)
+		for (int z = 0; z < Dims::SIZE; z++)
+			top = std::min(top, data.getSurface(x, z) + 1);
+	const int depth = Dims::HEIGHT - 1 - top;
+	if (depth <= 0) return;
+
+	thread_local std::vector<float> caveA, caveB;
+	const glm::ivec3 origin(position.x * Dims::SIZE, top, position.y * Dims::SIZE);
+	const glm::ivec3 size(Dims::SIZE, depth, Dims::SIZE);
+	caveA.resize(static_cast<size_t>(size.x) * size.y * size.z);
+	caveB.resize(caveA.size());
+	generateNoise3D(mCaveNoiseA, origin, size, caveA.data());
+	generateNoise3D(mCaveNoiseB, origin, size, caveB.data());
+
+	std::array<uint8_t, SECTIONVOLUME> voxels;
+	uint8_t row[SECTIONSIZE];
+	for (int sectionX = 0; sectionX < Dims::SECTIONSXZ; sectionX++)
+		for (int sectionZ = 0; sectionZ < Dims::SECTIONSXZ; sectionZ++)
+			for (int sectionY = top / SECTIONSIZE; sectionY < Dims::SECTIONSY; sectionY++)
+			{
+				ChunkSection& section = data.getSection(sectionX, sectionY, sectionZ);
+				if (section.getType() == EMPTY) continue;
+
+				bool carved = false;
+				for (int x = 0; x < SECTIONSIZE; x++)
+					for (int y = 0; y < SECTIONSIZE; y++)
+					{
+						const int blockX = sectionX * SECTIONSIZE + x;
+						const int blockY = sectionY * SECTIONSIZE + y;
+						section.getRow(x, y, row);
+
+						for (int z = 0; z < SECTIONSIZE; z++)
+						{
+							const int blockZ = sectionZ * SECTIONSIZE + z;
+							uint8_t block = row[z];
+							if (block != AIR && blockY >= top && blockY < Dims::HEIGHT - 1 && blockY > data.getSurface(blockX, blockZ))
+							{
+								const size_t i = (static_cast<size_t>(blockX) * depth + (blockY - top)) * Dims::SIZE + blockZ;
+								if (std::fabs(caveA[i]) < WORLD_CAVE_WIDTH && std::fabs(caveB[i]) < WORLD_CAVE_WIDTH)
+								{
+									block = AIR;
+									carved = true;
+								}
+							}
+							voxels[SectionLayout::index(x, y, z)] = block;
+						}
+					}
+
+				if (carved)
+					section.assign(voxels.data());
+			}
+}
+
+template<typename Dims>
+void WorldGenerator::decorate(glm::ivec2 position, BasicChunkData<Dims>& data, const GenerationNeighbours<Dims>& neighbours) const
+{
+	// sites scale with the chunk area, so every shape gets the same boulder density
+	const int attempts = std::max(1, WORLD_BOULDER_ATTEMPTS * Dims::SIZE * Dims::SIZE / 256);
+
+	// boulders of the neighbours' sites that reach in are stamped here too, their
+	// own chunks stamp the part that falls inside them
+	for (int dx = -1; dx <= 1; dx++)
+		for (int dz = -1; dz <= 1; dz++)
+		{
+			const BasicChunkData<Dims>& source = *neighbours[getGenerationNeighbourIndex(dx, dz)];
+			const glm::ivec2 sourceChunk = position + glm::ivec2(dx, dz);
+
+			for (int site = 0; site < attempts; site++)
+			{
+				const uint32_t hash = hashSite(mSeed, sourceChunk, site);
+				const int siteX = hash % Dims::SIZE;
+				const int siteZ = hash / Dims::SIZE % Dims::SIZE;
+				if (((hash >> 16) & 0xFF) >= WORLD_BOULDER_CHANCE[source.getBiome(siteX, siteZ)] * 256.0f) continue;
+
+				const float radius = WORLD_BOULDER_MIN_RADIUS + (hash >> 24) / 255.0f * (WORLD_BOULDER_MAX_RADIUS - WORLD_BOULDER_MIN_RADIUS);
+				const int extent = static_cast<int>(radius);
+				// half buried, centred on the surface block
+				const glm::ivec3 centre(siteX + dx * Dims::SIZE, source.getSurface(siteX, siteZ), siteZ + dz * Dims::SIZE);
+
+				for (int x = std::max(centre.x - extent, 0); x <= std::min(centre.x + extent, Dims::SIZE - 1); x++)
+					for (int y = std::max(centre.y - extent, 0); y <= std::min(centre.y + extent, Dims::HEIGHT - 1); y++)
+						for (int z = std::max(centre.z - extent, 0); z <= std::min(centre.z + extent, Dims::SIZE - 1); z++)
+						{
+							const glm::ivec3 offset = glm::ivec3(x, y, z) - centre;
+							if (offset.x * offset.x + offset.y * offset.y + offset.z * offset.z > radius * radius) continue;
+							data.getSection(x / SECTIONSIZE, y / SECTIONSIZE, z / SECTIONSIZE).setBlock(x % SECTIONSIZE, y % SECTIONSIZE, z % SECTIONSIZE, STONE);
+						}
+			}
+		}
+}
+
+template void WorldGenerator::runStage<ChunkDimensions<16, 64>>(GENERATIONSTAGE, glm::ivec2, BasicChunkData<ChunkDimensions<16, 64>>&, const GenerationNeighbours<ChunkDimensions<16, 64>>&) const;
+template void WorldGenerator::runStage<ChunkDimensions<16, 256>>(GENERATIONSTAGE, glm::ivec2, BasicChunkData<ChunkDimensions<16, 256>>&, const GenerationNeighbours<ChunkDimensions<16, 256>>&) const;
+template void WorldGenerator::runStage<ChunkDimensions<32, 64>>(GENERATIONSTAGE, glm::ivec2, BasicChunkData<ChunkDimensions<32, 64>>&, const GenerationNeighbours<ChunkDimensions<32, 64>>&) const;
+template void WorldGenerator::runStage<ChunkDimensions<32, 384>>(GENERATIONSTAGE, glm::ivec2, BasicChunkData<ChunkDimensions<32, 384>>&, const GenerationNeighbours<ChunkDimensions<32, 384>>&) const;
\ No newline at end of file
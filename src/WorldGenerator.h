@@ -0,0 +1,118 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+#include <glm/glm.hpp>
+#include "World.h"
+#include "Noise.h"
+
+enum GENERATIONSTAGE {
+	STAGE_HEIGHTMAP,  // biome and surface depth per block column
+	STAGE_TERRAIN,    // stone, dirt and the surface block up to the surface
+	STAGE_CAVES,      // tunnels carved out below the surface
+	STAGE_DECORATION, // boulders, which may reach across chunk borders
+	GENERATIONSTAGES
+};
+
+enum BIOME : uint8_t {
+	BIOME_PLAINS,
+	BIOME_HILLS,
+	BIOME_MOUNTAINS
+};
+
+// What a stage needs from the chunks around it. A stage only ever writes its own
+// chunk, and reads from its neighbours only what their first neighbourStages stages
+// produced, which nothing changes afterwards. So stages of many chunks run in
+// parallel without locks once those neighbours have got that far.
+struct GenerationStageInfo
+{
+	const char* name;
+	// neighbours read, in chunks along x and z (including diagonals), 0 for none
+	int neighbourRadius;
+	// stages those neighbours must have completed
+	int neighbourStages;
+};
+
+constexpr std::array<GenerationStageInfo, GENERATIONSTAGES> GENERATIONSTAGEINFO = { {
+	{ "heightmap", 0, 0 },
+	{ "terrain", 0, 0 },
+	{ "caves", 0, 0 },
+	// boulders centred in a neighbour sit on its surface
+	{ "decoration", 1, STAGE_HEIGHTMAP + 1 },
+} };
+
+// chunks beyond the render distance that are loaded so the ones inside can complete
+constexpr int GENERATION_MARGIN = []
+{
+	int margin = 0;
+	for (const GenerationStageInfo& info : GENERATIONSTAGEINFO)
+		margin = info.neighbourRadius > margin ? info.neighbourRadius : margin;
+	return margin;
+}();
+constexpr int GENERATIONNEIGHBOURS = (2 * GENERATION_MARGIN + 1) * (2 * GENERATION_MARGIN + 1);
+
+// chunk offset (dx, dz), each in [-GENERATION_MARGIN, GENERATION_MARGIN], into GenerationNeighbours
+constexpr int getGenerationNeighbourIndex(int dx, int dz)
+{
+	return (dx + GENERATION_MARGIN) * (2 * GENERATION_MARGIN + 1) + (dz + GENERATION_MARGIN);
+}
+
+// the chunks around the one being generated, itself in the middle; only those within
+// the stage's radius need to be set
+template<typename Dims>
+using GenerationNeighbours = std::array<const BasicChunkData<Dims>*, GENERATIONNEIGHBOURS>;
+
+struct GenerationStageStats
+{
+	uint64_t runs = 0;
+	double totalMs = 0.0;
+	double maxMs = 0.0;
+};
+
+// Generates the world one stage at a time, deterministic from the seed: a chunk comes
+// out the same whenever and on whatever machine it is generated. Thread-safe, stages
+// of different chunks may run at the same time.
+class WorldGenerator
+{
+public:
+	WorldGenerator(uint32_t seed);
+
+	WorldGenerator(const WorldGenerator&) = delete;
+	WorldGenerator& operator=(const WorldGenerator&) = delete;
+
+	// runs stage on the chunk at position, which must have completed the stages before
+	// it, while its neighbours meet the stage's GenerationStageInfo
+	template<typename Dims>
+	void runStage(GENERATIONSTAGE stage, glm::ivec2 position, BasicChunkData<Dims>& data, const GenerationNeighbours<Dims>& neighbours) const;
+
+	uint32_t getSeed() const;
+	GenerationStageStats getStageStats(GENERATIONSTAGE stage) const;
+	void reportStats(std::ostream& out) const;
+private:
+	template<typename Dims>
+	void generateHeightmap(glm::ivec2 position, BasicChunkData<Dims>& data) const;
+	template<typename Dims>
+	void generateTerrain(BasicChunkData<Dims>& data) const;
+	template<typename Dims>
+	void carveCaves(glm::ivec2 position, BasicChunkData<Dims>& data) const;
+	template<typename Dims>
+	void decorate(glm::ivec2 position, BasicChunkData<Dims>& data, const GenerationNeighbours<Dims>& neighbours) const;
+private:
+	struct StageTimer
+	{
+		std::atomic<uint64_t> runs{ 0 };
+		std::atomic<uint64_t> nanoseconds{ 0 };
+		std::atomic<uint64_t> maxNanoseconds{ 0 };
+	};
+
+	uint32_t mSeed;
+	NoiseSettings mBiomeNoise;
+	NoiseSettings mHillNoise;
+	NoiseSettings mMountainNoise;
+	// tunnels run where both are close to 0
+	NoiseSettings mCaveNoiseA;
+	NoiseSettings mCaveNoiseB;
+
+	mutable std::array<StageTimer, GENERATIONSTAGES> mTimers;
+};
\ No newline at end of file
@@ -1,8 +1,71 @@
 #include "Game.h"
+#include "Benchmarks.h"
+#include "Tests.h"
 #include <iostream>
+#include <string>
 
-int main()
+int main(int argc, char** argv)
 {
+	if (argc > 1 && std::string(argv[1]) == "--test")
+	{
+		return runTests(std::cout) == 0 ? 0 : 1;
+	}
+	if (argc > 1 && std::string(argv[1]) == "--benchmark-layouts")
+	{
+		runLayoutBenchmarks(std::cout);
+		return 0;
+	}
+	if (argc > 1 && std::string(argv[1]) == "--benchmark-dimensions")
+	{
+		runChunkDimensionBenchmarks(std::cout);
+		return 0;
+	}
+	if (argc > 1 && std::string(argv[1]) == "--benchmark-regions")
+	{
+		runRegionBenchmarks(std::cout);
+		return 0;
+	}
+	if (argc > 1 && std::string(argv[1]) == "--benchmark-autosave")
+	{
+		runAutosaveBenchmarks(std::cout);
+		return 0;
+	}
+	if (argc > 1 && std::string(argv[1]) == "--benchmark-editlog")
+	{
+		runEditLogBenchmarks(std::cout);
+		return 0;
+	}
+	if (argc > 1 && std::string(argv[1]) == "--benchmark-remesh")
+	{
+		runRemeshBenchmarks(std::cout);
+		return 0;
+	}
+	if (argc > 1 && std::string(argv[1]) == "--benchmark-culling")
+	{
+		runCullingBenchmarks(std::cout);
+		return 0;
+	}
+	if (argc > 1 && std::string(argv[1]) == "--benchmark-versions")
+	{
+		runVersionBenchmarks(std::cout);
+		return 0;
+	}
+	if (argc > 1 && std::string(argv[1]) == "--benchmark-dedup")
+	{
+		runDedupBenchmarks(std::cout);
+		return 0;
+	}
+	if (argc > 1 && std::string(argv[1]) == "--benchmark-cache")
+	{
+		runCacheBenchmarks(std::cout);
+		return 0;
+	}
+	if (argc > 1 && std::string(argv[1]) == "--benchmark-noise")
+	{
+		runNoiseBenchmarks(std::cout);
+		return 0;
+	}
+
 	Game game = Game::getInstance();
 	try
 	{
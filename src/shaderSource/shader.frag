@@ -1,12 +1,16 @@
 #version 450
 
+const float ATLAS_TILE_SIZE = 0.1;
+
 layout(location = 0) in vec3 fragColor;
 layout(location = 1) in vec2 fragTexCoord;
+layout(location = 2) in vec2 fragTile;
 
 layout(binding = 1) uniform sampler2D texSampler;
 
 layout(location = 0) out vec4 outColor;
 void main()
 {
-	outColor = texture(texSampler, fragTexCoord);
+	// wrap inside the atlas tile so greedy quads repeat the texture per block
+	outColor = texture(texSampler, fragTile + fract(fragTexCoord) * ATLAS_TILE_SIZE);
 }
\ No newline at end of file
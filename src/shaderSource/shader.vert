@@ -1,11 +1,11 @@
 #version 450
 
-layout(location = 0) in vec3 inPos;
-layout(location = 1) in vec3 inColor;
-layout(location = 2) in vec2 inTexCoord;
+layout(location = 0) in uint inPosition;
+layout(location = 1) in uint inAttributes;
 
 layout(location = 0) out vec3 fragColor;
 layout(location = 1) out vec2 fragTexCoord;
+layout(location = 2) out vec2 fragTile;
 
 layout(binding = 0) uniform UniformBufferObject 
 {
@@ -14,9 +14,34 @@ layout(binding = 0) uniform UniformBufferObject
 	mat4 proj;
 } ubo;
 
+layout(push_constant) uniform ChunkPushConstants
+{
+	vec3 origin;
+} chunk;
+
+const float ATLAS_TILE_SIZE = 0.1;
+const uint ATLAS_TILES_PER_ROW = 10;
+
+// indexed by BLOCKFACE: FRONT, BACK, RIGHT, LEFT, TOP, BOTTOM
+const vec3 NORMALS[6] = vec3[](
+	vec3(0.0, 0.0, -1.0), vec3(0.0, 0.0, 1.0), vec3(1.0, 0.0, 0.0),
+	vec3(-1.0, 0.0, 0.0), vec3(0.0, -1.0, 0.0), vec3(0.0, 1.0, 0.0));
+// texture axes, must match FACEAXES in Mesher.cpp
+const vec3 UAXES[6] = vec3[](
+	vec3(1.0, 0.0, 0.0), vec3(-1.0, 0.0, 0.0), vec3(0.0, 0.0, -1.0),
+	vec3(0.0, 0.0, -1.0), vec3(1.0, 0.0, 0.0), vec3(1.0, 0.0, 0.0));
+const vec3 VAXES[6] = vec3[](
+	vec3(0.0, 1.0, 0.0), vec3(0.0, 1.0, 0.0), vec3(0.0, 1.0, 0.0),
+	vec3(0.0, 1.0, 0.0), vec3(0.0, 0.0, -1.0), vec3(0.0, 0.0, -1.0));
+
 void main()
 {
-	gl_Position = ubo.proj * ubo.view * ubo.model * vec4(inPos, 1.0);
-	fragColor = inColor;
-	fragTexCoord = inTexCoord;
+	vec3 localPos = vec3(inPosition & 0xFFu, inPosition >> 16, (inPosition >> 8) & 0xFFu);
+	uint face = inAttributes & 0x7u;
+	uint tile = (inAttributes >> 3) & 0xFFu;
+
+	gl_Position = ubo.proj * ubo.view * ubo.model * vec4(chunk.origin + localPos, 1.0);
+	fragColor = NORMALS[face];
+	fragTexCoord = vec2(dot(UAXES[face], localPos), dot(VAXES[face], localPos));
+	fragTile = vec2(tile % ATLAS_TILES_PER_ROW, tile / ATLAS_TILES_PER_ROW) * ATLAS_TILE_SIZE;
 }
\ No newline at end of file
@@ -3,46 +3,83 @@
 #include <vulkan/vulkan.h>
 #include <array>
 
-struct Vertex
+// Chunk mesh vertex packed into 8 bytes. Positions are chunk-local block corners,
+// texture coordinates and the normal are rebuilt in shader.vert from the face.
+struct ChunkVertex
 {
-	glm::vec3 xyz;
-	glm::vec3 rgb;
-	glm::vec2 uv;
+	uint32_t position;   // x: bits 0-7, z: bits 8-15, y: bits 16-31
+	uint32_t attributes; // face: bits 0-2, atlas tile: bits 3-10
+
+	static ChunkVertex pack(glm::ivec3 pos, uint32_t face, uint32_t tile)
+	{
+		ChunkVertex vertex;
+		vertex.position = static_cast<uint32_t>(pos.x) | static_cast<uint32_t>(pos.z) << 8 | static_cast<uint32_t>(pos.y) << 16;
+		vertex.attributes = face | tile << 3;
+		return vertex;
+	}
 
 	static VkVertexInputBindingDescription getBindingDescription()
 	{
 		VkVertexInputBindingDescription binding{};
 		binding.binding = 0;
 		binding.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
-		binding.stride = sizeof(Vertex);
+		binding.stride = sizeof(ChunkVertex);
 
 		return binding;
 	}
 
-	static std::array<VkVertexInputAttributeDescription, 3> getAttributeDescriptions()
+	static std::array<VkVertexInputAttributeDescription, 2> getAttributeDescriptions()
 	{
-		std::array<VkVertexInputAttributeDescription, 3> attributes{};
+		std::array<VkVertexInputAttributeDescription, 2> attributes{};
 		attributes[0].binding = 0;
-		attributes[0].format = VK_FORMAT_R32G32B32_SFLOAT;
+		attributes[0].format = VK_FORMAT_R32_UINT;
 		attributes[0].location = 0;
-		attributes[0].offset = offsetof(Vertex, xyz);
+		attributes[0].offset = offsetof(ChunkVertex, position);
 
 		attributes[1].binding = 0;
-		attributes[1].format = VK_FORMAT_R32G32B32_SFLOAT;
+		attributes[1].format = VK_FORMAT_R32_UINT;
 		attributes[1].location = 1;
-		attributes[1].offset = offsetof(Vertex, rgb);
-
-		attributes[2].binding = 0;
-		attributes[2].format = VK_FORMAT_R32G32_SFLOAT;
-		attributes[2].location = 2;
-		attributes[2].offset = offsetof(Vertex, uv);
+		attributes[1].offset = offsetof(ChunkVertex, attributes);
 		return attributes;
 	}
 };
+static_assert(sizeof(ChunkVertex) == 8, "ChunkVertex must stay 8 bytes");
+
+struct ChunkPushConstants
+{
+	glm::vec3 origin; // world position of the chunk's block (0,0,0)
+};
 
 struct MVP
 {
 	glm::mat4 model;
 	glm::mat4 view;
 	glm::mat4 proj;
+};
+
+// Host-visible upload buffer from GraphicsEngine's staging pool, persistently mapped.
+// capacity is the size class it was allocated for, 0 for buffers too big to pool
+struct StagingBuffer
+{
+	VkBuffer buffer = VK_NULL_HANDLE;
+	VkDeviceMemory memory = VK_NULL_HANDLE;
+	VkDeviceSize size = 0;
+	VkDeviceSize capacity = 0;
+	void* data = nullptr;
+};
+
+// Device-local buffer from GraphicsEngine's vertex buffer pool, capacity is the
+// size class it was allocated for and may exceed what was uploaded
+struct PooledBuffer
+{
+	VkBuffer buffer = VK_NULL_HANDLE;
+	VkDeviceMemory memory = VK_NULL_HANDLE;
+	VkDeviceSize capacity = 0;
+};
+
+// bytes offset to offset + size of a buffer
+struct BufferRange
+{
+	VkDeviceSize offset = 0;
+	VkDeviceSize size = 0;
 };
\ No newline at end of file